@@ -1,17 +1,33 @@
 #include <BandPass.h>
+#include <BiquadBank.h>
+#include <CarrierAnalysis.h>
+#include <CarrierCache.h>
+#include <FixedVocoderRT.h>
+#include <Kernels.h>
 #include <LowPass.h>
+#include <MultichannelVocoderRT.h>
+#include <MultirateVocoderRT.h>
+#include <SegmentedVocoder.h>
+#include <StateVariableBank.h>
 #include <Vocoder.h>
+#include <VocoderLPC.h>
+#include <VocoderSTFT.h>
 #include <WAVFile.h>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <memory>
 #include <string_view>
+#include <thread>
 
 namespace {
 
 int run_vocoder(int argc, char **argv);
 int run_lowpass(int argc, char **argv);
 int run_noop(int argc, char **argv);
+int run_cache(int argc, char **argv);
 int run_benchmark(int argc, char **argv);
 
 const struct {
@@ -19,18 +35,33 @@ const struct {
     char const *args;
     int (*run)(int argc, char **argv);
 } g_modes[]{
-    {"vocoder", "<distance> <bands> <signal> <modulator> <output>",
+    {"vocoder",
+     "<distance> <bands> <signal> <modulator> <output> [bands|lpc=<order>]",
      run_vocoder},
     {"lowpass", "<cutoff> <input> <output>", run_lowpass},
     {"noop", "<input> <output>", run_noop},
+    {"cache", "<bands> <carrier> <output>", run_cache},
     {"benchmark", "<input>", run_benchmark},
 };
 
+constexpr std::string_view k_kernels_flag = "--kernels=";
+
+// Threads to share offline work across.
+std::size_t num_threads() {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
 void usage(char const *name) {
     printf("Usage:\n");
     for (auto const &mode : g_modes) {
-        printf("  %s %s %s\n", name, mode.name, mode.args);
+        printf("  %s [%s<kernels>] %s %s\n", name, k_kernels_flag.data(),
+               mode.name, mode.args);
     }
+    printf("Available kernels:");
+    for (auto const *kernels : pwv::available_kernels()) {
+        printf(" %s", kernels->name);
+    }
+    printf("\n");
 }
 
 int run_vocoder(int argc, char **argv) {
@@ -46,19 +77,27 @@ int run_vocoder(int argc, char **argv) {
     char const *const signal_path = argv[4];
     char const *const carrier_path = argv[5];
     char const *const output_path = argv[6];
+    std::string_view const engine = argc > 7 ? argv[7] : "bands";
+    constexpr std::string_view k_lpc_prefix = "lpc=";
+    if (engine != "bands" && !engine.starts_with(k_lpc_prefix)) {
+        printf("Unknown engine: %s\n", argv[7]);
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
     printf(
         "Running with num_bands=%i, signal_path=%s, carrier_path=%s, "
         "output_path=%s\n",
         num_bands, signal_path, carrier_path, output_path);
 
-    // Read in the signals.
-    auto signal = pwv::load_wav(signal_path);
+    // Open the signals. They're streamed through a chunk at a time, so
+    // they can be any length.
+    auto signal = pwv::WAVReader::open(signal_path);
     if (!signal) {
         printf("Failed to load wav: %s - %s\n", signal_path,
                signal.error().c_str());
         return EXIT_FAILURE;
     }
-    auto carrier = pwv::load_wav(carrier_path);
+    auto carrier = pwv::WAVReader::open(carrier_path);
     if (!carrier) {
         printf("Failed to load wav: %s - %s\n", carrier_path,
                carrier.error().c_str());
@@ -66,23 +105,89 @@ int run_vocoder(int argc, char **argv) {
     }
 
     // Check that they're compatible.
-    if (signal->sampling_rate != carrier->sampling_rate) {
+    if (signal->sampling_rate() != carrier->sampling_rate()) {
         printf("Sampling rate mismatch\n");
         return EXIT_FAILURE;
     }
 
+    // Set up the filter.
+    std::unique_ptr<pwv::VocoderLPC> lpc;
+    std::unique_ptr<pwv::SegmentedVocoder> bands;
+    constexpr std::size_t k_chunk_size = pwv::Vocoder::k_chunk_size;
+    constexpr std::size_t k_max_segment_size = std::size_t(1) << 20;
+    if (engine.starts_with(k_lpc_prefix)) {
+        int const order = std::atoi(argv[7] + k_lpc_prefix.size());
+        if (order <= 0 ||
+            order > static_cast<int>(pwv::VocoderLPC::k_max_order)) {
+            printf("LPC order must be from 1 to %zu\n",
+                   pwv::VocoderLPC::k_max_order);
+            return EXIT_FAILURE;
+        }
+        lpc = std::make_unique<pwv::VocoderLPC>(order);
+    } else {
+        // Long inputs are cut into a segment per thread, each warmed up
+        // from a little before it starts. Short ones get smaller segments
+        // so that every thread still has some.
+        std::size_t const per_thread =
+            std::min(signal->num_samples(), carrier->num_samples()) /
+            num_threads();
+        std::size_t const segment_size =
+            std::clamp((per_thread / k_chunk_size + 1) * k_chunk_size,
+                       k_chunk_size, k_max_segment_size);
+        bands = std::make_unique<pwv::SegmentedVocoder>(
+            distance, num_bands, signal->sampling_rate(), num_threads(),
+            segment_size);
+        if (bands->pre_roll() < segment_size) {
+            printf("Segments of %zu samples with a pre-roll of %zu\n",
+                   segment_size, bands->pre_roll());
+        } else {
+            printf("Filters too slow to settle for segments, running whole\n");
+        }
+        bands->start();
+    }
+
+    auto output = pwv::WAVWriter::create(output_path, signal->sampling_rate());
+    if (!output) {
+        printf("Failed to save wav: %s - %s\n", output_path,
+               output.error().c_str());
+        return EXIT_FAILURE;
+    }
+
     // Run the filter on the data.
     std::size_t const num_samples =
-        std::min(signal->samples.size(), carrier->samples.size());
-    auto output = pwv::Vocoder(distance, num_bands, signal->sampling_rate)
-                      .process(std::span{signal->samples.data(), num_samples},
-                               std::span{carrier->samples.data(), num_samples});
+        std::min(signal->num_samples(), carrier->num_samples());
+    std::size_t const chunk_size = bands ? bands->max_count() : k_chunk_size;
+    std::vector<float> signal_chunk(chunk_size);
+    std::vector<float> carrier_chunk(chunk_size);
+    std::vector<float> output_chunk(chunk_size);
+    for (std::size_t start = 0; start < num_samples; start += chunk_size) {
+        std::size_t const count = std::min(num_samples - start, chunk_size);
+        auto const signal_read =
+            signal->read_samples(std::span{signal_chunk}.first(count));
+        auto const carrier_read =
+            carrier->read_samples(std::span{carrier_chunk}.first(count));
+        if (!signal_read || !carrier_read) {
+            printf("Failed to read wav: %s\n",
+                   (signal_read ? carrier_read : signal_read).error().c_str());
+            return EXIT_FAILURE;
+        }
+
+        if (lpc) {
+            lpc->process(signal_chunk.data(), carrier_chunk.data(), count,
+                         output_chunk.data());
+        } else {
+            bands->process(std::span{signal_chunk}.first(count),
+                           std::span{carrier_chunk}.first(count),
+                           std::span{output_chunk}.first(count));
+        }
+        if (!output->write_samples(std::span{output_chunk}.first(count))) {
+            printf("Failed to save wav: %s\n", output_path);
+            return EXIT_FAILURE;
+        }
+    }
 
     // Save it.
-    pwv::WAVData wav_out;
-    wav_out.sampling_rate = signal->sampling_rate;
-    wav_out.samples = std::move(output);
-    if (!pwv::save_wav(wav_out, output_path)) {
+    if (!output->finish()) {
         printf("Failed to save wav: %s\n", output_path);
         return EXIT_FAILURE;
     }
@@ -157,6 +262,41 @@ int run_noop(int argc, char **argv) {
     return EXIT_SUCCESS;
 }
 
+int run_cache(int argc, char **argv) {
+    if (argc < 5) {
+        printf("Not enough args to cache\n");
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Read off args.
+    int const num_bands = std::atoi(argv[2]);
+    char const *const carrier_path = argv[3];
+    char const *const output_path = argv[4];
+    printf("Running with num_bands=%i, carrier_path=%s, output_path=%s\n",
+           num_bands, carrier_path, output_path);
+
+    // Read in the carrier.
+    auto carrier = pwv::load_wav(carrier_path);
+    if (!carrier) {
+        printf("Failed to load wav: %s - %s\n", carrier_path,
+               carrier.error().c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Render its bands at its own rate.
+    auto const built = pwv::CarrierCache::build(
+        output_path, carrier->samples, num_bands, carrier->sampling_rate);
+    if (!built) {
+        printf("Failed to save cache: %s - %s\n", output_path,
+               built.error().c_str());
+        return EXIT_FAILURE;
+    }
+
+    printf("Success!\n");
+    return EXIT_SUCCESS;
+}
+
 int run_benchmark(int argc, char **argv) {
     if (argc < 3) {
         printf("Not enough args to benchmark\n");
@@ -166,7 +306,8 @@ int run_benchmark(int argc, char **argv) {
 
     // Read off args.
     char const *const input_path = argv[2];
-    printf("Running with input_path=%s\n", input_path);
+    printf("Running with input_path=%s, kernels=%s\n", input_path,
+           pwv::kernels().name);
 
     // Read in the input.
     auto input = pwv::load_wav(input_path);
@@ -175,6 +316,13 @@ int run_benchmark(int argc, char **argv) {
                input.error().c_str());
         return EXIT_FAILURE;
     }
+    // And as it is in the file, for the fixed point vocoder.
+    auto raw_input = pwv::load_wav_int16(input_path);
+    if (!raw_input) {
+        printf("Failed to load wav: %s - %s\n", input_path,
+               raw_input.error().c_str());
+        return EXIT_FAILURE;
+    }
 
     // Quick timer class.
     struct Timer {
@@ -222,6 +370,91 @@ int run_benchmark(int argc, char **argv) {
         }
     }
 
+    // Serial vs look-ahead kernels.
+    for (int cutoff_hz : {200, 1000, 2000}) {
+        pwv::SecondOrderFilter filter;
+        filter.reset(pwv::LowPass::coefs(input->sampling_rate, cutoff_hz));
+        auto signal_copy = input->samples;
+        {
+            Timer timer;
+            filter.process_serial(signal_copy);
+            log_result("Lowpass serial", cutoff_hz, timer.elapsed().count());
+        }
+        {
+            Timer timer;
+            filter.process_lookahead(signal_copy);
+            log_result("Lowpass lookahead", cutoff_hz,
+                       timer.elapsed().count());
+        }
+    }
+
+    // Biquads against state-variable filters, as they are and with the
+    // cutoff swept every chunk.
+    for (int cutoff_hz : {200, 1000, 2000}) {
+        for (auto topology : {pwv::FilterTopology::Biquad,
+                              pwv::FilterTopology::StateVariable}) {
+            char const *const topology_name =
+                topology == pwv::FilterTopology::Biquad ? "biquad" : "svf";
+            char name[64];
+            {
+                pwv::LowPass filter(input->sampling_rate, cutoff_hz, topology);
+                auto signal_copy = input->samples;
+                Timer timer;
+                filter.process(signal_copy);
+                snprintf(name, sizeof(name), "Lowpass %s static",
+                         topology_name);
+                log_result(name, cutoff_hz, timer.elapsed().count());
+            }
+            {
+                pwv::LowPass filter(input->sampling_rate, cutoff_hz, topology);
+                auto signal_copy = input->samples;
+                Timer timer;
+                for (std::size_t chunk_start = 0; chunk_start < num_samples;
+                     chunk_start += chunk_size) {
+                    double const lfo = std::sin(2 * M_PI * chunk_start /
+                                                input->sampling_rate);
+                    filter.ramp_to(input->sampling_rate,
+                                   cutoff_hz * (1 + 0.5 * lfo), chunk_size);
+                    filter.process(std::span{signal_copy}.subspan(
+                        chunk_start, chunk_size));
+                }
+                snprintf(name, sizeof(name), "Lowpass %s swept",
+                         topology_name);
+                log_result(name, cutoff_hz, timer.elapsed().count());
+            }
+        }
+    }
+
+    // Banks of band passes, each way.
+    for (int num_bands : {10, 40, 80}) {
+        auto const q =
+            pwv::BandPass::approximate_q(input->sampling_rate, num_bands);
+        pwv::BiquadBank biquads(num_bands);
+        pwv::StateVariableBank state_variables(num_bands);
+        for (int band = 0; band < num_bands; band++) {
+            double const hz = 100 + 100 * band;
+            biquads.reset(band,
+                          pwv::BandPass::coefs(input->sampling_rate, hz, q));
+            state_variables.reset(band, pwv::StateVariableFilter::bandpass(
+                                            input->sampling_rate, hz, q));
+        }
+        std::vector<float> block(pwv::BiquadBank::k_block_size *
+                                 biquads.stride());
+        auto run_bank = [&](auto &bank) {
+            Timer timer;
+            for (std::size_t start = 0; start < num_samples;
+                 start += pwv::BiquadBank::k_block_size) {
+                bank.process_block(
+                    std::span{input->samples}.subspan(
+                        start, pwv::BiquadBank::k_block_size),
+                    block);
+            }
+            return timer.elapsed().count();
+        };
+        log_result("BandPass biquad bank", num_bands, run_bank(biquads));
+        log_result("BandPass svf bank", num_bands, run_bank(state_variables));
+    }
+
     // Bandpass.
     for (int num_bands : {10, 40, 80}) {
         auto q = pwv::BandPass::approximate_q(input->sampling_rate, num_bands);
@@ -243,6 +476,33 @@ int run_benchmark(int argc, char **argv) {
         }
     }
 
+    // Runs a realtime vocoder over the input a chunk at a time.
+    auto run_rt = [&](pwv::IVocoderRT &filter, std::vector<float> &output) {
+        auto const &samples = input->samples;
+        output.resize(num_samples);
+        Timer timer;
+        for (std::size_t chunk_start = 0; chunk_start < num_samples;
+             chunk_start += chunk_size) {
+            filter.process(samples.data() + chunk_start,
+                           samples.data() + chunk_start, chunk_size,
+                           output.data() + chunk_start);
+        }
+        return timer.elapsed().count();
+    };
+
+    // RMS of the difference, relative to the RMS of |expected|.
+    auto relative_error = [](std::vector<float> const &expected,
+                             std::vector<float> const &actual) {
+        double error = 0;
+        double energy = 0;
+        for (std::size_t i = 0; i < expected.size(); i++) {
+            double const diff = actual[i] - expected[i];
+            error += diff * diff;
+            energy += expected[i] * expected[i];
+        }
+        return energy > 0 ? std::sqrt(error / energy) : 0;
+    };
+
     // Vocoder.
     for (int num_bands : {10, 40, 80}) {
         {
@@ -252,17 +512,332 @@ int run_benchmark(int argc, char **argv) {
             filter.process(signal_copy, signal_copy);
             log_result("Vocoder bulk", num_bands, timer.elapsed().count());
         }
+        {
+            pwv::Vocoder filter(20, num_bands, input->sampling_rate);
+            filter.set_num_threads(num_threads());
+            auto signal_copy = input->samples;
+            Timer timer;
+            filter.process(signal_copy, signal_copy);
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder bulk %zu threads",
+                     num_threads());
+            log_result(name, num_bands, timer.elapsed().count());
+        }
+        {
+            // Segments of a quarter of the clip, so that it splits up
+            // across up to four threads.
+            std::size_t const segment_size =
+                (input->samples.size() / 4 / pwv::Vocoder::k_chunk_size + 1) *
+                pwv::Vocoder::k_chunk_size;
+            pwv::SegmentedVocoder filter(20, num_bands, input->sampling_rate,
+                                         num_threads(), segment_size);
+            auto signal_copy = input->samples;
+            Timer timer;
+            filter.start();
+            for (std::size_t start = 0; start < signal_copy.size();
+                 start += filter.max_count()) {
+                std::span const chunk = std::span{signal_copy}.subspan(
+                    start, std::min(signal_copy.size() - start,
+                                    filter.max_count()));
+                filter.process(chunk, chunk, chunk);
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder segmented %zu threads",
+                     num_threads());
+            log_result(name, num_bands, timer.elapsed().count());
+        }
+        std::vector<float> rt_output;
+        {
+            pwv::VocoderRT filter(20, num_bands, input->sampling_rate);
+            log_result("Vocoder rt", num_bands, run_rt(filter, rt_output));
+        }
+        {
+            pwv::VocoderRT filter(20, num_bands, input->sampling_rate);
+            filter.set_fused(false);
+            std::vector<float> output;
+            log_result("Vocoder rt staged", num_bands, run_rt(filter, output));
+        }
+        {
+            pwv::MultirateVocoderRT filter(20, num_bands,
+                                           input->sampling_rate);
+            std::vector<float> output;
+            log_result("Vocoder multirate", num_bands, run_rt(filter, output));
+            printf("Vocoder multirate latency (%i):\t%zu samples\n",
+                   num_bands, filter.latency());
+        }
+
+        // Overlap-add over FFT frames. Shorter hops cost more.
+        for (std::size_t hop : {128, 256, 512}) {
+            pwv::VocoderSTFT filter(20, num_bands, input->sampling_rate, 1024,
+                                    hop);
+            std::vector<float> output;
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder stft hop %zu", hop);
+            log_result(name, num_bands, run_rt(filter, output));
+        }
+
+        // Envelope followers at a control rate, against every sample.
+        for (std::size_t step : {4, 16}) {
+            pwv::VocoderRT filter(20, num_bands, input->sampling_rate);
+            filter.set_envelope_step(step);
+            std::vector<float> output;
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder rt envelope/%zu", step);
+            log_result(name, num_bands, run_rt(filter, output));
+            printf("%s error (%i):\t%f\n", name, num_bands,
+                   relative_error(rt_output, output));
+        }
+
+        // Output stages gated off where there's next to nothing.
+        for (float level : {1e-5f, 1e-4f}) {
+            pwv::VocoderRT filter(20, num_bands, input->sampling_rate);
+            filter.set_band_gate(level);
+            std::vector<float> output;
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder rt gate %g", level);
+            log_result(name, num_bands, run_rt(filter, output));
+            printf("%s skipped (%i):\t%f\n", name, num_bands,
+                   filter.skipped_fraction());
+            printf("%s error (%i):\t%f\n", name, num_bands,
+                   relative_error(rt_output, output));
+        }
+
+        // The lowest bands in doubles, and every band, against which both
+        // are measured.
         {
             pwv::VocoderRT filter(20, num_bands, input->sampling_rate);
-            auto const &signal_copy = input->samples;
-            std::vector<float> output(signal_copy.size());
+            filter.set_precise_tolerance(0);
+            std::vector<float> precise_output;
+            log_result("Vocoder rt precise all", num_bands,
+                       run_rt(filter, precise_output));
+            printf("Vocoder rt error (%i):\t%f\n", num_bands,
+                   relative_error(precise_output, rt_output));
+
+            pwv::VocoderRT mixed(20, num_bands, input->sampling_rate);
+            mixed.set_precise_tolerance(pwv::VocoderRT::k_precise_tolerance);
+            std::vector<float> output;
+            log_result("Vocoder rt precise low", num_bands,
+                       run_rt(mixed, output));
+            printf("Vocoder rt precise low error (%i):\t%f\n", num_bands,
+                   relative_error(precise_output, output));
+
+            // Each fixed point policy, against doubles too, as floats are
+            // above.
+            auto run_policy = [&]<typename Policy>(char const *name) {
+                pwv::BasicVocoderRT<Policy> fixed(20, num_bands,
+                                                  input->sampling_rate);
+                std::vector<float> fixed_output;
+                log_result(name, num_bands, run_rt(fixed, fixed_output));
+                printf("%s error (%i):\t%f\n", name, num_bands,
+                       relative_error(precise_output, fixed_output));
+            };
+            run_policy.operator()<pwv::Q31Policy>("Vocoder rt q31");
+            run_policy.operator()<pwv::Q31Int16Policy>("Vocoder rt q31 int16");
+
+            // Straight from the file's 16 bit samples, with no conversion.
+            pwv::BasicVocoderRT<pwv::Q31Int16Policy> int16(
+                20, num_bands, input->sampling_rate);
+            std::vector<int16_t> int16_output(num_samples);
+            Timer timer;
+            for (std::size_t chunk_start = 0; chunk_start < num_samples;
+                 chunk_start += chunk_size) {
+                int16.process_samples(
+                    raw_input->samples.data() + chunk_start,
+                    raw_input->samples.data() + chunk_start, chunk_size,
+                    int16_output.data() + chunk_start);
+            }
+            log_result("Vocoder rt q31 int16 native", num_bands,
+                       timer.elapsed().count());
+        }
+    }
+
+    // A muted signal against the input as carrier, as when the mic is off:
+    // silence, and the input turned down to under the silence level.
+    for (float gain : {0.0f, 1e-5f}) {
+        std::vector<float> muted = input->samples;
+        for (float &sample : muted) {
+            sample *= gain;
+        }
+        for (float level : {0.0f, 1e-4f}) {
+            pwv::VocoderRT filter(20, 40, input->sampling_rate);
+            filter.set_silence_level(level);
+            std::vector<float> output(num_samples);
             Timer timer;
             for (std::size_t chunk_start = 0; chunk_start < num_samples;
                  chunk_start += chunk_size) {
-                filter.process(signal_copy.data(), signal_copy.data(),
-                               chunk_size, output.data());
+                filter.process(muted.data() + chunk_start,
+                               input->samples.data() + chunk_start,
+                               chunk_size, output.data() + chunk_start);
             }
-            log_result("Vocoder rt", num_bands, timer.elapsed().count());
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder rt muted %g level %g", gain,
+                     level);
+            log_result(name, 40, timer.elapsed().count());
+        }
+    }
+
+    // Linear prediction, against the "Vocoder rt" entries above. The speech
+    // order resolves formants about as well as 40 bands do.
+    std::size_t const speech_order =
+        pwv::VocoderLPC::speech_order(input->sampling_rate);
+    for (std::size_t order : {std::size_t{12}, std::size_t{24}, speech_order}) {
+        pwv::VocoderLPC filter(order);
+        std::vector<float> output;
+        log_result("Vocoder lpc order", static_cast<int>(order),
+                   run_rt(filter, output));
+    }
+
+    // Vocoder presets, against VocoderRT called with the same blocks.
+    for (auto const &preset : pwv::vocoder_presets()) {
+        auto const &signal_copy = input->samples;
+        std::vector<float> output(signal_copy.size());
+        std::size_t const preset_samples =
+            (num_samples / preset.block_size) * preset.block_size;
+        auto run_blocks = [&](pwv::IVocoderRT &filter) {
+            Timer timer;
+            for (std::size_t chunk_start = 0; chunk_start < preset_samples;
+                 chunk_start += preset.block_size) {
+                filter.process(signal_copy.data() + chunk_start,
+                               signal_copy.data() + chunk_start,
+                               preset.block_size, output.data() + chunk_start);
+            }
+            return timer.elapsed().count();
+        };
+        auto filter = pwv::make_vocoder_rt(preset.block_size, 20,
+                                           preset.max_bands,
+                                           input->sampling_rate);
+        pwv::VocoderRT rt(20, preset.max_bands, input->sampling_rate);
+        char name[64];
+        snprintf(name, sizeof(name), "Vocoder preset %zux%zu",
+                 preset.block_size, preset.max_bands);
+        log_result(name, preset.max_bands, run_blocks(*filter));
+        snprintf(name, sizeof(name), "Vocoder preset %zux%zu rt",
+                 preset.block_size, preset.max_bands);
+        log_result(name, preset.max_bands, run_blocks(rt));
+    }
+
+    // Stereo, against a mono vocoder per channel.
+    for (int num_bands : {10, 40, 80}) {
+        auto const &samples = input->samples;
+        std::vector<float> frames(num_samples * 2);
+        for (std::size_t i = 0; i < num_samples; i++) {
+            frames[2 * i] = frames[2 * i + 1] = samples[i];
+        }
+        {
+            pwv::MultichannelVocoderRT filter(20, num_bands,
+                                              input->sampling_rate, 2);
+            Timer timer;
+            for (std::size_t chunk_start = 0; chunk_start < num_samples;
+                 chunk_start += chunk_size) {
+                float *const chunk = frames.data() + 2 * chunk_start;
+                filter.process(chunk, samples.data() + chunk_start,
+                               chunk_size, chunk);
+            }
+            log_result("Vocoder rt stereo", num_bands,
+                       timer.elapsed().count());
+        }
+        {
+            pwv::VocoderRT left(20, num_bands, input->sampling_rate);
+            pwv::VocoderRT right(20, num_bands, input->sampling_rate);
+            std::vector<float> output(num_samples);
+            Timer timer;
+            for (std::size_t chunk_start = 0; chunk_start < num_samples;
+                 chunk_start += chunk_size) {
+                for (auto *filter : {&left, &right}) {
+                    filter->process(samples.data() + chunk_start,
+                                    samples.data() + chunk_start, chunk_size,
+                                    output.data() + chunk_start);
+                }
+            }
+            log_result("Vocoder rt 2x mono", num_bands,
+                       timer.elapsed().count());
+        }
+    }
+
+    // Several signals against one carrier, split into bands once for all of
+    // them, against each vocoder filtering it itself.
+    constexpr std::size_t k_num_shared = 4;
+    for (int num_bands : {10, 40, 80}) {
+        auto const &samples = input->samples;
+        std::vector<float> output(num_samples);
+        std::vector<std::unique_ptr<pwv::VocoderRT>> filters;
+        for (std::size_t i = 0; i < k_num_shared; i++) {
+            filters.push_back(std::make_unique<pwv::VocoderRT>(
+                20, num_bands, input->sampling_rate));
+        }
+        {
+            pwv::CarrierAnalysis analysis(num_bands, input->sampling_rate);
+            Timer timer;
+            for (std::size_t chunk_start = 0; chunk_start < num_samples;
+                 chunk_start += chunk_size) {
+                analysis.analyze(samples.data() + chunk_start, chunk_size);
+                for (auto const &filter : filters) {
+                    filter->process(samples.data() + chunk_start, analysis,
+                                    output.data() + chunk_start);
+                }
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder rt %zux shared carrier",
+                     k_num_shared);
+            log_result(name, num_bands, timer.elapsed().count());
+        }
+        {
+            Timer timer;
+            for (std::size_t chunk_start = 0; chunk_start < num_samples;
+                 chunk_start += chunk_size) {
+                for (auto const &filter : filters) {
+                    filter->process(samples.data() + chunk_start,
+                                    samples.data() + chunk_start, chunk_size,
+                                    output.data() + chunk_start);
+                }
+            }
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder rt %zux own carrier",
+                     k_num_shared);
+            log_result(name, num_bands, timer.elapsed().count());
+        }
+    }
+
+    // Bands split across threads inside each quantum, against one thread,
+    // to find where it starts to pay off. The helpers spin, so sharing a
+    // core with them says nothing.
+    auto run_rt_quanta = [&](pwv::VocoderRT &filter, std::size_t quantum) {
+        auto const &samples = input->samples;
+        std::vector<float> output(num_samples);
+        std::size_t const quantum_samples = (num_samples / quantum) * quantum;
+        Timer timer;
+        for (std::size_t chunk_start = 0; chunk_start < quantum_samples;
+             chunk_start += quantum) {
+            filter.process(samples.data() + chunk_start,
+                           samples.data() + chunk_start, quantum,
+                           output.data() + chunk_start);
+        }
+        return timer.elapsed().count();
+    };
+    std::size_t const rt_threads = num_threads();
+    if (rt_threads == 1) {
+        printf("Vocoder rt threads:\tskipped, only one core\n");
+    }
+    for (int num_bands : {40, 80, 160}) {
+        for (std::size_t quantum : {64, 256, 1024}) {
+            if (rt_threads == 1) {
+                continue;
+            }
+            pwv::VocoderRT serial(20, num_bands, input->sampling_rate);
+            double const serial_time = run_rt_quanta(serial, quantum);
+            pwv::VocoderRT threaded(20, num_bands, input->sampling_rate);
+            threaded.set_num_threads(rt_threads);
+            threaded.bind_threads();
+            double const threaded_time = run_rt_quanta(threaded, quantum);
+
+            char name[64];
+            snprintf(name, sizeof(name), "Vocoder rt quantum %zu", quantum);
+            log_result(name, num_bands, serial_time);
+            snprintf(name, sizeof(name), "Vocoder rt quantum %zu %zu threads",
+                     quantum, rt_threads);
+            log_result(name, num_bands, threaded_time);
+            printf("%s speedup (%i):\t%fx\n", name, num_bands,
+                   serial_time / threaded_time);
         }
     }
 
@@ -278,6 +853,23 @@ int main(int argc, char **argv) {
         return EXIT_FAILURE;
     }
 
+    // Force the kernels if asked, then drop the flag from the args.
+    std::string_view const flag = argv[1];
+    if (flag.starts_with(k_kernels_flag)) {
+        if (!pwv::select_kernels(flag.substr(k_kernels_flag.size()))) {
+            printf("Unavailable kernels: %s\n", argv[1]);
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+        if (argc < 2) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
     // Find the mode.
     std::string_view const opt = argv[1];
     for (auto const &mode : g_modes) {
@@ -4,13 +4,40 @@
 
 namespace pwv {
 
-BandPass::BandPass(double sampling_rate, double hz, double q) {
+BandPass::BandPass(double sampling_rate, double hz, double q,
+                   FilterTopology topology)
+    : m_topology(topology) {
     reset(sampling_rate, hz, q);
 }
 
 BandPass::~BandPass() {}
 
 void BandPass::reset(double sampling_rate, double hz, double q) {
+    if (m_topology == FilterTopology::StateVariable) {
+        m_state_variable.reset(
+            StateVariableFilter::bandpass(sampling_rate, hz, q));
+    } else {
+        m_filter.reset(coefs(sampling_rate, hz, q));
+    }
+}
+
+void BandPass::ramp_to(double sampling_rate, double hz, double q,
+                       std::size_t num_samples) {
+    if (m_topology == FilterTopology::StateVariable) {
+        m_state_variable.ramp_to(
+            StateVariableFilter::bandpass(sampling_rate, hz, q), num_samples);
+    } else {
+        m_filter.ramp_to(coefs(sampling_rate, hz, q), num_samples);
+    }
+}
+
+SecondOrderFilter::Coefs BandPass::coefs(double sampling_rate, double hz,
+                                         double q) {
+    return SecondOrderFilter::round(precise_coefs(sampling_rate, hz, q));
+}
+
+SecondOrderFilter::PreciseCoefs BandPass::precise_coefs(double sampling_rate,
+                                                        double hz, double q) {
     // BPF from https://www.w3.org/TR/audio-eq-cookbook
     double const omega = 2 * M_PI * hz / sampling_rate;
     // alpha seems incorrect as just /2Q from the cookbook.
@@ -23,7 +50,7 @@ void BandPass::reset(double sampling_rate, double hz, double q) {
     double const a1 = 2 * std::cos(omega) * inv_a0;
     double const a2 = -(1 - alpha) * inv_a0;
 
-    m_filter.reset(a1, a2, b0, b1, b2);
+    return {a1, a2, b0, b1, b2};
 }
 
 double BandPass::approximate_q(double sampling_rate, int num_bands) {
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "NumericPolicy.h"
 #include "SecondOrderFilter.h"
+#include "StateVariableFilter.h"
 
 namespace pwv {
 
@@ -9,18 +11,44 @@ class BandPass {
     static constexpr std::size_t k_block_size = SecondOrderFilter::k_block_size;
 
   public:
-    BandPass(double sampling_rate, double hz, double q);
+    BandPass(double sampling_rate, double hz, double q,
+             FilterTopology topology = FilterTopology::Biquad);
     ~BandPass();
     BandPass(BandPass&&) = default;
     BandPass& operator=(BandPass&&) = default;
 
     void reset(double sampling_rate, double hz, double q);
+    // Sweeps to the new centre over |num_samples|, see
+    // SecondOrderFilter::ramp_to().
+    void ramp_to(double sampling_rate, double hz, double q,
+                 std::size_t num_samples);
 
-    void process(std::span<float> input) { m_filter.process(input); }
+    void process(std::span<float> input) {
+        if (m_topology == FilterTopology::StateVariable) {
+            m_state_variable.process(input);
+        } else {
+            m_filter.process(input);
+        }
+    }
     void process_block(std::span<float> input) {
-        m_filter.process_block(input);
+        if (m_topology == FilterTopology::StateVariable) {
+            m_state_variable.process_block(input);
+        } else {
+            m_filter.process_block(input);
+        }
     }
 
+    static SecondOrderFilter::Coefs coefs(double sampling_rate, double hz,
+                                          double q);
+    static SecondOrderFilter::PreciseCoefs precise_coefs(double sampling_rate,
+                                                         double hz, double q);
+    // As coefs(), for a NumericPolicy.
+    template <typename Policy>
+    static typename Policy::Coefs coefs(double sampling_rate, double hz,
+                                        double q) {
+        return SecondOrderFilter::round<Policy>(
+            precise_coefs(sampling_rate, hz, q));
+    }
     static double approximate_q(double sampling_rate, int num_bands);
 
   private:
@@ -28,7 +56,9 @@ class BandPass {
     BandPass& operator=(BandPass const&) = delete;
 
   private:
+    FilterTopology m_topology;
     SecondOrderFilter m_filter;
+    StateVariableFilter m_state_variable;
 };
 
 }  // namespace pwv
@@ -0,0 +1,226 @@
+#include "BiquadBank.h"
+
+#include "Kernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace pwv {
+
+template <typename Policy>
+BasicBiquadBank<Policy>::BasicBiquadBank(std::size_t num_filters) {
+    resize(num_filters);
+}
+
+template <typename Policy>
+BasicBiquadBank<Policy>::~BasicBiquadBank() {}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::resize(std::size_t num_filters) {
+    m_num_filters = num_filters;
+    m_stride = pad_lanes(num_filters);
+
+    // Unused lanes have zero coefficients so they always output silence.
+    for (auto* array : {&m_a1, &m_a2, &m_b0, &m_b1, &m_b2}) {
+        array->assign(m_stride, 0);
+    }
+    for (auto* array : {&m_x1, &m_x2, &m_y1, &m_y2}) {
+        array->assign(m_stride, 0);
+    }
+    if constexpr (k_fixed) {
+        m_error.assign(m_stride, 0);
+    }
+    m_ramp_from.assign(m_stride, Coefs{});
+    m_ramp_to.assign(m_stride, Coefs{});
+    m_ramping.assign(m_stride, 0);
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::reset(std::size_t index, Coefs const& coefs) {
+    assert(index < m_num_filters);
+    m_a1[index] = coefs.a1;
+    m_a2[index] = coefs.a2;
+    m_b0[index] = coefs.b0;
+    m_b1[index] = coefs.b1;
+    m_b2[index] = coefs.b2;
+    m_ramping[index] = 0;
+
+    // Clear prior state.
+    m_x1[index] = m_x2[index] = 0;
+    m_y1[index] = m_y2[index] = 0;
+    if constexpr (k_fixed) {
+        m_error[index] = 0;
+    }
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::set_size(std::size_t num_filters) {
+    std::size_t const stride = pad_lanes(num_filters);
+    assert(stride <= m_a1.capacity());
+    for (auto* array : {&m_a1, &m_a2, &m_b0, &m_b1, &m_b2}) {
+        array->resize(stride);
+        std::fill(array->begin() + num_filters, array->end(), State{0});
+    }
+    for (auto* array : {&m_x1, &m_x2, &m_y1, &m_y2}) {
+        array->resize(stride);
+        std::fill(array->begin() + num_filters, array->end(), State{0});
+    }
+    if constexpr (k_fixed) {
+        m_error.resize(stride);
+        std::fill(m_error.begin() + num_filters, m_error.end(), 0);
+    }
+    m_ramping.resize(stride);
+    std::fill(m_ramping.begin() + num_filters, m_ramping.end(), 0);
+    m_num_filters = num_filters;
+    m_stride = stride;
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::set_coefs(std::size_t index,
+                                        Coefs const& coefs) {
+    assert(index < m_num_filters);
+    m_a1[index] = coefs.a1;
+    m_a2[index] = coefs.a2;
+    m_b0[index] = coefs.b0;
+    m_b1[index] = coefs.b1;
+    m_b2[index] = coefs.b2;
+    m_ramping[index] = 0;
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::ramp_to(std::size_t index, Coefs const& coefs) {
+    assert(index < m_num_filters);
+    m_ramp_from[index] = {m_a1[index], m_a2[index], m_b0[index], m_b1[index],
+                          m_b2[index]};
+    m_ramp_to[index] = coefs;
+    m_ramping[index] = 1;
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::step_ramp(std::size_t step,
+                                        std::size_t num_steps) {
+    assert(step != 0 && step <= num_steps);
+    // Worked out afresh from the start each step, so that the last one lands
+    // right on the target and a ramp to where it already is stays put.
+    auto const lerp = [&](Coef from, Coef to) {
+        if constexpr (k_fixed) {
+            return static_cast<Coef>(
+                from + std::llround((static_cast<double>(to) - from) *
+                                    static_cast<double>(step) /
+                                    static_cast<double>(num_steps)));
+        } else {
+            Coef const t =
+                static_cast<Coef>(step) / static_cast<Coef>(num_steps);
+            return from + (to - from) * t;
+        }
+    };
+    for (std::size_t index = 0; index < m_num_filters; index++) {
+        if (!m_ramping[index]) {
+            continue;
+        }
+        Coefs const& from = m_ramp_from[index];
+        Coefs const& to = m_ramp_to[index];
+        if (step == num_steps) {
+            set_coefs(index, to);
+            continue;
+        }
+        m_a1[index] = lerp(from.a1, to.a1);
+        m_a2[index] = lerp(from.a2, to.a2);
+        m_b0[index] = lerp(from.b0, to.b0);
+        m_b1[index] = lerp(from.b1, to.b1);
+        m_b2[index] = lerp(from.b2, to.b2);
+    }
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::clear() {
+    for (auto* array : {&m_x1, &m_x2, &m_y1, &m_y2}) {
+        std::fill(array->begin(), array->end(), State{0});
+    }
+    std::fill(m_error.begin(), m_error.end(), 0);
+}
+
+template <typename Policy>
+typename BasicBiquadBank<Policy>::State BasicBiquadBank<Policy>::peak_state()
+    const {
+    State peak = 0;
+    for (auto const* array : {&m_x1, &m_x2, &m_y1, &m_y2}) {
+        for (State const value : *array) {
+            if constexpr (k_fixed) {
+                peak = std::max(peak, Policy::abs(value));
+            } else {
+                peak = std::max(peak, std::abs(value));
+            }
+        }
+    }
+    return peak;
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::skip(std::span<float const> input)
+    requires(!k_fixed)
+{
+    for (std::size_t index = 0; index < m_num_filters; index++) {
+        Coef const a1 = m_a1[index], a2 = m_a2[index], b0 = m_b0[index],
+                   b1 = m_b1[index], b2 = m_b2[index];
+        State x1 = m_x1[index], x2 = m_x2[index];
+        State y1 = m_y1[index], y2 = m_y2[index];
+        for (float const sample : input) {
+            State const x = sample;
+            State y = b0 * x;
+            y += b1 * x1;
+            y += b2 * x2;
+            y += a1 * y1;
+            y += a2 * y2;
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+        }
+        m_x1[index] = x1;
+        m_x2[index] = x2;
+        m_y1[index] = y1;
+        m_y2[index] = y2;
+    }
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::process_block(std::span<float> data)
+    requires k_float
+{
+    assert(data.size() % m_stride == 0);
+    assert(data.size() <= k_block_size * m_stride);
+    kernels().biquad_bank(refs(), data.data(), data.size() / m_stride);
+}
+
+template <typename Policy>
+void BasicBiquadBank<Policy>::process_block(std::span<float const> input,
+                                            std::span<float> output)
+    requires k_float
+{
+    assert(input.size() <= k_block_size);
+    assert(output.size() == input.size() * m_stride);
+    kernels().biquad_bank_split(refs(), input.data(), output.data(),
+                                input.size());
+}
+
+template <typename Policy>
+typename BasicBiquadBank<Policy>::Refs BasicBiquadBank<Policy>::refs() {
+    if constexpr (k_fixed) {
+        return {m_a1.data(), m_a2.data(), m_b0.data(), m_b1.data(),
+                m_b2.data(), m_x1.data(), m_x2.data(), m_y1.data(),
+                m_y2.data(), m_error.data(), m_stride};
+    } else {
+        return {m_a1.data(), m_a2.data(), m_b0.data(), m_b1.data(),
+                m_b2.data(), m_x1.data(), m_x2.data(), m_y1.data(),
+                m_y2.data(), m_stride};
+    }
+}
+
+template class BasicBiquadBank<FloatPolicy>;
+template class BasicBiquadBank<DoublePolicy>;
+template class BasicBiquadBank<Q31Policy>;
+template class BasicBiquadBank<Q31Int16Policy>;
+
+}  // namespace pwv
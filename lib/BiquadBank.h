@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Kernels.h"
+#include "NumericPolicy.h"
+#include "SecondOrderFilter.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace pwv {
+
+// A bank of independent second order filters stored as a structure of arrays,
+// so that neighbouring filters can be run together in SIMD lanes. In the
+// arithmetic of a NumericPolicy, for the kernels that take its refs():
+// BiquadBankRefs for floats, PreciseBankRefs for doubles and
+// FixedPointBankRefs for fixed point.
+//
+// Blocks are laid out sample-major: sample i of filter f lives at
+// data[i * stride() + f].
+template <typename Policy>
+class BasicBiquadBank {
+    static constexpr bool k_float = std::is_same_v<Policy, FloatPolicy>;
+    static constexpr bool k_fixed = std::is_integral_v<typename Policy::State>;
+
+  public:
+    using Coef = typename Policy::Coef;
+    using State = typename Policy::State;
+    using Coefs = typename Policy::Coefs;
+    using Refs = std::conditional_t<
+        k_float, BiquadBankRefs,
+        std::conditional_t<k_fixed, FixedPointBankRefs, PreciseBankRefs>>;
+    static constexpr std::size_t k_block_size = SecondOrderFilter::k_block_size;
+
+  public:
+    explicit BasicBiquadBank(std::size_t num_filters = 0);
+    ~BasicBiquadBank();
+    BasicBiquadBank(BasicBiquadBank&&) = default;
+    BasicBiquadBank& operator=(BasicBiquadBank&&) = default;
+
+    void resize(std::size_t num_filters);
+    void reset(std::size_t index, Coefs const& coefs);
+    // Changes the number of filters without allocating, up to the most it
+    // has been resized to. Those that stay keep their coefficients and
+    // state, and the rest are silenced.
+    void set_size(std::size_t num_filters);
+    // As reset(), but keeps the filter's state, to retune it while running.
+    void set_coefs(std::size_t index, Coefs const& coefs);
+    // As set_coefs(), but only heads for |coefs|, from wherever the filter's
+    // are now, as step_ramp() moves it along.
+    void ramp_to(std::size_t index, Coefs const& coefs);
+    // Moves every filter heading somewhere |step| of |num_steps| of the way
+    // there, and lets go of them on the last step. Each step's coefficients
+    // lie between two stable filters, so they're stable too.
+    void step_ramp(std::size_t step, std::size_t num_steps);
+    // Clears every filter's state, keeping its coefficients.
+    void clear();
+    // Largest magnitude held in any filter's state.
+    State peak_state() const;
+    // Runs every filter over |input| for the state alone, as while there's
+    // no call for the output. Plain loops, a filter at a time.
+    void skip(std::span<float const> input)
+        requires(!k_fixed);
+
+    std::size_t size() const { return m_num_filters; }
+    std::size_t stride() const { return m_stride; }
+
+    // Filter a block of up to k_block_size samples in place.
+    void process_block(std::span<float> data)
+        requires k_float;
+    // Feed the same block of samples into every filter.
+    void process_block(std::span<float const> input, std::span<float> output)
+        requires k_float;
+
+    Refs refs();
+
+  private:
+    BasicBiquadBank(BasicBiquadBank const&) = delete;
+    BasicBiquadBank& operator=(BasicBiquadBank const&) = delete;
+
+  private:
+    std::size_t m_num_filters = 0;
+    std::size_t m_stride = 0;
+    std::vector<Coef> m_a1, m_a2, m_b0, m_b1, m_b2;
+    std::vector<State> m_x1, m_x2;
+    std::vector<State> m_y1, m_y2;
+    // Fixed point only, see FixedPolicy::biquad().
+    std::vector<int32_t> m_error;
+
+    // Where each filter's ramp started and is headed, if it has one.
+    std::vector<Coefs> m_ramp_from, m_ramp_to;
+    std::vector<uint8_t> m_ramping;
+};
+
+extern template class BasicBiquadBank<FloatPolicy>;
+extern template class BasicBiquadBank<DoublePolicy>;
+extern template class BasicBiquadBank<Q31Policy>;
+extern template class BasicBiquadBank<Q31Int16Policy>;
+
+using BiquadBank = BasicBiquadBank<FloatPolicy>;
+// For the few bands whose poles sit so close to the unit circle that rounding
+// to floats throws their response off.
+using PreciseBiquadBank = BasicBiquadBank<DoublePolicy>;
+
+// As BiquadBank, but with the number of filters fixed at compile time and the
+// storage held inline.
+template <std::size_t NumFilters>
+class FixedBiquadBank {
+  public:
+    using Coefs = SecondOrderFilter::Coefs;
+    static constexpr std::size_t k_stride = pad_lanes(NumFilters);
+
+  public:
+    void reset(std::size_t index, Coefs const& coefs) {
+        assert(index < NumFilters);
+        m_a1[index] = coefs.a1;
+        m_a2[index] = coefs.a2;
+        m_b0[index] = coefs.b0;
+        m_b1[index] = coefs.b1;
+        m_b2[index] = coefs.b2;
+
+        // Clear prior state.
+        m_x1[index] = m_x2[index] = 0;
+        m_y1[index] = m_y2[index] = 0;
+    }
+
+    BiquadBankRefs refs() {
+        return {m_a1.data(), m_a2.data(), m_b0.data(), m_b1.data(),
+                m_b2.data(), m_x1.data(), m_x2.data(), m_y1.data(),
+                m_y2.data(), k_stride};
+    }
+
+  private:
+    // Unused lanes have zero coefficients so they always output silence.
+    using Lanes = std::array<float, k_stride>;
+    alignas(64) Lanes m_a1{}, m_a2{}, m_b0{}, m_b1{}, m_b2{};
+    alignas(64) Lanes m_x1{}, m_x2{};
+    alignas(64) Lanes m_y1{}, m_y2{};
+};
+
+}  // namespace pwv
@@ -0,0 +1,31 @@
+#include "CarrierAnalysis.h"
+
+#include "Denormals.h"
+#include "Kernels.h"
+#include "Vocoder.h"
+
+#include <cassert>
+
+namespace pwv {
+
+CarrierAnalysis::CarrierAnalysis(int num_bands, double sampling_rate)
+    : m_sampling_rate(sampling_rate), m_bandpass(num_bands) {
+    // Only the band passes matter, which don't depend on the distance.
+    auto const bands = vocoder_bands(1, num_bands, sampling_rate);
+    for (std::size_t band = 0; band < bands.size(); band++) {
+        m_bandpass.reset(band, bands[band].bandpass);
+    }
+    m_bands.resize(k_max_count * m_bandpass.stride());
+}
+
+CarrierAnalysis::~CarrierAnalysis() {}
+
+void CarrierAnalysis::analyze(float const* carrier, std::size_t count) {
+    FlushDenormals const flush_denormals;
+    assert(count <= k_max_count);
+    kernels().biquad_bank_split(m_bandpass.refs(), carrier, m_bands.data(),
+                                count);
+    m_count = count;
+}
+
+}  // namespace pwv
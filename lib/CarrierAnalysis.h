@@ -0,0 +1,46 @@
+#pragma once
+
+#include "BiquadBank.h"
+
+#include <vector>
+
+namespace pwv {
+
+// Splits a carrier into a vocoder's bands, for any number of VocoderRTs with
+// the same bands and rate to share. Each of them then skips its own carrier
+// filters.
+class CarrierAnalysis {
+  public:
+    // Samples analyzed at a time, at most. The bands of that many fit in L2
+    // for a few hundred of them.
+    static constexpr std::size_t k_max_count = 512;
+
+  public:
+    CarrierAnalysis(int num_bands, double sampling_rate);
+    ~CarrierAnalysis();
+
+    std::size_t num_bands() const { return m_bandpass.size(); }
+    double sampling_rate() const { return m_sampling_rate; }
+
+    // Splits the next |count| samples of carrier, replacing the last ones.
+    void analyze(float const* carrier, std::size_t count);
+
+    // Samples split by the last analyze().
+    std::size_t count() const { return m_count; }
+    // Sample-major, with stride() lanes per sample as in BiquadBank.
+    float const* bands() const { return m_bands.data(); }
+    std::size_t stride() const { return m_bandpass.stride(); }
+
+  private:
+    CarrierAnalysis(CarrierAnalysis const&) = delete;
+    CarrierAnalysis& operator=(CarrierAnalysis const&) = delete;
+
+  private:
+    double const m_sampling_rate;
+    // One lane per band.
+    BiquadBank m_bandpass;
+    std::vector<float> m_bands;
+    std::size_t m_count = 0;
+};
+
+}  // namespace pwv
@@ -0,0 +1,198 @@
+#include "CarrierCache.h"
+
+#include "BandPass.h"
+#include "CarrierAnalysis.h"
+#include "Kernels.h"
+#include "Vocoder.h"
+#include "WAVFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace pwv {
+
+namespace {
+
+constexpr char k_magic[8] = {'P', 'W', 'V', 'B', 'A', 'N', 'D', 'S'};
+
+// A whole cache line, so that the bands after it start on one.
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_bands;
+    double sampling_rate;
+    double q;
+    uint64_t carrier_hash;
+    uint64_t coefs_hash;
+    uint64_t num_samples;
+    uint64_t stride;
+};
+static_assert(sizeof(Header) == 64);
+
+// FNV-1a.
+uint64_t hash(void const* data, std::size_t size,
+              uint64_t result = 14695981039346656037ull) {
+    auto const* const bytes = static_cast<unsigned char const*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        result ^= bytes[i];
+        result *= 1099511628211ull;
+    }
+    return result;
+}
+
+}  // namespace
+
+CarrierCache::CarrierCache() {}
+
+CarrierCache::~CarrierCache() {
+    if (m_mapping != nullptr) {
+        munmap(m_mapping, m_mapping_size);
+    }
+}
+
+CarrierCache::CarrierCache(CarrierCache&& other) { *this = std::move(other); }
+
+CarrierCache& CarrierCache::operator=(CarrierCache&& other) {
+    std::swap(m_mapping, other.m_mapping);
+    std::swap(m_mapping_size, other.m_mapping_size);
+    std::swap(m_bands, other.m_bands);
+    std::swap(m_num_samples, other.m_num_samples);
+    std::swap(m_stride, other.m_stride);
+    return *this;
+}
+
+CarrierCache::Key CarrierCache::key(std::span<float const> carrier,
+                                    int num_bands, double sampling_rate) {
+    // The band passes don't depend on the distance.
+    uint64_t coefs_hash = hash(nullptr, 0);
+    for (auto const& band : vocoder_bands(1, num_bands, sampling_rate)) {
+        coefs_hash = hash(&band.bandpass, sizeof(band.bandpass), coefs_hash);
+    }
+    return {
+        sampling_rate,
+        static_cast<uint32_t>(num_bands),
+        BandPass::approximate_q(sampling_rate, num_bands),
+        hash(carrier.data(), carrier.size_bytes()),
+        coefs_hash,
+    };
+}
+
+std::expected<void, std::string> CarrierCache::build(
+    std::filesystem::path path, std::span<float const> carrier, int num_bands,
+    double sampling_rate) {
+    if (carrier.empty()) {
+        return std::unexpected("Empty carrier");
+    }
+    std::unique_ptr<FILE, int (*)(FILE*)> output(
+        fopen(path.string().c_str(), "wb"), fclose);
+    if (!output) {
+        return std::unexpected("Failed to create file");
+    }
+
+    Key const cache_key = key(carrier, num_bands, sampling_rate);
+    CarrierAnalysis analysis(num_bands, sampling_rate);
+    Header header{};
+    std::memcpy(header.magic, k_magic, sizeof(k_magic));
+    header.version = k_version;
+    header.num_bands = cache_key.num_bands;
+    header.sampling_rate = cache_key.sampling_rate;
+    header.q = cache_key.q;
+    header.carrier_hash = cache_key.carrier_hash;
+    header.coefs_hash = cache_key.coefs_hash;
+    header.num_samples = carrier.size();
+    header.stride = analysis.stride();
+    if (fwrite(&header, sizeof(header), 1, output.get()) != 1) {
+        return std::unexpected("Failed to write header");
+    }
+
+    // Warm the filters up on one loop, then save the next.
+    constexpr std::size_t k_chunk_size = CarrierAnalysis::k_max_count;
+    for (int pass = 0; pass < 2; pass++) {
+        for (std::size_t start = 0; start < carrier.size();
+             start += k_chunk_size) {
+            std::size_t const count =
+                std::min(carrier.size() - start, k_chunk_size);
+            analysis.analyze(carrier.data() + start, count);
+            std::size_t const size = count * analysis.stride();
+            if (pass == 1 &&
+                fwrite(analysis.bands(), sizeof(float), size, output.get()) !=
+                    size) {
+                return std::unexpected("Failed to write bands");
+            }
+        }
+    }
+
+    if (fclose(output.release()) != 0) {
+        return std::unexpected("Failed to write bands");
+    }
+    return {};
+}
+
+std::expected<CarrierCache, std::string> CarrierCache::open(
+    std::filesystem::path path, Key const& key) {
+    int const fd = ::open(path.string().c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::unexpected("Failed to open file");
+    }
+    struct stat info {};
+    if (fstat(fd, &info) != 0 ||
+        static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        return std::unexpected("Not a carrier cache");
+    }
+
+    // Read it all in now, so that the realtime thread doesn't fault on it.
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    std::size_t const size = info.st_size;
+    void* const mapping = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return std::unexpected("Failed to map file");
+    }
+    CarrierCache cache;
+    cache.m_mapping = mapping;
+    cache.m_mapping_size = size;
+
+    // Check that it's for this carrier and these bands.
+    Header header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, k_magic, sizeof(k_magic)) != 0) {
+        return std::unexpected("Not a carrier cache");
+    }
+    if (header.version != k_version) {
+        return std::unexpected("Stale cache: version " +
+                               std::to_string(header.version) +
+                               ", expected " + std::to_string(k_version));
+    }
+    Key const file_key{header.sampling_rate, header.num_bands, header.q,
+                       header.carrier_hash, header.coefs_hash};
+    if (file_key != key) {
+        return std::unexpected(
+            "Stale cache: built for another carrier, rate or bands");
+    }
+    std::size_t const row_size = header.stride * sizeof(float);
+    if (header.num_bands == 0 || header.stride != pad_lanes(header.num_bands) ||
+        header.num_samples == 0 || (size - sizeof(Header)) % row_size != 0 ||
+        (size - sizeof(Header)) / row_size != header.num_samples) {
+        return std::unexpected("Truncated cache");
+    }
+
+    cache.m_bands =
+        reinterpret_cast<float const*>(static_cast<char const*>(mapping) +
+                                       sizeof(Header));
+    cache.m_num_samples = header.num_samples;
+    cache.m_stride = header.stride;
+    return cache;
+}
+
+}  // namespace pwv
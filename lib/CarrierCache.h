@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace pwv {
+
+// A carrier split into a vocoder's bands ahead of time and saved to a file,
+// for a looping carrier that would otherwise be filtered again on every
+// pass. The file is memory-mapped, so the realtime path only reads it.
+//
+// It holds a float per band per sample, about 10 MB per second of carrier
+// at 60 bands. Streaming that in is bound by memory bandwidth and can take
+// longer than running the filters, so it only pays where cores are scarcer
+// than bandwidth.
+//
+// The bands are rendered over a second loop of the carrier, with the filters
+// warmed up by the first, so that playing it round again carries straight on.
+class CarrierCache {
+  public:
+    // What the bands depend on. A file made for another key is stale.
+    struct Key {
+        double sampling_rate;
+        uint32_t num_bands;
+        // Of the band passes.
+        double q;
+        // Of the carrier's samples.
+        uint64_t carrier_hash;
+        // Of the band passes' coefficients, which catches any change to how
+        // the bands are laid out.
+        uint64_t coefs_hash;
+
+        bool operator==(Key const&) const = default;
+    };
+
+    // Bumped whenever the layout of the file changes.
+    static constexpr uint32_t k_version = 1;
+
+  public:
+    ~CarrierCache();
+    CarrierCache(CarrierCache&&);
+    CarrierCache& operator=(CarrierCache&&);
+
+    static Key key(std::span<float const> carrier, int num_bands,
+                   double sampling_rate);
+
+    // Renders the bands of |carrier| into a new file at |path|.
+    static std::expected<void, std::string> build(
+        std::filesystem::path path, std::span<float const> carrier,
+        int num_bands, double sampling_rate);
+
+    // Maps the file at |path|, which has to have been built for |key|.
+    static std::expected<CarrierCache, std::string> open(
+        std::filesystem::path path, Key const& key);
+
+    std::size_t num_samples() const { return m_num_samples; }
+    // Sample-major, with stride() lanes per sample as in CarrierAnalysis.
+    float const* bands() const { return m_bands; }
+    std::size_t stride() const { return m_stride; }
+
+  private:
+    CarrierCache();
+    CarrierCache(CarrierCache const&) = delete;
+    CarrierCache& operator=(CarrierCache const&) = delete;
+
+  private:
+    void* m_mapping = nullptr;
+    std::size_t m_mapping_size = 0;
+    float const* m_bands = nullptr;
+    std::size_t m_num_samples = 0;
+    std::size_t m_stride = 0;
+};
+
+}  // namespace pwv
@@ -0,0 +1,46 @@
+#include "Denormals.h"
+
+namespace pwv {
+
+namespace {
+
+#if defined(__SSE__)
+// Flush to zero and denormals are zero, in MXCSR.
+constexpr uint64_t k_flush = 0x8040;
+
+uint64_t read_mode() { return __builtin_ia32_stmxcsr(); }
+void write_mode(uint64_t mode) { __builtin_ia32_ldmxcsr(mode); }
+#elif defined(__aarch64__)
+// Flush to zero in FPCR, which covers inputs as well.
+constexpr uint64_t k_flush = 1 << 24;
+
+uint64_t read_mode() {
+    uint64_t mode;
+    asm volatile("mrs %0, fpcr" : "=r"(mode));
+    return mode;
+}
+void write_mode(uint64_t mode) { asm volatile("msr fpcr, %0" : : "r"(mode)); }
+#else
+constexpr uint64_t k_flush = 0;
+
+uint64_t read_mode() { return 0; }
+void write_mode(uint64_t) {}
+#endif
+
+}  // namespace
+
+FlushDenormals::FlushDenormals() : m_saved(read_mode()) {
+    // Writing the mode can stall, so leave it be when it's already set.
+    if ((m_saved & k_flush) != k_flush) {
+        write_mode(m_saved | k_flush);
+        m_changed = true;
+    }
+}
+
+FlushDenormals::~FlushDenormals() {
+    if (m_changed) {
+        write_mode(m_saved);
+    }
+}
+
+}  // namespace pwv
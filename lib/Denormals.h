@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace pwv {
+
+// Flushes denormal floats to zero on the calling thread while in scope, and
+// puts the old mode back after. A filter ringing down into denormals runs
+// many times slower, just as its input goes quiet. The mode is per thread,
+// so each process() of the lib holds one, down to the single filters that
+// BandPass and LowPass wrap, as do the lib's own threads. The filter banks
+// are left to the vocoders that run them a block at a time.
+class FlushDenormals {
+  public:
+    FlushDenormals();
+    ~FlushDenormals();
+
+  private:
+    FlushDenormals(FlushDenormals const&) = delete;
+    FlushDenormals& operator=(FlushDenormals const&) = delete;
+
+  private:
+    uint64_t m_saved;
+    bool m_changed = false;
+};
+
+}  // namespace pwv
@@ -0,0 +1,63 @@
+#include "FFT.h"
+
+#include "Kernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace pwv {
+
+FFT::FFT(std::size_t size)
+    : m_size(size), m_scratch_re(size), m_scratch_im(size) {
+    assert(size != 0 && (size & (size - 1)) == 0);
+
+    // Pass k combines points into runs of n = size >> k.
+    for (std::size_t n = size; n > 1; n /= 2) {
+        for (std::size_t p = 0; p < n / 2; p++) {
+            double const angle = -2 * M_PI * p / n;
+            m_twiddle_re.push_back(static_cast<float>(std::cos(angle)));
+            m_twiddle_im.push_back(static_cast<float>(std::sin(angle)));
+        }
+    }
+}
+
+FFT::~FFT() {}
+
+void FFT::forward(std::span<float> re, std::span<float> im) {
+    assert(re.size() == m_size && im.size() == m_size);
+    Kernels const& kernels = pwv::kernels();
+
+    float* x_re = re.data();
+    float* x_im = im.data();
+    float* y_re = m_scratch_re.data();
+    float* y_im = m_scratch_im.data();
+    std::size_t offset = 0;
+    for (std::size_t half = m_size / 2, stride = 1; half != 0;
+         half /= 2, stride *= 2) {
+        kernels.fft_pass(x_re, x_im, y_re, y_im, m_twiddle_re.data() + offset,
+                         m_twiddle_im.data() + offset, half, stride);
+        offset += half;
+        std::swap(x_re, y_re);
+        std::swap(x_im, y_im);
+    }
+
+    // An odd number of passes leaves the result in the scratch space.
+    if (x_re != re.data()) {
+        std::copy_n(x_re, m_size, re.data());
+        std::copy_n(x_im, m_size, im.data());
+    }
+}
+
+void FFT::inverse(std::span<float> re, std::span<float> im) {
+    // Conjugate either side of the forward transform.
+    for (float& value : im) {
+        value = -value;
+    }
+    forward(re, im);
+    for (float& value : im) {
+        value = -value;
+    }
+}
+
+}  // namespace pwv
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+namespace pwv {
+
+// Complex FFT of a power of two size on split real and imaginary arrays.
+// Neither direction is scaled.
+class FFT {
+  public:
+    explicit FFT(std::size_t size);
+    ~FFT();
+    FFT(FFT&&) = default;
+    FFT& operator=(FFT&&) = default;
+
+    std::size_t size() const { return m_size; }
+
+    void forward(std::span<float> re, std::span<float> im);
+    void inverse(std::span<float> re, std::span<float> im);
+
+  private:
+    FFT(FFT const&) = delete;
+    FFT& operator=(FFT const&) = delete;
+
+  private:
+    std::size_t m_size;
+
+    // The twiddles for each pass in turn.
+    std::vector<float> m_twiddle_re;
+    std::vector<float> m_twiddle_im;
+
+    std::vector<float> m_scratch_re;
+    std::vector<float> m_scratch_im;
+};
+
+}  // namespace pwv
@@ -0,0 +1,95 @@
+#include "FixedVocoderRT.h"
+
+#include "Denormals.h"
+#include "Kernels.h"
+
+#include <cassert>
+
+namespace pwv {
+
+template <std::size_t BlockSize, std::size_t MaxBands>
+FixedVocoderRT<BlockSize, MaxBands>::FixedVocoderRT(double distance,
+                                                    int num_bands,
+                                                    double sampling_rate) {
+    assert(num_bands >= 0 && static_cast<std::size_t>(num_bands) <= MaxBands);
+
+    // Build the filters.
+    auto const bands = vocoder_bands(distance, num_bands, sampling_rate);
+    for (std::size_t band = 0; band < bands.size(); band++) {
+        m_signal_bandpass.reset(band, bands[band].bandpass);
+        m_carrier_bandpass.reset(band, bands[band].bandpass);
+        m_output_bandpass.reset(band, bands[band].bandpass);
+        m_envelope_lowpass.reset(band, bands[band].lowpass);
+    }
+}
+
+template <std::size_t BlockSize, std::size_t MaxBands>
+FixedVocoderRT<BlockSize, MaxBands>::~FixedVocoderRT() {}
+
+template <std::size_t BlockSize, std::size_t MaxBands>
+void FixedVocoderRT<BlockSize, MaxBands>::process(float const* signal,
+                                                  float const* carrier,
+                                                  std::size_t count,
+                                                  float* output) {
+    FlushDenormals const flush_denormals;
+    VocoderBankRefs const banks{
+        m_signal_bandpass.refs(), m_carrier_bandpass.refs(),
+        m_envelope_lowpass.refs(), m_output_bandpass.refs()};
+    kernels().vocoder(banks, signal, carrier, output, count, k_block_size, 1);
+
+    // Need to scale it up a bit.
+    for (std::size_t i = 0; i < count; i++) {
+        output[i] *= 50;
+    }
+}
+
+template class FixedVocoderRT<8, 40>;
+template class FixedVocoderRT<16, 40>;
+template class FixedVocoderRT<128, 80>;
+
+namespace {
+
+template <std::size_t BlockSize, std::size_t MaxBands>
+std::unique_ptr<IVocoderRT> make_preset(double distance, int num_bands,
+                                        double sampling_rate) {
+    return std::make_unique<FixedVocoderRT<BlockSize, MaxBands>>(
+        distance, num_bands, sampling_rate);
+}
+
+// Listed smallest first for each block size.
+struct {
+    VocoderPreset preset;
+    std::unique_ptr<IVocoderRT> (*make)(double distance, int num_bands,
+                                        double sampling_rate);
+} const g_presets[]{
+    {{8, 40}, make_preset<8, 40>},
+    {{16, 40}, make_preset<16, 40>},
+    {{128, 80}, make_preset<128, 80>},
+};
+
+}  // namespace
+
+std::span<VocoderPreset const> vocoder_presets() {
+    static std::vector<VocoderPreset> const presets = [] {
+        std::vector<VocoderPreset> presets;
+        for (auto const& entry : g_presets) {
+            presets.push_back(entry.preset);
+        }
+        return presets;
+    }();
+    return presets;
+}
+
+std::unique_ptr<IVocoderRT> make_vocoder_rt(std::size_t block_size,
+                                            double distance, int num_bands,
+                                            double sampling_rate) {
+    for (auto const& entry : g_presets) {
+        if (entry.preset.block_size == block_size &&
+            entry.preset.max_bands >= static_cast<std::size_t>(num_bands)) {
+            return entry.make(distance, num_bands, sampling_rate);
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace pwv
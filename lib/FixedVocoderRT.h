@@ -0,0 +1,70 @@
+#pragma once
+
+#include "BiquadBank.h"
+#include "Vocoder.h"
+
+#include <memory>
+#include <span>
+
+namespace pwv {
+
+// Realtime version with the block size and maximum number of bands fixed at
+// compile time, so that everything is sized up front and the loops have
+// constant trip counts. Each block runs through the fused kernel as a single
+// tile. It takes any count, as VocoderRT does, with whatever doesn't fill a
+// block run as one short tile at the end. Only the presets below are
+// instantiated.
+template <std::size_t BlockSize, std::size_t MaxBands>
+class FixedVocoderRT final : public IVocoderRT {
+  public:
+    static constexpr std::size_t k_block_size = BlockSize;
+    static constexpr std::size_t k_max_bands = MaxBands;
+
+  public:
+    FixedVocoderRT(double distance, int num_bands, double sampling_rate);
+    ~FixedVocoderRT() override;
+
+    std::size_t block_size() const override { return 1; }
+
+    void process(float const* signal, float const* carrier, std::size_t count,
+                 float* output) override;
+
+  private:
+    FixedVocoderRT(FixedVocoderRT const&) = delete;
+    FixedVocoderRT& operator=(FixedVocoderRT const&) = delete;
+
+  private:
+    using Bank = FixedBiquadBank<MaxBands>;
+
+    // One lane per band.
+    Bank m_signal_bandpass;
+    Bank m_carrier_bandpass;
+    Bank m_envelope_lowpass;
+    Bank m_output_bandpass;
+};
+
+extern template class FixedVocoderRT<8, 40>;
+extern template class FixedVocoderRT<16, 40>;
+extern template class FixedVocoderRT<128, 80>;
+
+struct VocoderPreset {
+    std::size_t block_size;
+    std::size_t max_bands;
+};
+
+// The instantiated presets, from low latency up to 128 sample blocks. Only
+// the ones that beat VocoderRT run on the same blocks are kept. That leaves
+// out an offline one: VocoderRT already runs long calls as 64 sample tiles
+// with constant trip counts, and a 256x80 preset was within 3% of it, inside
+// the noise. Offline renders are better off with Vocoder or
+// SegmentedVocoder, which spread the bands or the samples across threads.
+std::span<VocoderPreset const> vocoder_presets();
+
+// Makes the smallest preset with the given block size that fits |num_bands|,
+// or returns null if there isn't one. VocoderRT is as quick for any other
+// block size.
+std::unique_ptr<IVocoderRT> make_vocoder_rt(std::size_t block_size,
+                                            double distance, int num_bands,
+                                            double sampling_rate);
+
+}  // namespace pwv
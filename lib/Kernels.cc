@@ -0,0 +1,74 @@
+#include "Kernels.h"
+
+#include <atomic>
+#include <vector>
+
+namespace pwv {
+
+#define PWV_DECLARE_KERNELS(target) \
+    namespace target {              \
+    extern Kernels const k_kernels; \
+    }
+
+#if defined(PWV_KERNELS_X86)
+PWV_DECLARE_KERNELS(avx512)
+PWV_DECLARE_KERNELS(avx2)
+PWV_DECLARE_KERNELS(sse2)
+#else
+PWV_DECLARE_KERNELS(generic)
+#endif
+
+namespace {
+
+std::vector<Kernels const*> detect_kernels() {
+    std::vector<Kernels const*> available;
+#if defined(PWV_KERNELS_X86)
+    __builtin_cpu_init();
+    // Each variant needs everything it was compiled for (see
+    // lib/CMakeLists.txt), not just the headline extension: some CPUs have
+    // AVX-512F without VL.
+    bool const has_avx2 =
+        __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (has_avx2 && __builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512vl")) {
+        available.push_back(&avx512::k_kernels);
+    }
+    if (has_avx2) {
+        available.push_back(&avx2::k_kernels);
+    }
+    available.push_back(&sse2::k_kernels);
+#else
+    available.push_back(&generic::k_kernels);
+#endif
+    return available;
+}
+
+std::atomic<Kernels const*> g_kernels{nullptr};
+
+}  // namespace
+
+std::span<Kernels const* const> available_kernels() {
+    static std::vector<Kernels const*> const available = detect_kernels();
+    return available;
+}
+
+Kernels const& kernels() {
+    Kernels const* selected = g_kernels.load(std::memory_order_relaxed);
+    if (selected == nullptr) {
+        selected = available_kernels().front();
+        g_kernels.store(selected, std::memory_order_relaxed);
+    }
+    return *selected;
+}
+
+bool select_kernels(std::string_view name) {
+    for (Kernels const* candidate : available_kernels()) {
+        if (name == candidate->name) {
+            g_kernels.store(candidate, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace pwv
@@ -0,0 +1,280 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace pwv {
+
+// Per-lane storage is padded to the widest vector any variant uses so that the
+// layout doesn't depend on which one is running.
+static constexpr std::size_t k_max_lanes = 16;
+
+constexpr std::size_t pad_lanes(std::size_t count) {
+    return (count + k_max_lanes - 1) / k_max_lanes * k_max_lanes;
+}
+
+static constexpr std::size_t k_max_halfband_taps = 16;
+static constexpr std::size_t k_max_envelope_step = 16;
+static constexpr std::size_t k_max_channels = 8;
+
+// Number of outputs produced per step of the look-ahead kernel, and the
+// layout of its matrix, see SecondOrderFilter::build_lookahead(). Column
+// j < k_lookahead holds the contribution of input j to each output of a
+// step, followed by the contributions of the state.
+static constexpr std::size_t k_lookahead = 16;
+static constexpr std::size_t k_lookahead_x1 = k_lookahead + 0;
+static constexpr std::size_t k_lookahead_x2 = k_lookahead + 1;
+static constexpr std::size_t k_lookahead_y1 = k_lookahead + 2;
+static constexpr std::size_t k_lookahead_dy = k_lookahead + 3;
+static constexpr std::size_t k_lookahead_columns = k_lookahead + 4;
+
+// Fractional bits of the fixed point kernels' samples and state, which leaves
+// them room up to 16, and of their coefficients, up to 4.
+static constexpr int k_fixed_state_bits = 27;
+static constexpr int k_fixed_coef_bits = 29;
+
+// Views of a BiquadBank's arrays, each |stride| lanes long.
+struct BiquadBankRefs {
+    float const* a1;
+    float const* a2;
+    float const* b0;
+    float const* b1;
+    float const* b2;
+    float* x1;
+    float* x2;
+    float* y1;
+    float* y2;
+    std::size_t stride;
+};
+
+// As BiquadBankRefs, in doubles.
+struct PreciseBankRefs {
+    double const* a1;
+    double const* a2;
+    double const* b0;
+    double const* b1;
+    double const* b2;
+    double* x1;
+    double* x2;
+    double* y1;
+    double* y2;
+    std::size_t stride;
+};
+
+// Views of a StateVariableBank's arrays, each |stride| lanes long.
+struct StateVariableBankRefs {
+    float const* a1;
+    float const* a2;
+    float const* a3;
+    float const* m0;
+    float const* m1;
+    float const* m2;
+    float* ic1;
+    float* ic2;
+    std::size_t stride;
+};
+
+// As BiquadBankRefs, in fixed point. |error| holds what rounding left off
+// each filter's last output, to be fed back into its next.
+struct FixedPointBankRefs {
+    int32_t const* a1;
+    int32_t const* a2;
+    int32_t const* b0;
+    int32_t const* b1;
+    int32_t const* b2;
+    int32_t* x1;
+    int32_t* x2;
+    int32_t* y1;
+    int32_t* y2;
+    int32_t* error;
+    std::size_t stride;
+};
+
+// Lets a vocoder skip the output stage of a group of bands for a tile when
+// nothing going into or out of it reaches |level|. |active| holds a flag per
+// lane, kept from one call to the next. Off while it's null.
+struct BandGate {
+    float level;
+    uint8_t* active;
+};
+
+// The filter banks of a vocoder, one lane per band.
+struct VocoderBankRefs {
+    BiquadBankRefs signal_bandpass;
+    BiquadBankRefs carrier_bandpass;
+    BiquadBankRefs envelope_lowpass;
+    BiquadBankRefs output_bandpass;
+    BandGate gate{};
+};
+
+// As VocoderBankRefs, in fixed point.
+struct FixedPointVocoderBankRefs {
+    FixedPointBankRefs signal_bandpass;
+    FixedPointBankRefs carrier_bandpass;
+    FixedPointBankRefs envelope_lowpass;
+    FixedPointBankRefs output_bandpass;
+};
+
+// As VocoderBankRefs, in doubles.
+struct PreciseVocoderBankRefs {
+    PreciseBankRefs signal_bandpass;
+    PreciseBankRefs carrier_bandpass;
+    PreciseBankRefs envelope_lowpass;
+    PreciseBankRefs output_bandpass;
+};
+
+// The filter banks of a vocoder running several channels of signal against
+// one carrier, one lane per band. The arrays hold a bank per channel, and
+// only the first one's coefficients are read.
+struct MultichannelBankRefs {
+    BiquadBankRefs carrier_bandpass;
+    BiquadBankRefs const* signal_bandpass;
+    BiquadBankRefs const* envelope_lowpass;
+    BiquadBankRefs const* output_bandpass;
+    std::size_t num_channels;
+};
+
+// The hot loops, compiled once per instruction set (see KernelsTarget.cc).
+// Blocks are sample-major with |stride| lanes per sample.
+struct Kernels {
+    char const* name;
+
+    // Run a block of |block_size| samples through every filter in a bank.
+    void (*biquad_bank)(BiquadBankRefs const& bank, float* data,
+                        std::size_t block_size);
+    // As above, but feed the same samples into every filter.
+    void (*biquad_bank_split)(BiquadBankRefs const& bank, float const* input,
+                              float* output, std::size_t block_size);
+    // As above, for state-variable filters.
+    void (*state_variable_bank)(StateVariableBankRefs const& bank, float* data,
+                                std::size_t block_size);
+    void (*state_variable_bank_split)(StateVariableBankRefs const& bank,
+                                      float const* input, float* output,
+                                      std::size_t block_size);
+    // Run |count| samples through every stage of a vocoder, |tile_size|
+    // samples at a time per group of bands, and write the sum of the bands.
+    // Tiles longer than the target keeps on the stack are split up.
+    // The envelope followers run on the mean of each |envelope_step| rectified
+    // samples and are interpolated in between. It must be a power of two up
+    // to k_max_envelope_step. A tile it doesn't divide is stretched to a
+    // whole number of steps. If it doesn't divide |count|, the last step is
+    // a short one over what's left. Returns how
+    // many samples of a lane the gate skipped the output stage for, summed
+    // over the lanes.
+    std::size_t (*vocoder)(VocoderBankRefs const& banks, float const* signal,
+                           float const* carrier, float* output,
+                           std::size_t count, std::size_t tile_size,
+                           std::size_t envelope_step);
+    // As vocoder(), but with the carrier already split into bands as by
+    // biquad_bank_split(), |carrier_stride| lanes per sample. Lane l of
+    // |carrier_bands| goes with lane l of the banks, and
+    // banks.carrier_bandpass isn't used.
+    std::size_t (*vocoder_analyzed)(VocoderBankRefs const& banks,
+                                    float const* signal,
+                                    float const* carrier_bands,
+                                    std::size_t carrier_stride, float* output,
+                                    std::size_t count, std::size_t tile_size,
+                                    std::size_t envelope_step);
+    // As vocoder() with an envelope step of 1, over |num_frames| frames of
+    // up to k_max_channels interleaved channels of signal and output. The
+    // carrier is filtered once for every channel.
+    void (*vocoder_multichannel)(MultichannelBankRefs const& banks,
+                                 float const* signal, float const* carrier,
+                                 float* output, std::size_t num_frames);
+    // As above, with the carrier already split into bands as for
+    // vocoder_analyzed().
+    void (*vocoder_multichannel_analyzed)(MultichannelBankRefs const& banks,
+                                          float const* signal,
+                                          float const* carrier_bands,
+                                          std::size_t carrier_stride,
+                                          float* output,
+                                          std::size_t num_frames);
+    // As vocoder() with an envelope step of 1, in fixed point with 64 bit
+    // products that are rounded and saturated back to 32 bits, as
+    // FixedPolicy does (see NumericPolicy.h). Adds the sum of the bands to
+    // |output|, which doesn't round, so every variant gives the same result.
+    void (*vocoder_fixed_point)(FixedPointVocoderBankRefs const& banks,
+                                int32_t const* signal, int32_t const* carrier,
+                                int64_t* output, std::size_t count);
+    // As vocoder() with an envelope step of 1 and no gate, in doubles. Adds
+    // the sum of the bands times |gain| to |output|.
+    void (*vocoder_precise)(PreciseVocoderBankRefs const& banks,
+                            float const* signal, float const* carrier,
+                            float* output, std::size_t count, double gain);
+    // As above, with the carrier already split into bands in floats as for
+    // vocoder_analyzed().
+    void (*vocoder_precise_analyzed)(PreciseVocoderBankRefs const& banks,
+                                     float const* signal,
+                                     float const* carrier_bands,
+                                     std::size_t carrier_stride,
+                                     float* output, std::size_t count,
+                                     double gain);
+    // Run whole steps of k_lookahead samples of |data| through a look-ahead
+    // matrix of k_lookahead_columns columns, as SecondOrderFilter builds.
+    void (*lookahead)(float const* columns, float* x, float* y, float* data,
+                      std::size_t num_steps);
+
+    // Halfband filters given the (at most k_max_halfband_taps) taps an odd
+    // distance 1, 3, ... from the centre tap of 1/2. Halve the rate, writing
+    // |count| samples. |input| follows 4 * num_taps - 2 samples of history.
+    void (*halfband_decimate)(float const* taps, std::size_t num_taps,
+                              float const* input, float* output,
+                              std::size_t count);
+    // Double the rate, adding 2 * |count| samples to |output|. |input| follows
+    // 2 * num_taps - 1 samples of history.
+    void (*halfband_interpolate_add)(float const* taps, std::size_t num_taps,
+                                     float const* input, float* output,
+                                     std::size_t count);
+
+    // One radix-2 pass of FFT on split complex data, combining points
+    // |half| * |stride| apart using the |half| twiddles for this pass.
+    void (*fft_pass)(float const* x_re, float const* x_im, float* y_re,
+                     float* y_im, float const* twiddle_re,
+                     float const* twiddle_im, std::size_t half,
+                     std::size_t stride);
+
+    // Lattice filters of |order| stages over |count| samples. |state| holds
+    // each stage's backward error from the sample before.
+    //
+    // Inverse (all-zero) filter, turning |forward| and |backward| (both the
+    // input to start with) into the last stage's errors.
+    void (*lattice_inverse)(float const* reflection, float* state,
+                            std::size_t order, float* forward,
+                            float* backward, std::size_t count);
+    // All-pole filter, in place. This runs along the diagonals where every
+    // stage is for a different sample, so there are independent multiply-adds
+    // across samples instead of one chain per sample. The reflection
+    // coefficients and state are split into the even and odd stages, and the
+    // state has room for an unused stage past the last.
+    void (*lattice_all_pole)(float const* even_reflection,
+                             float const* odd_reflection, float* even_state,
+                             float* odd_state, std::size_t order, float* data,
+                             std::size_t count);
+
+    void (*abs)(float* data, std::size_t count);
+    void (*mul)(float* a, float const* b, std::size_t count);
+    void (*add)(float* a, float const* b, std::size_t count);
+    // Sum of a[i] * b[i].
+    float (*dot)(float const* a, float const* b, std::size_t count);
+    // output[i] = sum of the lanes of sample i.
+    void (*sum_lanes)(float const* block, std::size_t stride,
+                      std::size_t block_size, float* output);
+
+    void (*int16_to_float)(int16_t const* input, float* output,
+                           std::size_t count);
+    void (*float_to_int16)(float const* input, int16_t* output,
+                           std::size_t count);
+};
+
+// The variants this CPU can run, best first.
+std::span<Kernels const* const> available_kernels();
+
+// The variant in use. Picked on first use unless select_kernels() is called.
+Kernels const& kernels();
+
+// Force a variant by name. Returns false if it isn't available.
+bool select_kernels(std::string_view name);
+
+}  // namespace pwv
@@ -0,0 +1,1151 @@
+// Built once per instruction set with PWV_KERNEL_TARGET naming the variant.
+//
+// Anything inline that isn't in the per-target namespace could be emitted
+// with this target's instructions and then picked by the linker for every
+// other caller, so stick to builtins and plain loops in here.
+
+#include "Kernels.h"
+#include "Simd.h"
+
+#define PWV_STRINGIFY_(x) #x
+#define PWV_STRINGIFY(x) PWV_STRINGIFY_(x)
+
+namespace pwv::PWV_KERNEL_TARGET {
+
+namespace {
+
+using simd::Vec;
+
+// A single filter of a bank, held in registers.
+template <typename V, typename Refs>
+struct BasicBiquad {
+    V a1, a2, b0, b1, b2;
+    V x1, x2, y1, y2;
+
+    BasicBiquad(Refs const& bank, std::size_t lane)
+        : a1(simd::load(bank.a1 + lane)),
+          a2(simd::load(bank.a2 + lane)),
+          b0(simd::load(bank.b0 + lane)),
+          b1(simd::load(bank.b1 + lane)),
+          b2(simd::load(bank.b2 + lane)),
+          x1(simd::load(bank.x1 + lane)),
+          x2(simd::load(bank.x2 + lane)),
+          y1(simd::load(bank.y1 + lane)),
+          y2(simd::load(bank.y2 + lane)) {}
+
+    void save(Refs const& bank, std::size_t lane) const {
+        simd::store(bank.x1 + lane, x1);
+        simd::store(bank.x2 + lane, x2);
+        simd::store(bank.y1 + lane, y1);
+        simd::store(bank.y2 + lane, y2);
+    }
+
+    // Same accumulation order as SecondOrderFilter.
+    V operator()(V x) {
+        V y = b0 * x;
+        y += b1 * x1;
+        y += b2 * x2;
+        y += a1 * y1;
+        y += a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+};
+
+using Biquad = BasicBiquad<Vec, BiquadBankRefs>;
+using PreciseBiquad = BasicBiquad<simd::DVec, PreciseBankRefs>;
+
+// A single state-variable filter of a bank, held in registers.
+struct StateVariable {
+    Vec a1, a2, a3, m0, m1, m2;
+    Vec ic1, ic2;
+
+    StateVariable(StateVariableBankRefs const& bank, std::size_t lane)
+        : a1(simd::load(bank.a1 + lane)),
+          a2(simd::load(bank.a2 + lane)),
+          a3(simd::load(bank.a3 + lane)),
+          m0(simd::load(bank.m0 + lane)),
+          m1(simd::load(bank.m1 + lane)),
+          m2(simd::load(bank.m2 + lane)),
+          ic1(simd::load(bank.ic1 + lane)),
+          ic2(simd::load(bank.ic2 + lane)) {}
+
+    void save(StateVariableBankRefs const& bank, std::size_t lane) const {
+        simd::store(bank.ic1 + lane, ic1);
+        simd::store(bank.ic2 + lane, ic2);
+    }
+
+    // Same order as StateVariableFilter.
+    Vec operator()(Vec v0) {
+        Vec const v3 = v0 - ic2;
+        Vec const v1 = a1 * ic1 + a2 * v3;
+        Vec const v2 = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = 2.0f * v1 - ic1;
+        ic2 = 2.0f * v2 - ic2;
+        return m0 * v0 + m1 * v1 + m2 * v2;
+    }
+};
+
+// Gives the compiler a constant trip count for the preset block sizes (see
+// FixedVocoderRT.h). Anything else runs with BlockSize == 0.
+template <typename Func>
+void with_block_size(std::size_t block_size, Func&& func) {
+    switch (block_size) {
+        case 8:
+            return func.template operator()<8>();
+        case 16:
+            return func.template operator()<16>();
+        case 32:
+            return func.template operator()<32>();
+        case 64:
+            return func.template operator()<64>();
+        case 128:
+            return func.template operator()<128>();
+        case 256:
+            return func.template operator()<256>();
+        default:
+            return func.template operator()<0>();
+    }
+}
+
+template <typename Func>
+void with_envelope_step(std::size_t envelope_step, Func&& func) {
+    static_assert(k_max_envelope_step == 16);
+    switch (envelope_step) {
+        case 2:
+            return func.template operator()<2>();
+        case 4:
+            return func.template operator()<4>();
+        case 8:
+            return func.template operator()<8>();
+        case 16:
+            return func.template operator()<16>();
+        default:
+            return func.template operator()<1>();
+    }
+}
+
+template <typename Filter, std::size_t BlockSize, typename Refs,
+          typename Load>
+void run_bank(Refs const& bank, float* output, std::size_t block_size,
+              Load&& load) {
+    if constexpr (BlockSize != 0) {
+        block_size = BlockSize;
+    }
+    std::size_t const stride = bank.stride;
+    for (std::size_t lane = 0; lane < stride; lane += simd::k_lanes) {
+        Filter filter(bank, lane);
+        for (std::size_t i = 0; i < block_size; i++) {
+            simd::store(output + i * stride + lane, filter(load(i, lane)));
+        }
+
+        // Save state that can be referenced on next block.
+        filter.save(bank, lane);
+    }
+}
+
+void biquad_bank(BiquadBankRefs const& bank, float* data,
+                 std::size_t block_size) {
+    std::size_t const stride = bank.stride;
+    auto load = [=](std::size_t i, std::size_t lane) {
+        return simd::load(data + i * stride + lane);
+    };
+    with_block_size(block_size, [&]<std::size_t BlockSize>() {
+        run_bank<Biquad, BlockSize>(bank, data, block_size, load);
+    });
+}
+
+void biquad_bank_split(BiquadBankRefs const& bank, float const* input,
+                       float* output, std::size_t block_size) {
+    auto load = [=](std::size_t i, std::size_t) {
+        return simd::broadcast(input[i]);
+    };
+    with_block_size(block_size, [&]<std::size_t BlockSize>() {
+        run_bank<Biquad, BlockSize>(bank, output, block_size, load);
+    });
+}
+
+void state_variable_bank(StateVariableBankRefs const& bank, float* data,
+                         std::size_t block_size) {
+    std::size_t const stride = bank.stride;
+    auto load = [=](std::size_t i, std::size_t lane) {
+        return simd::load(data + i * stride + lane);
+    };
+    with_block_size(block_size, [&]<std::size_t BlockSize>() {
+        run_bank<StateVariable, BlockSize>(bank, data, block_size, load);
+    });
+}
+
+void state_variable_bank_split(StateVariableBankRefs const& bank,
+                               float const* input, float* output,
+                               std::size_t block_size) {
+    auto load = [=](std::size_t i, std::size_t) {
+        return simd::broadcast(input[i]);
+    };
+    with_block_size(block_size, [&]<std::size_t BlockSize>() {
+        run_bank<StateVariable, BlockSize>(bank, output, block_size, load);
+    });
+}
+
+// Where the vocoder gets the carrier's bands for a group of lanes from. Either
+// it filters the carrier as it goes...
+struct FilteredCarrier {
+    struct Group {
+        Biquad bandpass;
+        float const* carrier;
+
+        Vec operator()(std::size_t i) {
+            return bandpass(simd::broadcast(carrier[i]));
+        }
+    };
+
+    BiquadBankRefs const& bank;
+    float const* carrier;
+
+    Group group(std::size_t start, std::size_t lane) const {
+        return {Biquad(bank, lane), carrier + start};
+    }
+    void save(Group const& group, std::size_t lane) const {
+        group.bandpass.save(bank, lane);
+    }
+};
+
+// ... or it reads them from a block that was split up front.
+struct AnalyzedCarrier {
+    struct Group {
+        float const* bands;
+        std::size_t stride;
+
+        Vec operator()(std::size_t i) const {
+            return simd::load(bands + i * stride);
+        }
+    };
+
+    float const* bands;
+    std::size_t stride;
+
+    Group group(std::size_t start, std::size_t lane) const {
+        return {bands + start * stride + lane, stride};
+    }
+    void save(Group const&, std::size_t) const {}
+};
+
+// Whether any band of the group at |lane| was let through last time.
+bool gate_open(BandGate const& gate, std::size_t lane) {
+    for (std::size_t i = 0; i < simd::k_lanes; i++) {
+        if (gate.active[lane + i] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void set_gate(BandGate const& gate, std::size_t lane, bool open) {
+    for (std::size_t i = 0; i < simd::k_lanes; i++) {
+        gate.active[lane + i] = open;
+    }
+}
+
+// Longest tile run_vocoder() takes. Each sample of a tile keeps three
+// vectors on the stack, the sum and a shut group's envelope and carrier, so
+// wider vectors get shorter tiles. That keeps them in L1, and to 12 KB of
+// stack on the realtime thread and each helper, on any target.
+constexpr std::size_t k_max_tile = 1024 / simd::k_lanes;
+
+template <std::size_t TileSize, std::size_t EnvelopeStep, typename Carrier>
+std::size_t run_vocoder(VocoderBankRefs const& banks, float const* signal,
+                        Carrier const& carrier, float* output,
+                        std::size_t count, std::size_t tile_size) {
+    if constexpr (TileSize != 0) {
+        static_assert(TileSize <= k_max_tile);
+        tile_size = TileSize;
+    } else if (tile_size > k_max_tile || tile_size == 0) {
+        tile_size = k_max_tile;
+    }
+    constexpr std::size_t k_tile = TileSize != 0 ? TileSize : k_max_tile;
+    std::size_t const stride = banks.signal_bandpass.stride;
+    BandGate const& gate = banks.gate;
+    bool const gated = gate.active != nullptr;
+    std::size_t skipped = 0;
+
+    for (std::size_t start = 0; start < count; start += tile_size) {
+        std::size_t const remaining = count - start;
+        std::size_t const tile = remaining < tile_size ? remaining : tile_size;
+        float const* const tile_signal = signal + start;
+
+        Vec total[k_tile];
+        for (std::size_t i = 0; i < tile; i++) {
+            total[i] = Vec{};
+        }
+
+        // Run every stage of a group of bands over the whole tile before
+        // moving on to the next group, so the filters stay in registers.
+        // They share one loop so that their dependency chains overlap. Only
+        // the last tile of a call can end on a short step.
+        std::size_t const whole = tile - tile % EnvelopeStep;
+        std::size_t const short_step = tile - whole;
+        for (std::size_t lane = 0; lane < stride; lane += simd::k_lanes) {
+            Biquad signal_bandpass(banks.signal_bandpass, lane);
+            Biquad envelope_lowpass(banks.envelope_lowpass, lane);
+            auto carrier_band = carrier.group(start, lane);
+            Biquad output_bandpass(banks.output_bandpass, lane);
+
+            // Each step's envelope, then its output ramping up to it. With
+            // the gate on, this tracks the peak going into and out of the
+            // output stage. A group that's shut skips the multiply as well
+            // as the output stage. It only keeps the envelope and carrier,
+            // in case it has to open again, and their peaks, whose product
+            // bounds what would have gone in. The envelope ramps in a
+            // straight line between steps, so its peak is at one of them.
+            Vec envelope = envelope_lowpass.y1;
+            Vec peak{};
+            Vec envelope_peak = simd::abs(envelope);
+            Vec carrier_peak{};
+            Vec shut_envelope[k_tile];
+            Vec shut_carrier[k_tile];
+            auto run_tile = [&]<bool Gated, bool Open>() {
+                auto run_step = [&](std::size_t first, std::size_t length,
+                                    float scale) {
+                    Vec rectified{};
+                    for (std::size_t i = first; i < first + length; i++) {
+                        rectified += simd::abs(
+                            signal_bandpass(simd::broadcast(tile_signal[i])));
+                    }
+                    Vec const next = envelope_lowpass(rectified * scale);
+                    Vec const slope = (next - envelope) * scale;
+                    if constexpr (!Open) {
+                        envelope_peak =
+                            simd::max(envelope_peak, simd::abs(next));
+                    }
+                    for (std::size_t i = first; i < first + length; i++) {
+                        if constexpr (EnvelopeStep == 1) {
+                            envelope = next;
+                        } else {
+                            envelope += slope;
+                        }
+                        Vec const carried = carrier_band(i);
+                        if constexpr (!Open) {
+                            shut_envelope[i] = envelope;
+                            shut_carrier[i] = carried;
+                            carrier_peak =
+                                simd::max(carrier_peak, simd::abs(carried));
+                        } else {
+                            Vec const product = envelope * carried;
+                            Vec const band = output_bandpass(product);
+                            total[i] += band;
+                            if constexpr (Gated) {
+                                peak = simd::max(
+                                    peak, simd::max(simd::abs(product),
+                                                    simd::abs(band)));
+                            }
+                        }
+                    }
+                    envelope = next;
+                };
+                for (std::size_t i = 0; i < whole; i += EnvelopeStep) {
+                    run_step(i, EnvelopeStep, 1.0f / EnvelopeStep);
+                }
+                if constexpr (EnvelopeStep > 1) {
+                    if (short_step != 0) {
+                        run_step(whole, short_step, 1.0f / short_step);
+                    }
+                }
+            };
+
+            if (!gated) {
+                run_tile.template operator()<false, true>();
+            } else {
+                // A group has to be quiet for a whole tile to shut, which
+                // lets the output stage ring down first. It opens again as
+                // soon as anything reaches the level, from the start of
+                // that tile, so nothing is lost but what was under it.
+                bool const open = gate_open(gate, lane);
+                if (open) {
+                    run_tile.template operator()<true, true>();
+                } else {
+                    run_tile.template operator()<true, false>();
+                }
+                bool const loud = simd::any_at_least(
+                    open ? peak : envelope_peak * carrier_peak, gate.level);
+                if (!open && loud) {
+                    for (std::size_t i = 0; i < tile; i++) {
+                        total[i] += output_bandpass(shut_envelope[i] *
+                                                    shut_carrier[i]);
+                    }
+                } else if (!open) {
+                    skipped += tile * simd::k_lanes;
+                } else if (!loud) {
+                    // Start from rest when it opens again.
+                    output_bandpass.x1 = output_bandpass.x2 = Vec{};
+                    output_bandpass.y1 = output_bandpass.y2 = Vec{};
+                }
+                set_gate(gate, lane, loud);
+            }
+
+            signal_bandpass.save(banks.signal_bandpass, lane);
+            envelope_lowpass.save(banks.envelope_lowpass, lane);
+            carrier.save(carrier_band, lane);
+            output_bandpass.save(banks.output_bandpass, lane);
+        }
+
+        for (std::size_t i = 0; i < tile; i++) {
+            output[start + i] = simd::sum(total[i]);
+        }
+    }
+    return skipped;
+}
+
+template <typename Carrier>
+std::size_t dispatch_vocoder(VocoderBankRefs const& banks, float const* signal,
+                             Carrier const& carrier, float* output,
+                             std::size_t count, std::size_t tile_size,
+                             std::size_t envelope_step) {
+    std::size_t skipped = 0;
+    with_block_size(tile_size, [&]<std::size_t TileSize>() {
+        with_envelope_step(envelope_step, [&]<std::size_t EnvelopeStep>() {
+            // The step has to divide the tile. Where it doesn't, stretch
+            // the tile to a whole number of steps, which loses the constant
+            // trip count but not the output. A runtime size is stretched
+            // the same way, so that only a call's last step is short.
+            if constexpr (TileSize == 0) {
+                std::size_t const stretched =
+                    (tile_size + EnvelopeStep - 1) / EnvelopeStep *
+                    EnvelopeStep;
+                skipped = run_vocoder<0, EnvelopeStep>(
+                    banks, signal, carrier, output, count, stretched);
+            } else if constexpr (TileSize > k_max_tile) {
+                // Too long for this target, so split into the longest that
+                // fits, which keeps the constant trip count.
+                skipped = run_vocoder<k_max_tile, EnvelopeStep>(
+                    banks, signal, carrier, output, count, k_max_tile);
+            } else if constexpr (TileSize % EnvelopeStep == 0) {
+                skipped = run_vocoder<TileSize, EnvelopeStep>(
+                    banks, signal, carrier, output, count, tile_size);
+            } else {
+                constexpr std::size_t k_stretched =
+                    (TileSize + EnvelopeStep - 1) / EnvelopeStep *
+                    EnvelopeStep;
+                skipped = run_vocoder<0, EnvelopeStep>(
+                    banks, signal, carrier, output, count, k_stretched);
+            }
+        });
+    });
+    return skipped;
+}
+
+std::size_t vocoder(VocoderBankRefs const& banks, float const* signal,
+                    float const* carrier, float* output, std::size_t count,
+                    std::size_t tile_size, std::size_t envelope_step) {
+    return dispatch_vocoder(banks, signal,
+                            FilteredCarrier{banks.carrier_bandpass, carrier},
+                            output, count, tile_size, envelope_step);
+}
+
+std::size_t vocoder_analyzed(VocoderBankRefs const& banks, float const* signal,
+                             float const* carrier_bands,
+                             std::size_t carrier_stride, float* output,
+                             std::size_t count, std::size_t tile_size,
+                             std::size_t envelope_step) {
+    return dispatch_vocoder(banks, signal,
+                            AnalyzedCarrier{carrier_bands, carrier_stride},
+                            output, count, tile_size, envelope_step);
+}
+
+// Where vocoder_precise() gets the carrier's bands for a group of lanes from,
+// as for vocoder().
+struct PreciseFilteredCarrier {
+    struct Group {
+        PreciseBiquad bandpass;
+        float const* carrier;
+
+        simd::DVec operator()(std::size_t i) {
+            return bandpass(simd::DVec{} + carrier[i]);
+        }
+    };
+
+    PreciseBankRefs const& bank;
+    float const* carrier;
+
+    Group group(std::size_t start, std::size_t lane) const {
+        return {{bank, lane}, carrier + start};
+    }
+    void save(Group const& group, std::size_t lane) const {
+        group.bandpass.save(bank, lane);
+    }
+};
+
+struct PreciseAnalyzedCarrier {
+    struct Group {
+        float const* bands;
+        std::size_t stride;
+
+        simd::DVec operator()(std::size_t i) const {
+            return simd::load_widened(bands + i * stride);
+        }
+    };
+
+    float const* bands;
+    std::size_t stride;
+
+    Group group(std::size_t start, std::size_t lane) const {
+        return {bands + start * stride + lane, stride};
+    }
+    void save(Group const&, std::size_t) const {}
+};
+
+template <typename Carrier>
+void run_vocoder_precise(PreciseVocoderBankRefs const& banks,
+                         float const* signal, Carrier const& carrier,
+                         float* output, std::size_t count, double gain) {
+    // Each group of lanes over a tile at a time, summing the groups' lanes
+    // side by side so that they only need adding across once per sample.
+    constexpr std::size_t k_tile_size = 64;
+    for (std::size_t start = 0; start < count; start += k_tile_size) {
+        std::size_t const tile_size =
+            count - start < k_tile_size ? count - start : k_tile_size;
+        simd::DVec sums[k_tile_size] = {};
+        for (std::size_t lane = 0; lane < banks.signal_bandpass.stride;
+             lane += simd::k_double_lanes) {
+            PreciseBiquad signal_bandpass(banks.signal_bandpass, lane);
+            PreciseBiquad envelope_lowpass(banks.envelope_lowpass, lane);
+            PreciseBiquad output_bandpass(banks.output_bandpass, lane);
+            auto carried = carrier.group(start, lane);
+            for (std::size_t i = 0; i < tile_size; i++) {
+                simd::DVec const band =
+                    signal_bandpass(simd::DVec{} + signal[start + i]);
+                simd::DVec const envelope = envelope_lowpass(simd::abs(band));
+                sums[i] += output_bandpass(envelope * carried(i));
+            }
+            signal_bandpass.save(banks.signal_bandpass, lane);
+            envelope_lowpass.save(banks.envelope_lowpass, lane);
+            output_bandpass.save(banks.output_bandpass, lane);
+            carrier.save(carried, lane);
+        }
+        for (std::size_t i = 0; i < tile_size; i++) {
+            output[start + i] += static_cast<float>(gain * simd::sum(sums[i]));
+        }
+    }
+}
+
+void vocoder_precise(PreciseVocoderBankRefs const& banks, float const* signal,
+                     float const* carrier, float* output, std::size_t count,
+                     double gain) {
+    run_vocoder_precise(banks, signal,
+                        PreciseFilteredCarrier{banks.carrier_bandpass, carrier},
+                        output, count, gain);
+}
+
+void vocoder_precise_analyzed(PreciseVocoderBankRefs const& banks,
+                              float const* signal, float const* carrier_bands,
+                              std::size_t carrier_stride, float* output,
+                              std::size_t count, double gain) {
+    run_vocoder_precise(banks, signal,
+                        PreciseAnalyzedCarrier{carrier_bands, carrier_stride},
+                        output, count, gain);
+}
+
+// A single fixed point filter of a bank, held in registers, with the
+// coefficients widened up front.
+struct FixedPointBiquad {
+    simd::I64Vec a1, a2, b0, b1, b2;
+    simd::IVec x1, x2, y1, y2, error;
+
+    FixedPointBiquad(FixedPointBankRefs const& bank, std::size_t lane)
+        : a1(simd::widen(simd::load(bank.a1 + lane))),
+          a2(simd::widen(simd::load(bank.a2 + lane))),
+          b0(simd::widen(simd::load(bank.b0 + lane))),
+          b1(simd::widen(simd::load(bank.b1 + lane))),
+          b2(simd::widen(simd::load(bank.b2 + lane))),
+          x1(simd::load(bank.x1 + lane)),
+          x2(simd::load(bank.x2 + lane)),
+          y1(simd::load(bank.y1 + lane)),
+          y2(simd::load(bank.y2 + lane)),
+          error(simd::load(bank.error + lane)) {}
+
+    void save(FixedPointBankRefs const& bank, std::size_t lane) const {
+        simd::store(bank.x1 + lane, x1);
+        simd::store(bank.x2 + lane, x2);
+        simd::store(bank.y1 + lane, y1);
+        simd::store(bank.y2 + lane, y2);
+        simd::store(bank.error + lane, error);
+    }
+
+    // Same as FixedPolicy::biquad().
+    simd::IVec operator()(simd::IVec x) {
+        simd::I64Vec const sum = b0 * simd::widen(x) + b1 * simd::widen(x1) +
+                                 b2 * simd::widen(x2) + a1 * simd::widen(y1) +
+                                 a2 * simd::widen(y2) + simd::widen(error);
+        simd::IVec const y = simd::narrow<k_fixed_coef_bits>(sum);
+        error = simd::residual<k_fixed_coef_bits>(sum, y);
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+};
+
+void vocoder_fixed_point(FixedPointVocoderBankRefs const& banks,
+                         int32_t const* signal, int32_t const* carrier,
+                         int64_t* output, std::size_t count) {
+    // A group of lanes at a time over the whole call, as the sums are exact
+    // in any order.
+    for (std::size_t lane = 0; lane < banks.signal_bandpass.stride;
+         lane += simd::k_lanes) {
+        FixedPointBiquad signal_bandpass(banks.signal_bandpass, lane);
+        FixedPointBiquad carrier_bandpass(banks.carrier_bandpass, lane);
+        FixedPointBiquad envelope_lowpass(banks.envelope_lowpass, lane);
+        FixedPointBiquad output_bandpass(banks.output_bandpass, lane);
+        for (std::size_t i = 0; i < count; i++) {
+            simd::IVec const band = signal_bandpass(simd::IVec{} + signal[i]);
+            simd::IVec const carried =
+                carrier_bandpass(simd::IVec{} + carrier[i]);
+            simd::IVec const envelope = envelope_lowpass(simd::abs(band));
+            simd::IVec const mixed = simd::narrow<k_fixed_state_bits>(
+                simd::widen(envelope) * simd::widen(carried));
+            output[i] += simd::sum(simd::widen(output_bandpass(mixed)));
+        }
+        signal_bandpass.save(banks.signal_bandpass, lane);
+        carrier_bandpass.save(banks.carrier_bandpass, lane);
+        envelope_lowpass.save(banks.envelope_lowpass, lane);
+        output_bandpass.save(banks.output_bandpass, lane);
+    }
+}
+
+// A filter per channel for one group of lanes, sharing the coefficients.
+// Running the channels side by side overlaps their dependency chains. Loops
+// over the channels are unrolled so that the state stays in registers.
+template <std::size_t MaxChannels>
+struct ChannelBiquads {
+    Vec a1, a2, b0, b1, b2;
+    Vec x1[MaxChannels], x2[MaxChannels], y1[MaxChannels], y2[MaxChannels];
+
+    ChannelBiquads(BiquadBankRefs const* banks, std::size_t num_channels,
+                   std::size_t lane)
+        : a1(simd::load(banks[0].a1 + lane)),
+          a2(simd::load(banks[0].a2 + lane)),
+          b0(simd::load(banks[0].b0 + lane)),
+          b1(simd::load(banks[0].b1 + lane)),
+          b2(simd::load(banks[0].b2 + lane)) {
+        for (std::size_t channel = 0; channel < num_channels; channel++) {
+            x1[channel] = simd::load(banks[channel].x1 + lane);
+            x2[channel] = simd::load(banks[channel].x2 + lane);
+            y1[channel] = simd::load(banks[channel].y1 + lane);
+            y2[channel] = simd::load(banks[channel].y2 + lane);
+        }
+    }
+
+    void save(BiquadBankRefs const* banks, std::size_t num_channels,
+              std::size_t lane) const {
+        for (std::size_t channel = 0; channel < num_channels; channel++) {
+            simd::store(banks[channel].x1 + lane, x1[channel]);
+            simd::store(banks[channel].x2 + lane, x2[channel]);
+            simd::store(banks[channel].y1 + lane, y1[channel]);
+            simd::store(banks[channel].y2 + lane, y2[channel]);
+        }
+    }
+
+    // Same accumulation order as Biquad.
+    Vec operator()(std::size_t channel, Vec x) {
+        Vec y = b0 * x;
+        y += b1 * x1[channel];
+        y += b2 * x2[channel];
+        y += a1 * y1[channel];
+        y += a2 * y2[channel];
+        x2[channel] = x1[channel];
+        x1[channel] = x;
+        y2[channel] = y1[channel];
+        y1[channel] = y;
+        return y;
+    }
+};
+
+// NumChannels is 0 for a count only known at runtime.
+template <std::size_t NumChannels, typename Carrier>
+void run_vocoder_multichannel(MultichannelBankRefs const& banks,
+                              float const* signal, Carrier const& carrier,
+                              float* output, std::size_t num_frames) {
+    // Smaller than the mono tile since every channel has its own sums.
+    constexpr std::size_t k_tile_size = 32;
+    constexpr std::size_t k_channels =
+        NumChannels != 0 ? NumChannels : k_max_channels;
+    std::size_t const num_channels =
+        NumChannels != 0 ? NumChannels : banks.num_channels;
+    std::size_t const stride = banks.signal_bandpass[0].stride;
+
+    for (std::size_t start = 0; start < num_frames; start += k_tile_size) {
+        std::size_t const remaining = num_frames - start;
+        std::size_t const tile =
+            remaining < k_tile_size ? remaining : k_tile_size;
+        float const* const tile_signal = signal + start * num_channels;
+
+        Vec total[k_tile_size][k_channels];
+        for (std::size_t i = 0; i < tile; i++) {
+            for (std::size_t channel = 0; channel < num_channels; channel++) {
+                total[i][channel] = Vec{};
+            }
+        }
+
+        for (std::size_t lane = 0; lane < stride; lane += simd::k_lanes) {
+            // The carrier is the same for every channel, so it only runs
+            // once, alongside the channels' envelopes. Those read their
+            // samples straight out of the frames.
+            Vec bands[k_tile_size];
+            Vec envelopes[k_tile_size][k_channels];
+            {
+                auto carrier_band = carrier.group(start, lane);
+                ChannelBiquads<k_channels> signal_bandpass(
+                    banks.signal_bandpass, num_channels, lane);
+                ChannelBiquads<k_channels> envelope_lowpass(
+                    banks.envelope_lowpass, num_channels, lane);
+                for (std::size_t i = 0; i < tile; i++) {
+                    bands[i] = carrier_band(i);
+                    float const* const frame = tile_signal + i * num_channels;
+#pragma GCC unroll 8
+                    for (std::size_t channel = 0; channel < num_channels;
+                         channel++) {
+                        Vec const band = signal_bandpass(
+                            channel, simd::broadcast(frame[channel]));
+                        envelopes[i][channel] =
+                            envelope_lowpass(channel, simd::abs(band));
+                    }
+                }
+                carrier.save(carrier_band, lane);
+                signal_bandpass.save(banks.signal_bandpass, num_channels,
+                                     lane);
+                envelope_lowpass.save(banks.envelope_lowpass, num_channels,
+                                      lane);
+            }
+
+            ChannelBiquads<k_channels> output_bandpass(banks.output_bandpass,
+                                                       num_channels, lane);
+            for (std::size_t i = 0; i < tile; i++) {
+#pragma GCC unroll 8
+                for (std::size_t channel = 0; channel < num_channels;
+                     channel++) {
+                    total[i][channel] += output_bandpass(
+                        channel, envelopes[i][channel] * bands[i]);
+                }
+            }
+            output_bandpass.save(banks.output_bandpass, num_channels, lane);
+        }
+
+        float* const tile_output = output + start * num_channels;
+        for (std::size_t i = 0; i < tile; i++) {
+            for (std::size_t channel = 0; channel < num_channels; channel++) {
+                tile_output[i * num_channels + channel] =
+                    simd::sum(total[i][channel]);
+            }
+        }
+    }
+}
+
+template <typename Carrier>
+void dispatch_vocoder_multichannel(MultichannelBankRefs const& banks,
+                                   float const* signal, Carrier const& carrier,
+                                   float* output, std::size_t num_frames) {
+    switch (banks.num_channels) {
+        case 1:
+            return run_vocoder_multichannel<1>(banks, signal, carrier, output,
+                                               num_frames);
+        case 2:
+            return run_vocoder_multichannel<2>(banks, signal, carrier, output,
+                                               num_frames);
+        default:
+            return run_vocoder_multichannel<0>(banks, signal, carrier, output,
+                                               num_frames);
+    }
+}
+
+void vocoder_multichannel(MultichannelBankRefs const& banks,
+                          float const* signal, float const* carrier,
+                          float* output, std::size_t num_frames) {
+    dispatch_vocoder_multichannel(
+        banks, signal, FilteredCarrier{banks.carrier_bandpass, carrier},
+        output, num_frames);
+}
+
+void vocoder_multichannel_analyzed(MultichannelBankRefs const& banks,
+                                   float const* signal,
+                                   float const* carrier_bands,
+                                   std::size_t carrier_stride, float* output,
+                                   std::size_t num_frames) {
+    dispatch_vocoder_multichannel(
+        banks, signal, AnalyzedCarrier{carrier_bands, carrier_stride}, output,
+        num_frames);
+}
+
+void lookahead(float const* columns, float* x, float* y, float* data,
+               std::size_t num_steps) {
+    constexpr std::size_t k_size = k_lookahead;
+    static_assert(k_size % simd::k_lanes == 0);
+    auto column = [columns](std::size_t j, std::size_t k) {
+        return simd::load(columns + j * k_size + k);
+    };
+
+    float x1 = x[1], x2 = x[0];
+    float y1 = y[1], y2 = y[0];
+    for (std::size_t step = 0; step < num_steps; step++) {
+        float* const ptr = data + step * k_size;
+
+        // Take a copy since the outputs overwrite the inputs.
+        float input[k_size];
+        std::memcpy(input, ptr, sizeof(input));
+
+        // Vectorise over the outputs of this step. Input j only feeds the
+        // outputs from k=j onwards.
+        for (std::size_t k = 0; k < k_size; k += simd::k_lanes) {
+            Vec sample{};
+            for (std::size_t j = 0; j < k + simd::k_lanes; j++) {
+                sample += simd::broadcast(input[j]) * column(j, k);
+            }
+            sample += simd::broadcast(x1) *
+                      column(k_lookahead_x1, k);
+            sample += simd::broadcast(x2) *
+                      column(k_lookahead_x2, k);
+
+            // Only these depend on the previous step.
+            sample += simd::broadcast(y1) *
+                      column(k_lookahead_y1, k);
+            sample += simd::broadcast(y1 - y2) *
+                      column(k_lookahead_dy, k);
+            simd::store(ptr + k, sample);
+        }
+
+        x1 = input[k_size - 1];
+        x2 = input[k_size - 2];
+        y1 = ptr[k_size - 1];
+        y2 = ptr[k_size - 2];
+    }
+
+    x[1] = x1;
+    x[0] = x2;
+    y[1] = y1;
+    y[0] = y2;
+}
+
+// Outputs per pass of the halfband kernels.
+constexpr std::size_t k_halfband_tile = 64;
+
+void halfband_decimate(float const* taps, std::size_t num_taps,
+                       float const* input, float* output, std::size_t count) {
+    // Output n is centred on input 2n - centre, which is odd, with the other
+    // taps on even inputs. Split the phases so that both can be read along n.
+    std::size_t const centre = 2 * num_taps - 1;
+    std::size_t const half_centre = num_taps - 1;
+    for (std::size_t start = 0; start < count; start += k_halfband_tile) {
+        std::size_t const remaining = count - start;
+        std::size_t const tile =
+            remaining < k_halfband_tile ? remaining : k_halfband_tile;
+
+        // Entry j holds inputs 2 (j - centre) and 2 (j - centre) + 1.
+        constexpr std::size_t k_size =
+            k_halfband_tile + 2 * k_max_halfband_taps;
+        float even[k_size];
+        float odd[k_size];
+        float const* const base = input + 2 * start - 2 * centre;
+        for (std::size_t j = 0; j < tile + centre; j++) {
+            even[j] = base[2 * j];
+            odd[j] = base[2 * j + 1];
+        }
+
+        float* const tile_output = output + start;
+        std::size_t n = 0;
+        for (; n + simd::k_lanes <= tile; n += simd::k_lanes) {
+            Vec sample = simd::load(odd + n + half_centre) * 0.5f;
+            for (std::size_t k = 0; k < num_taps; k++) {
+                sample += simd::broadcast(taps[k]) *
+                          (simd::load(even + n + num_taps + k) +
+                           simd::load(even + n + half_centre - k));
+            }
+            simd::store(tile_output + n, sample);
+        }
+        for (; n < tile; n++) {
+            float sample = odd[n + half_centre] * 0.5f;
+            for (std::size_t k = 0; k < num_taps; k++) {
+                sample += taps[k] * (even[n + num_taps + k] +
+                                     even[n + half_centre - k]);
+            }
+            tile_output[n] = sample;
+        }
+    }
+}
+
+void halfband_interpolate_add(float const* taps, std::size_t num_taps,
+                              float const* input, float* output,
+                              std::size_t count) {
+    // Even outputs take every tap but the centre one, and odd outputs only
+    // the centre one.
+    std::size_t const half_centre = num_taps - 1;
+    for (std::size_t start = 0; start < count; start += k_halfband_tile) {
+        std::size_t const remaining = count - start;
+        std::size_t const tile =
+            remaining < k_halfband_tile ? remaining : k_halfband_tile;
+        float const* const base = input + start - half_centre;
+
+        float even[k_halfband_tile];
+        std::size_t n = 0;
+        for (; n + simd::k_lanes <= tile; n += simd::k_lanes) {
+            Vec sample{};
+            for (std::size_t k = 0; k < num_taps; k++) {
+                sample += simd::broadcast(taps[k]) *
+                          (simd::load(base + n + k) +
+                           simd::load(base + n - 1 - k));
+            }
+            simd::store(even + n, sample);
+        }
+        for (; n < tile; n++) {
+            float sample = 0;
+            for (std::size_t k = 0; k < num_taps; k++) {
+                sample += taps[k] * (base[n + k] + base[n - 1 - k]);
+            }
+            even[n] = sample;
+        }
+
+        float* const tile_output = output + 2 * start;
+        for (n = 0; n < tile; n++) {
+            tile_output[2 * n] += 2 * even[n];
+            tile_output[2 * n + 1] += base[n];
+        }
+    }
+}
+
+// Stockham autosort: each pass reads in one order and writes in another, so
+// there's no bit reversal at the end.
+void fft_pass(float const* x_re, float const* x_im, float* y_re, float* y_im,
+              float const* twiddle_re, float const* twiddle_im,
+              std::size_t half, std::size_t stride) {
+    for (std::size_t p = 0; p < half; p++) {
+        std::size_t const a = stride * p;
+        std::size_t const b = stride * (p + half);
+        std::size_t const sum = stride * 2 * p;
+        std::size_t const diff = sum + stride;
+
+        // The later passes have long runs of neighbouring points.
+        std::size_t q = 0;
+        if (stride >= simd::k_lanes) {
+            Vec const w_re = simd::broadcast(twiddle_re[p]);
+            Vec const w_im = simd::broadcast(twiddle_im[p]);
+            for (; q < stride; q += simd::k_lanes) {
+                Vec const a_re = simd::load(x_re + a + q);
+                Vec const a_im = simd::load(x_im + a + q);
+                Vec const b_re = simd::load(x_re + b + q);
+                Vec const b_im = simd::load(x_im + b + q);
+                simd::store(y_re + sum + q, a_re + b_re);
+                simd::store(y_im + sum + q, a_im + b_im);
+                Vec const d_re = a_re - b_re;
+                Vec const d_im = a_im - b_im;
+                simd::store(y_re + diff + q, d_re * w_re - d_im * w_im);
+                simd::store(y_im + diff + q, d_re * w_im + d_im * w_re);
+            }
+        }
+        for (; q < stride; q++) {
+            float const a_re = x_re[a + q];
+            float const a_im = x_im[a + q];
+            float const b_re = x_re[b + q];
+            float const b_im = x_im[b + q];
+            y_re[sum + q] = a_re + b_re;
+            y_im[sum + q] = a_im + b_im;
+            float const d_re = a_re - b_re;
+            float const d_im = a_im - b_im;
+            y_re[diff + q] = d_re * twiddle_re[p] - d_im * twiddle_im[p];
+            y_im[diff + q] = d_re * twiddle_im[p] + d_im * twiddle_re[p];
+        }
+    }
+}
+
+void lattice_inverse(float const* reflection, float* state, std::size_t order,
+                     float* forward, float* backward, std::size_t count) {
+    // Nothing feeds back, so each stage can run over every sample at once.
+    // Going backwards leaves the previous sample's error in place to read.
+    for (std::size_t i = 0; i < order; i++) {
+        Vec const coef = simd::broadcast(reflection[i]);
+        float const first_delayed = state[i];
+        state[i] = backward[count - 1];
+
+        std::size_t n = count;
+        for (; n > simd::k_lanes; n -= simd::k_lanes) {
+            std::size_t const start = n - simd::k_lanes;
+            Vec const delayed = simd::load(backward + start - 1);
+            Vec const forward_in = simd::load(forward + start);
+            simd::store(backward + start, delayed + coef * forward_in);
+            simd::store(forward + start, forward_in + coef * delayed);
+        }
+        while (n-- > 0) {
+            float const delayed = n != 0 ? backward[n - 1] : first_delayed;
+            backward[n] = delayed + reflection[i] * forward[n];
+            forward[n] += reflection[i] * delayed;
+        }
+    }
+}
+
+void lattice_all_pole(float const* even_reflection, float const* odd_reflection,
+                      float* even_state, float* odd_state, std::size_t order,
+                      float* data, std::size_t count) {
+    // Sample n is at stage 2n + order - 1 - step, so it runs after stage
+    // i - 1 of the sample before has written the backward error it reads.
+    // Every sample in a step is at a stage of the same parity, and stage i
+    // writes the backward error of stage i + 1 of the other parity.
+    for (std::size_t step = 0; step + 2 < 2 * count + order; step++) {
+        std::size_t const first = step >= order ? (step - order + 2) / 2 : 0;
+        std::size_t const last = step / 2 + 1 < count ? step / 2 + 1 : count;
+        std::size_t const stage = 2 * first + order - 1 - step;
+        bool const odd = (stage & 1) != 0;
+        float const* const k = (odd ? odd_reflection : even_reflection) +
+                               stage / 2;
+        float const* const s_in = (odd ? odd_state : even_state) + stage / 2;
+        float* const s_out = odd ? even_state + stage / 2 + 1
+                                 : odd_state + stage / 2;
+        float* const d = data + first;
+        std::size_t const num = last - first;
+
+        std::size_t m = 0;
+        for (; m + simd::k_lanes <= num; m += simd::k_lanes) {
+            Vec const coef = simd::load(k + m);
+            Vec const delayed = simd::load(s_in + m);
+            Vec const value = simd::load(d + m) - coef * delayed;
+            simd::store(d + m, value);
+            simd::store(s_out + m, delayed + coef * value);
+        }
+        for (; m < num; m++) {
+            d[m] -= k[m] * s_in[m];
+            s_out[m] = s_in[m] + k[m] * d[m];
+        }
+
+        // The bottom stage's output is its own backward error.
+        if (stage == 0) {
+            even_state[0] = d[0];
+        }
+    }
+}
+
+void abs(float* data, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + simd::k_lanes <= count; i += simd::k_lanes) {
+        simd::store(data + i, simd::abs(simd::load(data + i)));
+    }
+    for (; i < count; i++) {
+        data[i] = __builtin_fabsf(data[i]);
+    }
+}
+
+void mul(float* a, float const* b, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + simd::k_lanes <= count; i += simd::k_lanes) {
+        simd::store(a + i, simd::load(a + i) * simd::load(b + i));
+    }
+    for (; i < count; i++) {
+        a[i] *= b[i];
+    }
+}
+
+void add(float* a, float const* b, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + simd::k_lanes <= count; i += simd::k_lanes) {
+        simd::store(a + i, simd::load(a + i) + simd::load(b + i));
+    }
+    for (; i < count; i++) {
+        a[i] += b[i];
+    }
+}
+
+float dot(float const* a, float const* b, std::size_t count) {
+    // Several running totals so that the adds don't wait on each other.
+    constexpr std::size_t k_step = 4 * simd::k_lanes;
+    Vec totals[4]{};
+    std::size_t i = 0;
+    for (; i + k_step <= count; i += k_step) {
+        for (std::size_t j = 0; j < 4; j++) {
+            std::size_t const offset = i + j * simd::k_lanes;
+            totals[j] += simd::load(a + offset) * simd::load(b + offset);
+        }
+    }
+    for (; i + simd::k_lanes <= count; i += simd::k_lanes) {
+        totals[0] += simd::load(a + i) * simd::load(b + i);
+    }
+    float result =
+        simd::sum((totals[0] + totals[1]) + (totals[2] + totals[3]));
+    for (; i < count; i++) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+void sum_lanes(float const* block, std::size_t stride, std::size_t block_size,
+               float* output) {
+    for (std::size_t i = 0; i < block_size; i++) {
+        Vec total{};
+        for (std::size_t lane = 0; lane < stride; lane += simd::k_lanes) {
+            total += simd::load(block + i * stride + lane);
+        }
+        output[i] = simd::sum(total);
+    }
+}
+
+// Full scale is 32768 either way, as in WAVFile.
+constexpr float k_int16_scale = 32768;
+
+void int16_to_float(int16_t const* input, float* output, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + simd::k_lanes <= count; i += simd::k_lanes) {
+        simd::I16Vec raw;
+        std::memcpy(&raw, input + i, sizeof(raw));
+        Vec const samples = __builtin_convertvector(raw, Vec);
+        simd::store(output + i, samples * (1 / k_int16_scale));
+    }
+    for (; i < count; i++) {
+        output[i] = input[i] * (1 / k_int16_scale);
+    }
+}
+
+void float_to_int16(float const* input, int16_t* output, std::size_t count) {
+    constexpr float k_min = -32768;
+    constexpr float k_max = 32767;
+    std::size_t i = 0;
+    for (; i + simd::k_lanes <= count; i += simd::k_lanes) {
+        Vec const samples = simd::load(input + i) * k_int16_scale;
+        simd::I16Vec const raw = __builtin_convertvector(
+            simd::clamp(samples, k_min, k_max), simd::I16Vec);
+        std::memcpy(output + i, &raw, sizeof(raw));
+    }
+    for (; i < count; i++) {
+        float const sample = input[i] * k_int16_scale;
+        output[i] = sample < k_min ? k_min : sample > k_max ? k_max : sample;
+    }
+}
+
+}  // namespace
+
+extern Kernels const k_kernels;
+Kernels const k_kernels{
+    .name = PWV_STRINGIFY(PWV_KERNEL_TARGET),
+    .biquad_bank = biquad_bank,
+    .biquad_bank_split = biquad_bank_split,
+    .state_variable_bank = state_variable_bank,
+    .state_variable_bank_split = state_variable_bank_split,
+    .vocoder = vocoder,
+    .vocoder_analyzed = vocoder_analyzed,
+    .vocoder_multichannel = vocoder_multichannel,
+    .vocoder_multichannel_analyzed = vocoder_multichannel_analyzed,
+    .vocoder_fixed_point = vocoder_fixed_point,
+    .vocoder_precise = vocoder_precise,
+    .vocoder_precise_analyzed = vocoder_precise_analyzed,
+    .lookahead = lookahead,
+    .halfband_decimate = halfband_decimate,
+    .halfband_interpolate_add = halfband_interpolate_add,
+    .fft_pass = fft_pass,
+    .lattice_inverse = lattice_inverse,
+    .lattice_all_pole = lattice_all_pole,
+    .abs = abs,
+    .mul = mul,
+    .add = add,
+    .dot = dot,
+    .sum_lanes = sum_lanes,
+    .int16_to_float = int16_to_float,
+    .float_to_int16 = float_to_int16,
+};
+
+}  // namespace pwv::PWV_KERNEL_TARGET
@@ -1,30 +1,80 @@
 #include "LowPass.h"
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
 namespace pwv {
 
-LowPass::LowPass(double sampling_rate, double cutoff_hz) {
+LowPass::LowPass(double sampling_rate, double cutoff_hz,
+                 FilterTopology topology)
+    : m_topology(topology) {
     reset(sampling_rate, cutoff_hz);
 }
 
 LowPass::~LowPass() {}
 
 void LowPass::reset(double sampling_rate, double cutoff_hz) {
+    if (m_topology == FilterTopology::StateVariable) {
+        m_state_variable.reset(
+            StateVariableFilter::lowpass(sampling_rate, cutoff_hz));
+    } else {
+        m_filter.reset(coefs(sampling_rate, cutoff_hz));
+    }
+}
+
+void LowPass::ramp_to(double sampling_rate, double cutoff_hz,
+                      std::size_t num_samples) {
+    if (m_topology == FilterTopology::StateVariable) {
+        m_state_variable.ramp_to(
+            StateVariableFilter::lowpass(sampling_rate, cutoff_hz),
+            num_samples);
+    } else {
+        m_filter.ramp_to(coefs(sampling_rate, cutoff_hz), num_samples);
+    }
+}
+
+SecondOrderFilter::PreciseCoefs LowPass::precise_coefs(double sampling_rate,
+                                                       double cutoff_hz) {
     // Stolen from here:
     // https://stackoverflow.com/a/20932062
     // TODO: higher order
     double const ff = cutoff_hz / sampling_rate;
     double const ita = 1.0 / std::tan(M_PI * ff);
     double const q = std::sqrt(2.0);
-    double const b0 = 1.0 / (1.0 + q * ita + ita * ita);
+    double const norm = 1.0 / (1.0 + q * ita + ita * ita);
+    double const a1 = 2.0 * (ita * ita - 1.0) * norm;
+    double const a2 = -(1.0 - q * ita + ita * ita) * norm;
+    double const b0 = (1.0 - a1 - a2) / 4;
+    return {a1, a2, b0, 2 * b0, b0};
+}
+
+SecondOrderFilter::Coefs LowPass::coefs(double sampling_rate,
+                                        double cutoff_hz) {
+    auto const precise = precise_coefs(sampling_rate, cutoff_hz);
+    double const a1 = precise.a1;
+    double const a2 = precise.a2;
+
+    // Rounded to floats, a low enough cutoff can put a pole on or outside the
+    // unit circle, and the filter then holds or grows instead of settling.
+    // The default vocoder's envelopes at 44.1 and 48 kHz are low enough, and
+    // Vocoder::pre_roll() then has no end. Step a2 down, which has the finer
+    // steps, until both poles are inside.
+    // a1 is under 2, so that stops before a2 reaches -1. Then set the gain
+    // from the rounded poles so that DC still comes through at unity.
+    using Coef = SecondOrderFilter::Coef;
+    Coef const rounded_a1 =
+        std::min(static_cast<Coef>(a1), std::nextafter(Coef{2}, Coef{0}));
+    Coef rounded_a2 = static_cast<Coef>(a2);
+    while (1.0 - rounded_a1 - rounded_a2 <= 0) {
+        rounded_a2 = std::nextafter(rounded_a2, Coef{-1});
+    }
+    double const b0 = (1.0 - rounded_a1 - rounded_a2) / 4;
     double const b1 = 2 * b0;
     double const b2 = b0;
-    double const a1 = 2.0 * (ita * ita - 1.0) * b0;
-    double const a2 = -(1.0 - q * ita + ita * ita) * b0;
 
-    m_filter.reset(a1, a2, b0, b1, b2);
+    return {rounded_a1, rounded_a2, static_cast<Coef>(b0),
+            static_cast<Coef>(b1), static_cast<Coef>(b2)};
 }
 
 }  // namespace pwv
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "NumericPolicy.h"
 #include "SecondOrderFilter.h"
+#include "StateVariableFilter.h"
+
+#include <type_traits>
 
 namespace pwv {
 
@@ -9,16 +13,61 @@ class LowPass {
     static constexpr std::size_t k_block_size = SecondOrderFilter::k_block_size;
 
   public:
-    LowPass(double sampling_rate, double cutoff_hz);
+    LowPass(double sampling_rate, double cutoff_hz,
+            FilterTopology topology = FilterTopology::Biquad);
     ~LowPass();
     LowPass(LowPass&&) = default;
     LowPass& operator=(LowPass&&) = default;
 
     void reset(double sampling_rate, double cutoff_hz);
+    // Sweeps to the new cutoff over |num_samples|, see
+    // SecondOrderFilter::ramp_to().
+    void ramp_to(double sampling_rate, double cutoff_hz,
+                 std::size_t num_samples);
 
-    void process(std::span<float> input) { m_filter.process(input); }
+    void process(std::span<float> input) {
+        if (m_topology == FilterTopology::StateVariable) {
+            m_state_variable.process(input);
+        } else {
+            m_filter.process(input);
+        }
+    }
     void process_block(std::span<float> input) {
-        m_filter.process_block(input);
+        if (m_topology == FilterTopology::StateVariable) {
+            m_state_variable.process_block(input);
+        } else {
+            m_filter.process_block(input);
+        }
+    }
+
+    static SecondOrderFilter::Coefs coefs(double sampling_rate,
+                                          double cutoff_hz);
+    static SecondOrderFilter::PreciseCoefs precise_coefs(double sampling_rate,
+                                                         double cutoff_hz);
+    // As coefs(), for a NumericPolicy, which for floats it is. The numerator
+    // is also fixed up from the rounded poles so that its taps add up to
+    // exactly what passes DC at unity, where it rounds to only a few steps
+    // of a fixed point coefficient.
+    template <typename Policy>
+    static typename Policy::Coefs coefs(double sampling_rate,
+                                        double cutoff_hz) {
+        if constexpr (std::is_same_v<Policy, FloatPolicy>) {
+            return coefs(sampling_rate, cutoff_hz);
+        } else {
+            auto const precise = precise_coefs(sampling_rate, cutoff_hz);
+            auto const a1 = std::min(Policy::coef(precise.a1),
+                                     Policy::below(Policy::coef(2)));
+            auto a2 = Policy::coef(precise.a2);
+            auto dc = [&] {
+                return 1.0 - Policy::value(a1) - Policy::value(a2);
+            };
+            while (dc() <= 0) {
+                a2 = Policy::below(a2);
+            }
+            auto const b0 = Policy::coef(dc() / 4);
+            auto const b1 = Policy::coef(dc() - 2 * Policy::value(b0));
+            return {a1, a2, b0, b1, b0};
+        }
     }
 
   private:
@@ -26,7 +75,9 @@ class LowPass {
     LowPass& operator=(LowPass const&) = delete;
 
   private:
+    FilterTopology m_topology;
     SecondOrderFilter m_filter;
+    StateVariableFilter m_state_variable;
 };
 
 }  // namespace pwv
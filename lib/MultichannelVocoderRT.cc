@@ -0,0 +1,80 @@
+#include "MultichannelVocoderRT.h"
+
+#include "Denormals.h"
+#include "Kernels.h"
+#include "Vocoder.h"
+
+#include <array>
+#include <cassert>
+
+namespace pwv {
+
+MultichannelVocoderRT::MultichannelVocoderRT(double distance, int num_bands,
+                                             double sampling_rate,
+                                             std::size_t num_channels)
+    : m_carrier_bandpass(num_bands) {
+    assert(num_channels != 0 && num_channels <= k_max_channels);
+    for (std::size_t channel = 0; channel < num_channels; channel++) {
+        m_signal_bandpass.emplace_back(num_bands);
+        m_envelope_lowpass.emplace_back(num_bands);
+        m_output_bandpass.emplace_back(num_bands);
+    }
+
+    // Build the filters.
+    auto const bands = vocoder_bands(distance, num_bands, sampling_rate);
+    for (std::size_t band = 0; band < bands.size(); band++) {
+        m_carrier_bandpass.reset(band, bands[band].bandpass);
+        for (std::size_t channel = 0; channel < num_channels; channel++) {
+            m_signal_bandpass[channel].reset(band, bands[band].bandpass);
+            m_envelope_lowpass[channel].reset(band, bands[band].lowpass);
+            m_output_bandpass[channel].reset(band, bands[band].bandpass);
+        }
+    }
+}
+
+MultichannelVocoderRT::~MultichannelVocoderRT() {}
+
+void MultichannelVocoderRT::process(float const* signal, float const* carrier,
+                                    std::size_t num_frames, float* output) {
+    process(signal, carrier, nullptr, num_frames, output);
+}
+
+void MultichannelVocoderRT::process_analyzed(float const* signal,
+                                             float const* carrier_bands,
+                                             std::size_t num_frames,
+                                             float* output) {
+    process(signal, nullptr, carrier_bands, num_frames, output);
+}
+
+void MultichannelVocoderRT::process(float const* signal, float const* carrier,
+                                    float const* carrier_bands,
+                                    std::size_t num_frames, float* output) {
+    FlushDenormals const flush_denormals;
+    std::size_t const num_channels = m_signal_bandpass.size();
+    std::array<BiquadBankRefs, k_max_channels> signal_bandpass;
+    std::array<BiquadBankRefs, k_max_channels> envelope_lowpass;
+    std::array<BiquadBankRefs, k_max_channels> output_bandpass;
+    for (std::size_t channel = 0; channel < num_channels; channel++) {
+        signal_bandpass[channel] = m_signal_bandpass[channel].refs();
+        envelope_lowpass[channel] = m_envelope_lowpass[channel].refs();
+        output_bandpass[channel] = m_output_bandpass[channel].refs();
+    }
+    MultichannelBankRefs const banks{
+        m_carrier_bandpass.refs(), signal_bandpass.data(),
+        envelope_lowpass.data(), output_bandpass.data(), num_channels};
+    if (carrier_bands) {
+        kernels().vocoder_multichannel_analyzed(
+            banks, signal, carrier_bands, m_carrier_bandpass.stride(), output,
+            num_frames);
+    } else {
+        kernels().vocoder_multichannel(banks, signal, carrier, output,
+                                       num_frames);
+    }
+
+    // Need to scale it up a bit.
+    for (std::size_t i = 0; i < num_frames * num_channels; i++) {
+        output[i] *= 50;
+    }
+}
+
+}  // namespace pwv
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "BiquadBank.h"
+
+#include <vector>
+
+namespace pwv {
+
+// Realtime version for several channels of signal against one carrier, as
+// for a stereo stream. The signal and output are interleaved frames and are
+// read and written in place, and the carrier's band passes run once for all
+// of the channels. Each channel matches a VocoderRT of its own.
+class MultichannelVocoderRT {
+  public:
+    // |num_channels| is up to k_max_channels.
+    MultichannelVocoderRT(double distance, int num_bands, double sampling_rate,
+                          std::size_t num_channels);
+    ~MultichannelVocoderRT();
+
+    std::size_t num_channels() const { return m_signal_bandpass.size(); }
+
+    // |signal| and |output| hold |num_frames| frames of num_channels(), and
+    // |carrier| holds |num_frames| samples.
+    void process(float const* signal, float const* carrier,
+                 std::size_t num_frames, float* output);
+    // As above, with the carrier already split into these bands, laid out
+    // as CarrierAnalysis::bands().
+    void process_analyzed(float const* signal, float const* carrier_bands,
+                          std::size_t num_frames, float* output);
+
+  private:
+    MultichannelVocoderRT(MultichannelVocoderRT const&) = delete;
+    MultichannelVocoderRT& operator=(MultichannelVocoderRT const&) = delete;
+
+  private:
+    // Takes either the |carrier| or its |carrier_bands|, and leaves the other
+    // null.
+    void process(float const* signal, float const* carrier,
+                 float const* carrier_bands, std::size_t num_frames,
+                 float* output);
+
+  private:
+    // One lane per band.
+    BiquadBank m_carrier_bandpass;
+    // Per channel.
+    std::vector<BiquadBank> m_signal_bandpass;
+    std::vector<BiquadBank> m_envelope_lowpass;
+    std::vector<BiquadBank> m_output_bandpass;
+};
+
+}  // namespace pwv
@@ -0,0 +1,305 @@
+#include "MultirateVocoderRT.h"
+
+#include "BandPass.h"
+#include "Denormals.h"
+#include "Kernels.h"
+#include "LowPass.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <span>
+
+namespace pwv {
+
+namespace {
+
+// Most samples processed at the full rate in one go, which sizes the buffers.
+constexpr std::size_t k_max_chunk = 256;
+
+// The upper edge of a band is kept below this fraction of the rate it runs at,
+// which leaves room for its skirt below the halfband's passband edge.
+constexpr double k_max_band_fraction = 0.2;
+
+// Halfband lowpass: apart from the centre tap of 1/2, only the taps an odd
+// distance from the centre are non-zero. Passes up to 0.15 and stops from
+// 0.35 of the faster rate.
+constexpr std::size_t k_halfband_taps = 6;
+constexpr std::size_t k_halfband_centre = 2 * k_halfband_taps - 1;
+constexpr std::size_t k_decimate_history = 2 * k_halfband_centre;
+constexpr std::size_t k_interpolate_history = k_halfband_centre;
+static_assert(k_halfband_taps <= k_max_halfband_taps);
+
+using HalfBand = std::array<float, k_halfband_taps>;
+
+// Kaiser windowed sinc. Entry k is the tap 2k + 1 either side of the centre.
+HalfBand design_halfband() {
+    double const beta = 7;
+    double const window_scale = 1 / std::cyl_bessel_i(0, beta);
+    std::array<double, k_halfband_taps> taps;
+    double total = 0;
+    for (std::size_t k = 0; k < k_halfband_taps; k++) {
+        double const offset = 2 * k + 1;
+        double const x = offset / k_halfband_centre;
+        double const window =
+            std::cyl_bessel_i(0, beta * std::sqrt(1 - x * x)) * window_scale;
+        double const sinc = std::sin(M_PI * offset / 2) / (M_PI * offset / 2);
+        taps[k] = 0.5 * sinc * window;
+        total += 2 * taps[k];
+    }
+
+    // Unity gain at DC.
+    HalfBand result;
+    for (std::size_t k = 0; k < k_halfband_taps; k++) {
+        result[k] = static_cast<float>(taps[k] * 0.5 / total);
+    }
+    return result;
+}
+
+HalfBand const& halfband() {
+    static HalfBand const taps = design_halfband();
+    return taps;
+}
+
+// BandPass::coefs() narrows the band the closer it gets to Nyquist, so adjust
+// q to keep the bandwidth it has at |sampling_rate| when running at |rate|.
+double matching_q(double q, double hz, double sampling_rate, double rate) {
+    auto narrowing = [hz](double rate) {
+        double const omega = 2 * M_PI * hz / rate;
+        return std::sin(omega) / omega;
+    };
+    return q * narrowing(rate) / narrowing(sampling_rate);
+}
+
+// Rough cost of splitting both inputs down a group and interpolating the
+// output back up, per sample at the faster rate, relative to running a vector
+// of bands for a sample.
+constexpr double k_resample_cost = 0.25;
+
+// Picks the depth of each band, lowest first, given the deepest each one may
+// go. Deeper groups are cheaper per band but are run a whole vector of bands
+// at a time, so a few bands are better left with the faster ones.
+std::vector<std::size_t> choose_depths(
+    std::span<std::size_t const> max_depths) {
+    constexpr std::size_t k_num_groups = MultirateVocoderRT::k_max_depth + 1;
+    using Counts = std::array<std::size_t, k_num_groups>;
+
+    // The lowest limits[depth] bands may run at that depth.
+    Counts limits{};
+    for (std::size_t depth = 0; depth < k_num_groups; depth++) {
+        limits[depth] = std::count_if(
+            max_depths.begin(), max_depths.end(),
+            [depth](std::size_t max_depth) { return max_depth >= depth; });
+    }
+
+    auto cost = [](Counts const& counts) {
+        double total = 0;
+        bool deeper = false;
+        for (std::size_t depth = k_num_groups; depth-- > 0;) {
+            std::size_t const vectors =
+                (counts[depth] + k_max_lanes - 1) / k_max_lanes;
+            total += static_cast<double>(vectors) / (1 << depth);
+            deeper = deeper || counts[depth] != 0;
+            if (deeper && depth != 0) {
+                total += k_resample_cost * 2 / (1 << depth);
+            }
+        }
+        return total;
+    };
+
+    // Try every split, deepest group first. Ties go to the shallower split
+    // since it has less latency.
+    Counts counts{};
+    Counts best{};
+    double best_cost = std::numeric_limits<double>::infinity();
+    auto search = [&](auto& self, std::size_t depth, std::size_t start) {
+        if (depth == 0) {
+            counts[0] = max_depths.size() - start;
+            if (double const total = cost(counts); total < best_cost) {
+                best_cost = total;
+                best = counts;
+            }
+            return;
+        }
+        for (std::size_t end = start; end <= std::max(start, limits[depth]);
+             end++) {
+            counts[depth] = end - start;
+            self(self, depth - 1, end);
+        }
+    };
+    search(search, k_num_groups - 1, 0);
+
+    std::vector<std::size_t> depths;
+    for (std::size_t depth = k_num_groups; depth-- > 0;) {
+        depths.insert(depths.end(), best[depth], depth);
+    }
+    return depths;
+}
+
+// Moves the last |history| of the |history| + |count| samples at the front of
+// |buffer| back to the start, ready for the next chunk.
+void keep_history(std::vector<float>& buffer, std::size_t history,
+                  std::size_t count) {
+    std::copy_n(buffer.begin() + count, history, buffer.begin());
+}
+
+}  // namespace
+
+MultirateVocoderRT::MultirateVocoderRT(double distance, int num_bands,
+                                       double sampling_rate) {
+    // Find the slowest group that could hold each band.
+    auto const bands = vocoder_bands(distance, num_bands, sampling_rate);
+    double const q = BandPass::approximate_q(sampling_rate, num_bands);
+    std::vector<std::size_t> max_depths;
+    for (auto const& band : bands) {
+        double const upper_hz = band.hz * (1 + 1 / q);
+        std::size_t depth = 0;
+        while (depth < k_max_depth &&
+               upper_hz <= k_max_band_fraction * sampling_rate /
+                               (std::size_t{2} << depth)) {
+            depth++;
+        }
+        max_depths.push_back(depth);
+    }
+    auto const depths = choose_depths(max_depths);
+    std::size_t const max_depth =
+        depths.empty() ? 0 : *std::max_element(depths.begin(), depths.end());
+
+    // Build the filters at each group's rate.
+    m_groups.resize(max_depth + 1);
+    for (std::size_t depth = 0; depth <= max_depth; depth++) {
+        Group& group = m_groups[depth];
+        std::size_t const group_bands =
+            std::count(depths.begin(), depths.end(), depth);
+        group.signal_bandpass.resize(group_bands);
+        group.carrier_bandpass.resize(group_bands);
+        group.envelope_lowpass.resize(group_bands);
+        group.output_bandpass.resize(group_bands);
+
+        double const rate = sampling_rate / (1 << depth);
+        std::size_t index = 0;
+        for (std::size_t band = 0; band < bands.size(); band++) {
+            if (depths[band] != depth) {
+                continue;
+            }
+            double const hz = bands[band].hz;
+            auto const bandpass = BandPass::coefs(
+                rate, hz, matching_q(q, hz, sampling_rate, rate));
+            group.signal_bandpass.reset(index, bandpass);
+            group.carrier_bandpass.reset(index, bandpass);
+            group.output_bandpass.reset(index, bandpass);
+            group.envelope_lowpass.reset(
+                index, LowPass::coefs(rate, hz / distance));
+            index++;
+        }
+
+        std::size_t const max_count = k_max_chunk >> depth;
+        group.signal.resize(k_decimate_history + max_count);
+        group.carrier.resize(k_decimate_history + max_count);
+        group.output.resize(k_interpolate_history + max_count);
+    }
+
+    // Each step down to a slower group and back up again delays it by the
+    // halfband's centre tap at the faster rate, on the way down and up.
+    std::size_t delay = 0;
+    for (std::size_t depth = max_depth; depth-- > 0;) {
+        delay = 2 * (k_halfband_centre + delay);
+        m_groups[depth].delay.resize(delay);
+    }
+    m_latency = delay;
+}
+
+MultirateVocoderRT::~MultirateVocoderRT() {}
+
+std::size_t MultirateVocoderRT::num_bands(std::size_t depth) const {
+    return depth < m_groups.size() ? m_groups[depth].signal_bandpass.size()
+                                   : 0;
+}
+
+void MultirateVocoderRT::process(float const* signal, float const* carrier,
+                                 std::size_t count, float* output) {
+    FlushDenormals const flush_denormals;
+    assert((count % k_block_size) == 0);
+    static_assert(k_max_chunk % k_block_size == 0);
+    for (std::size_t i = 0; i < count; i += k_max_chunk) {
+        std::size_t const chunk = std::min(count - i, k_max_chunk);
+        process_chunk(signal + i, carrier + i, chunk, output + i);
+    }
+}
+
+void MultirateVocoderRT::process_chunk(float const* signal,
+                                       float const* carrier, std::size_t count,
+                                       float* output) {
+    Kernels const& kernels = pwv::kernels();
+    HalfBand const& taps = halfband();
+
+    // Split the inputs down into every group.
+    std::copy_n(signal, count,
+                m_groups[0].signal.begin() + k_decimate_history);
+    std::copy_n(carrier, count,
+                m_groups[0].carrier.begin() + k_decimate_history);
+    for (std::size_t depth = 1; depth < m_groups.size(); depth++) {
+        Group const& faster = m_groups[depth - 1];
+        Group& group = m_groups[depth];
+        std::size_t const group_count = count >> depth;
+        kernels.halfband_decimate(
+            taps.data(), taps.size(), faster.signal.data() + k_decimate_history,
+            group.signal.data() + k_decimate_history, group_count);
+        kernels.halfband_decimate(
+            taps.data(), taps.size(),
+            faster.carrier.data() + k_decimate_history,
+            group.carrier.data() + k_decimate_history, group_count);
+    }
+
+    // Run the bands and sum back up from the slowest group.
+    for (std::size_t depth = m_groups.size(); depth-- > 0;) {
+        Group& group = m_groups[depth];
+        std::size_t const group_count = count >> depth;
+        float* const group_output =
+            group.output.data() + k_interpolate_history;
+
+        if (group.signal_bandpass.size() != 0) {
+            VocoderBankRefs const banks{
+                group.signal_bandpass.refs(), group.carrier_bandpass.refs(),
+                group.envelope_lowpass.refs(), group.output_bandpass.refs()};
+            kernels.vocoder(banks, group.signal.data() + k_decimate_history,
+                            group.carrier.data() + k_decimate_history,
+                            group_output, group_count, VocoderRT::k_tile_size,
+                            1);
+        } else {
+            std::fill_n(group_output, group_count, 0.0f);
+        }
+
+        if (!group.delay.empty()) {
+            for (std::size_t i = 0; i < group_count; i++) {
+                std::swap(group_output[i], group.delay[group.delay_index]);
+                if (++group.delay_index == group.delay.size()) {
+                    group.delay_index = 0;
+                }
+            }
+        }
+
+        if (depth + 1 < m_groups.size()) {
+            Group& slower = m_groups[depth + 1];
+            kernels.halfband_interpolate_add(
+                taps.data(), taps.size(),
+                slower.output.data() + k_interpolate_history, group_output,
+                group_count / 2);
+            keep_history(slower.output, k_interpolate_history, group_count / 2);
+        }
+
+        // The inputs are done with once the next group has been split off.
+        keep_history(group.signal, k_decimate_history, group_count);
+        keep_history(group.carrier, k_decimate_history, group_count);
+    }
+
+    // Need to scale it up a bit.
+    float* const result = m_groups[0].output.data() + k_interpolate_history;
+    for (std::size_t i = 0; i < count; i++) {
+        output[i] = result[i] * 50;
+    }
+}
+
+}  // namespace pwv
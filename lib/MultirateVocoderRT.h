@@ -0,0 +1,70 @@
+#pragma once
+
+#include "BiquadBank.h"
+#include "Vocoder.h"
+
+#include <vector>
+
+namespace pwv {
+
+// Realtime version that runs the low bands at a reduced rate. The inputs are
+// split into octave groups by repeatedly halving the rate with a halfband
+// filter, the low bands run in the slower groups where that saves work, and
+// the group outputs are interpolated back up and summed. Faster groups are
+// delayed to line up with the slower ones, so the output lags by latency()
+// samples.
+class MultirateVocoderRT final : public IVocoderRT {
+  public:
+    static constexpr std::size_t k_block_size = 16;
+    // The slowest group runs at 1/2^k_max_depth of the rate.
+    static constexpr std::size_t k_max_depth = 3;
+    static_assert(k_block_size % (1 << k_max_depth) == 0);
+
+  public:
+    MultirateVocoderRT(double distance, int num_bands, double sampling_rate);
+    ~MultirateVocoderRT() override;
+
+    std::size_t block_size() const override { return k_block_size; }
+    std::size_t latency() const override { return m_latency; }
+
+    void process(float const* signal, float const* carrier, std::size_t count,
+                 float* output) override;
+
+    // Number of bands running at 1/2^depth of the rate.
+    std::size_t num_bands(std::size_t depth) const;
+
+  private:
+    MultirateVocoderRT(MultirateVocoderRT const&) = delete;
+    MultirateVocoderRT& operator=(MultirateVocoderRT const&) = delete;
+
+  private:
+    void process_chunk(float const* signal, float const* carrier,
+                       std::size_t count, float* output);
+
+  private:
+    // The bands running at one rate.
+    struct Group {
+        // One lane per band.
+        BiquadBank signal_bandpass;
+        BiquadBank carrier_bandpass;
+        BiquadBank envelope_lowpass;
+        BiquadBank output_bandpass;
+
+        // Inputs at this rate, after the history the decimator needs.
+        std::vector<float> signal;
+        std::vector<float> carrier;
+        // Sum of this group and every slower one, after the history the
+        // interpolator needs.
+        std::vector<float> output;
+
+        // Lines this group up with the slower ones.
+        std::vector<float> delay;
+        std::size_t delay_index = 0;
+    };
+
+    // Fastest first, down to the slowest group with any bands.
+    std::vector<Group> m_groups;
+    std::size_t m_latency = 0;
+};
+
+}  // namespace pwv
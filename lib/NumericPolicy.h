@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Kernels.h"
+#include "SecondOrderFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace pwv {
+
+// The arithmetic a filter runs in, for BasicBiquadBank, BasicVocoderRT and the
+// coefs<Policy>() of BandPass and LowPass. Samples come in and go out as
+// Sample, and run through the filters as State.
+//
+// The floating point policies are what they look like: floats are what
+// VocoderRT runs in, and doubles what it runs its lowest bands in. The fixed
+// point ones take 32 or 16 bit samples, and run everything in the formats of
+// the integer kernels (see Kernels.h): state in Q4.27, coefficients in Q2.29,
+// and products and sums in 64 bits (Accum), rounded and saturated on the way
+// back down. That leaves the state room to ring past full scale, and the
+// coefficients fine enough steps near 2 for the lowest bands.
+//
+// There's no Q15 arithmetic. With 16 bit coefficients, the bandpasses of
+// the lowest bands round to poles on the unit circle at DC, and at 44.1 kHz
+// every envelope follower under about 25 Hz rounds to a pole at 1, so they
+// stop filtering at all. 16 bit samples only change how they come in and go
+// out.
+
+template <typename T>
+struct FloatingPolicy {
+    using Sample = T;
+    using Coef = T;
+    using State = T;
+    using Coefs = BiquadCoefs<Coef>;
+
+    static Coef coef(double value) { return static_cast<Coef>(value); }
+    static double value(Coef coef) { return coef; }
+    // Next coefficient down.
+    static Coef below(Coef coef) {
+        return std::nextafter(coef, -std::numeric_limits<Coef>::infinity());
+    }
+};
+
+using FloatPolicy = FloatingPolicy<float>;
+using DoublePolicy = FloatingPolicy<double>;
+
+namespace fixed_point {
+
+constexpr int32_t saturate(int64_t value) {
+    return static_cast<int32_t>(
+        std::clamp<int64_t>(value, std::numeric_limits<int32_t>::min(),
+                            std::numeric_limits<int32_t>::max()));
+}
+
+// Rounds off the low |shift| bits, and saturates.
+constexpr int32_t narrow(int64_t value, int shift) {
+    return saturate((value + (int64_t{1} << (shift - 1))) >> shift);
+}
+
+// What narrow() left off |value| to get |narrowed|, or nothing where it
+// saturated.
+constexpr int32_t residual(int64_t value, int32_t narrowed, int shift) {
+    int64_t const half = int64_t{1} << (shift - 1);
+    return static_cast<int32_t>(std::clamp<int64_t>(
+        value - (int64_t{narrowed} << shift), -half, half));
+}
+
+}  // namespace fixed_point
+
+template <typename SampleT>
+struct FixedPolicy {
+    using Sample = SampleT;
+    using Coef = int32_t;
+    using State = int32_t;
+    using Accum = int64_t;
+    using Coefs = BiquadCoefs<Coef>;
+
+    // Fractional bits of a Sample, and how far up a State is from one.
+    static constexpr int k_sample_bits = 8 * sizeof(Sample) - 1;
+    static constexpr int k_shift = k_fixed_state_bits - k_sample_bits;
+    // RMS error of a BasicVocoderRT in this arithmetic against VocoderRT
+    // with every band in doubles, relative to the RMS of that, at 44.1 and
+    // 48 kHz and up to 80 bands. It's highest at 80 bands, up to 1.6e-3;
+    // up to 40 bands it's under 5.5e-4.
+    static constexpr double k_vocoder_error = 2e-3;
+
+    static Sample from_float(float x) {
+        return static_cast<Sample>(std::clamp<double>(
+            std::round(std::ldexp(static_cast<double>(x), k_sample_bits)),
+            std::numeric_limits<Sample>::min(),
+            std::numeric_limits<Sample>::max()));
+    }
+    static float to_float(Sample x) {
+        return static_cast<float>(std::ldexp(static_cast<double>(x), -k_sample_bits));
+    }
+    static State from_sample(Sample x) {
+        if constexpr (k_shift >= 0) {
+            return static_cast<State>(x) << k_shift;
+        } else {
+            return fixed_point::narrow(x, -k_shift);
+        }
+    }
+    static Sample to_sample(State x) {
+        int64_t scaled;
+        if constexpr (k_shift >= 0) {
+            scaled = fixed_point::narrow(x, k_shift);
+        } else {
+            scaled = int64_t{x} << -k_shift;
+        }
+        return static_cast<Sample>(
+            std::clamp<int64_t>(scaled, std::numeric_limits<Sample>::min(),
+                                std::numeric_limits<Sample>::max()));
+    }
+
+    static Coef coef(double value) {
+        return fixed_point::saturate(
+            std::llround(std::ldexp(value, k_fixed_coef_bits)));
+    }
+    static double value(Coef coef) {
+        return std::ldexp(static_cast<double>(coef), -k_fixed_coef_bits);
+    }
+    static Coef below(Coef coef) { return coef - 1; }
+
+    // As the integer kernels do it, with what rounding left off the last
+    // output in |error| fed back into this one, and this one's left there.
+    // Without it, the rounding of a pair of poles close to DC adds up to
+    // more than an envelope follower's output. The sum stays in range for
+    // any stable filter.
+    static State biquad(BiquadCoefs<Coef> const& coefs, State x, State x1,
+                        State x2, State y1, State y2, int32_t& error) {
+        int64_t const sum = int64_t{coefs.b0} * x + int64_t{coefs.b1} * x1 +
+                            int64_t{coefs.b2} * x2 + int64_t{coefs.a1} * y1 +
+                            int64_t{coefs.a2} * y2 + error;
+        State const y = fixed_point::narrow(sum, k_fixed_coef_bits);
+        error = fixed_point::residual(sum, y, k_fixed_coef_bits);
+        return y;
+    }
+    static State abs(State x) {
+        return std::abs(std::max(x, -std::numeric_limits<State>::max()));
+    }
+    static State mul(State a, State b) {
+        return fixed_point::narrow(int64_t{a} * b, k_fixed_state_bits);
+    }
+    static Sample output(Accum sum, int gain) {
+        return to_sample(fixed_point::saturate(sum * gain));
+    }
+};
+
+using Q31Policy = FixedPolicy<int32_t>;
+// Q31 arithmetic on the 16 bit samples of a WAV file (see load_wav_int16()).
+using Q31Int16Policy = FixedPolicy<int16_t>;
+
+}  // namespace pwv
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "SecondOrderFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pwv {
+
+// Second order filter in doubles, a sample at a time. The reference for how
+// far rounding to floats throws a design off, which PreciseBiquadBank runs in
+// SIMD lanes for the bands it matters to.
+class PreciseFilter {
+  public:
+    using Coefs = SecondOrderFilter::PreciseCoefs;
+
+  public:
+    // Starts from rest.
+    void reset(Coefs const& coefs) {
+        m_coefs = coefs;
+        clear();
+    }
+    // Keeps the state.
+    void set_coefs(Coefs const& coefs) { m_coefs = coefs; }
+
+    double operator()(double x) {
+        double const y = m_coefs.b0 * x + m_coefs.b1 * m_x1 +
+                         m_coefs.b2 * m_x2 + m_coefs.a1 * m_y1 +
+                         m_coefs.a2 * m_y2;
+        m_x2 = m_x1;
+        m_x1 = x;
+        m_y2 = m_y1;
+        m_y1 = y;
+        return y;
+    }
+
+    void clear() { m_x1 = m_x2 = m_y1 = m_y2 = 0; }
+    // Largest magnitude in the state.
+    double peak_state() const {
+        return std::max({std::abs(m_x1), std::abs(m_x2), std::abs(m_y1),
+                         std::abs(m_y2)});
+    }
+
+  private:
+    Coefs m_coefs{};
+    double m_x1 = 0;
+    double m_x2 = 0;
+    double m_y1 = 0;
+    double m_y2 = 0;
+};
+
+}  // namespace pwv
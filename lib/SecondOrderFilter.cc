@@ -1,13 +1,20 @@
 #include "SecondOrderFilter.h"
 
+#include "Denormals.h"
+#include "Kernels.h"
+
 #include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <vector>
+#include <complex>
+#include <limits>
 
 namespace pwv {
 
-SecondOrderFilter::SecondOrderFilter() { reset(0, 0, 0, 0, 0); }
+SecondOrderFilter::SecondOrderFilter()
+    : m_lookahead(std::make_unique<Lookahead>()) {
+    reset(0, 0, 0, 0, 0);
+}
 
 SecondOrderFilter::~SecondOrderFilter() {}
 
@@ -21,66 +28,248 @@ void SecondOrderFilter::reset(Coef a1, Coef a2, Coef b0, Coef b1, Coef b2) {
     // Clear prior state.
     std::fill(std::begin(m_x), std::end(m_x), 0);
     std::fill(std::begin(m_y), std::end(m_y), 0);
+    m_ramp_remaining = 0;
+    m_lookahead_built = 0;
 }
 
-void SecondOrderFilter::process(std::span<float> input) {
-    using Accumulator = Coef;
-    std::vector<float> output(input.size());
+void SecondOrderFilter::ramp_to(Coefs const& coefs, std::size_t num_samples) {
+    if (m_ramp_remaining != 0) {
+        // Carry on from wherever the last ramp has got to.
+        Coef const k = static_cast<Coef>(m_ramp_done);
+        m_a1 = m_ramp_from.a1 + m_ramp_step.a1 * k;
+        m_a2 = m_ramp_from.a2 + m_ramp_step.a2 * k;
+        m_b0 = m_ramp_from.b0 + m_ramp_step.b0 * k;
+        m_b1 = m_ramp_from.b1 + m_ramp_step.b1 * k;
+        m_b2 = m_ramp_from.b2 + m_ramp_step.b2 * k;
+    }
+    m_ramp_target = coefs;
+    m_ramp_remaining = num_samples;
+    if (num_samples == 0) {
+        m_a1 = coefs.a1;
+        m_a2 = coefs.a2;
+        m_b0 = coefs.b0;
+        m_b1 = coefs.b1;
+        m_b2 = coefs.b2;
+        m_lookahead_built = 0;
+        return;
+    }
 
-    // Apply the filter.
-    // TODO: optimize
-    for (std::size_t i = 0; i < input.size(); i++) {
-        Accumulator sample = 0;
-        sample += m_b0 * input[i];
-        sample += m_b1 * (i < 1 ? m_x[i + 1] : input[i - 1]);
-        sample += m_b2 * (i < 2 ? m_x[i + 0] : input[i - 2]);
-        sample += m_a1 * (i < 1 ? m_y[i + 1] : output[i - 1]);
-        sample += m_a2 * (i < 2 ? m_y[i + 0] : output[i - 2]);
-        output[i] = sample;
+    // The look-ahead matrix is only rebuilt at the end, so the ramp runs
+    // serially.
+    Coef const scale = Coef{1} / num_samples;
+    m_ramp_from = {m_a1, m_a2, m_b0, m_b1, m_b2};
+    m_ramp_step = {(coefs.a1 - m_a1) * scale, (coefs.a2 - m_a2) * scale,
+                   (coefs.b0 - m_b0) * scale, (coefs.b1 - m_b1) * scale,
+                   (coefs.b2 - m_b2) * scale};
+    m_ramp_done = 0;
+}
+
+bool SecondOrderFilter::build_lookahead() {
+    Coef const a1 = m_a1, a2 = m_a2, b0 = m_b0, b1 = m_b1, b2 = m_b2;
+    auto& h = m_lookahead->h;
+    auto& g = m_lookahead->g;
+
+    // Unroll the recursion k_lookahead samples ahead. With h[] the impulse
+    // response of the poles and g[] that of the whole filter, output k of a
+    // step starting at n is:
+    //   y[n+k] = sum_j g[k-j] x[n+j]
+    //          + (b1 h[k] + b2 h[k-1]) x[n-1] + b2 h[k] x[n-2]
+    //          + h[k+1] y[n-1] + a2 h[k] y[n-2]
+    // which only depends on the previous step through y[n-1] and y[n-2].
+    // Low poles sit near z=1, where h[k+1] and a2 h[k] nearly cancel, so the
+    // last two terms are rewritten in terms of y[n-1] and y[n-1] - y[n-2] to
+    // keep the float rounding down.
+    if (m_lookahead_built == 0) {
+        for (std::size_t k = 0; k <= k_lookahead; k++) {
+            double const h1 = k >= 1 ? h[k - 1] : 0;
+            double const h2 = k >= 2 ? h[k - 2] : 0;
+            h[k] = k == 0 ? 1 : double{a1} * h1 + double{a2} * h2;
+            if (k < k_lookahead) {
+                g[k] = double{b0} * h[k] + double{b1} * h1 + double{b2} * h2;
+            }
+        }
+    }
+    std::size_t const end = std::min(
+        m_lookahead_built + k_lookahead_build_columns, k_lookahead_columns);
+    for (std::size_t j = m_lookahead_built; j < end; j++) {
+        auto const column =
+            std::span{m_lookahead->matrix}.subspan(j * k_lookahead, k_lookahead);
+        for (std::size_t k = 0; k < k_lookahead; k++) {
+            switch (j) {
+                case k_lookahead_x1:
+                    column[k] = b1 * h[k] + (k >= 1 ? b2 * h[k - 1] : 0);
+                    break;
+                case k_lookahead_x2:
+                    column[k] = b2 * h[k];
+                    break;
+                case k_lookahead_y1:
+                    column[k] = h[k + 1] + a2 * h[k];
+                    break;
+                case k_lookahead_dy:
+                    column[k] = -a2 * h[k];
+                    break;
+                default:
+                    column[k] = k >= j ? g[k - j] : 0;
+                    break;
+            }
+        }
     }
+    m_lookahead_built = end;
+    return m_lookahead_built == k_lookahead_columns;
+}
 
-    // Save state that can be referenced on next loop.
-    m_x[1] = input[input.size() - 1];
-    m_x[0] = input[input.size() - 2];
-    m_y[1] = output[output.size() - 1];
-    m_y[0] = output[output.size() - 2];
+SecondOrderFilter::Coefs SecondOrderFilter::round(PreciseCoefs const& coefs) {
+    return {static_cast<Coef>(coefs.a1), static_cast<Coef>(coefs.a2),
+            static_cast<Coef>(coefs.b0), static_cast<Coef>(coefs.b1),
+            static_cast<Coef>(coefs.b2)};
+}
+
+double SecondOrderFilter::pole_radius(double a1, double a2) {
+    // The poles are the roots of z^2 - a1 z - a2.
+    double const discriminant = a1 * a1 + 4 * a2;
+    return discriminant < 0 ? std::sqrt(-a2)
+                            : (std::abs(a1) + std::sqrt(discriminant)) / 2;
+}
 
-    // TODO: don't use a temporary buffer, cache it, or return it
-    std::copy(output.begin(), output.end(), input.begin());
+double SecondOrderFilter::rounding_error(PreciseCoefs const& coefs,
+                                         double omega) {
+    // Rounding the coefficients, and the sum fed back each sample, moves the
+    // denominator by about the unit roundoff, which is 2^-24 next to the
+    // a1 and a2 of poles near the unit circle. The gain moves by that much
+    // relative to the denominator's magnitude at |omega|, which is tiny
+    // around a pole that's close to both it and the circle.
+    std::complex<double> const z1 = std::polar(1.0, -omega);
+    double const denominator =
+        std::abs(1.0 - coefs.a1 * z1 - coefs.a2 * z1 * z1);
+    return std::numeric_limits<Coef>::epsilon() / 2 / denominator;
+}
+
+std::size_t SecondOrderFilter::decay_length(Coefs const& coefs,
+                                            double level) {
+    double const radius = pole_radius(coefs.a1, coefs.a2);
+    if (radius <= 0) {
+        return 0;
+    }
+    if (radius >= 1) {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    return static_cast<std::size_t>(
+        std::ceil(std::log(level) / std::log(radius)));
+}
+
+void SecondOrderFilter::process_serial(std::span<float> data) {
+    FlushDenormals const flush_denormals;
+    if (m_ramp_remaining != 0) {
+        data = run_ramp(data);
+    }
+    run(data);
+}
+
+void SecondOrderFilter::process_lookahead(std::span<float> data) {
+    FlushDenormals const flush_denormals;
+    if (m_ramp_remaining != 0) {
+        data = run_ramp(data);
+    }
+    std::size_t const num_steps = data.size() / k_lookahead;
+    if (num_steps != 0) {
+        if (m_lookahead_built != k_lookahead_columns && !build_lookahead()) {
+            run(data);
+            return;
+        }
+        kernels().lookahead(m_lookahead->matrix.data(), m_x, m_y,
+                            data.data(), num_steps);
+    }
+
+    // Finish off anything that doesn't fill a step.
+    run(data.subspan(num_steps * k_lookahead));
 }
 
 void SecondOrderFilter::process_block(std::span<float> data) {
+    FlushDenormals const flush_denormals;
     assert(data.size() == k_block_size);
+    if (m_ramp_remaining != 0) {
+        run(run_ramp(data));
+        return;
+    }
+    run(data.first<k_block_size>());
+}
+
+template <std::size_t Extent>
+void SecondOrderFilter::run(std::span<float, Extent> data) {
     using Accumulator = Coef;
 
-    // Store the last 2 values + space for the current block.
-    std::array<float, k_block_size + 2> output{};
-    output[0] = m_y[0];
-    output[1] = m_y[1];
-    std::array<float, k_block_size + 2> input{};
-    input[0] = m_x[0];
-    input[1] = m_x[1];
-    std::copy_n(data.data(), k_block_size, input.data() + 2);
-
-    // Apply the filter.
-    for (std::size_t i = 0; i < k_block_size; i++) {
+    // Pull everything into locals so that it can stay in registers rather
+    // than being reloaded after every store to |data|.
+    Coef const a1 = m_a1, a2 = m_a2, b0 = m_b0, b1 = m_b1, b2 = m_b2;
+    float x1 = m_x[1], x2 = m_x[0];
+    float y1 = m_y[1], y2 = m_y[0];
+
+    // Apply the filter in place.
+    for (float& value : data) {
+        float const input = value;
         Accumulator sample = 0;
-        sample += m_b0 * input[i + 2];
-        sample += m_b1 * input[i + 1];
-        sample += m_b2 * input[i + 0];
-        sample += m_a1 * output[i + 1];
-        sample += m_a2 * output[i + 0];
-        output[i + 2] = sample;
+        sample += b0 * input;
+        sample += b1 * x1;
+        sample += b2 * x2;
+        sample += a1 * y1;
+        sample += a2 * y2;
+        value = sample;
+
+        x2 = x1;
+        x1 = input;
+        y2 = y1;
+        y1 = sample;
     }
 
     // Save state that can be referenced on next loop.
-    m_x[0] = input[k_block_size + 0];
-    m_x[1] = input[k_block_size + 1];
-    m_y[0] = output[k_block_size + 0];
-    m_y[1] = output[k_block_size + 1];
+    m_x[1] = x1;
+    m_x[0] = x2;
+    m_y[1] = y1;
+    m_y[0] = y2;
+}
+
+std::span<float> SecondOrderFilter::run_ramp(std::span<float> data) {
+    std::size_t const count = std::min(data.size(), m_ramp_remaining);
+    Coefs const from = m_ramp_from, step = m_ramp_step;
+    float x1 = m_x[1], x2 = m_x[0];
+    float y1 = m_y[1], y2 = m_y[0];
+
+    // As run(), moving the coefficients on before each sample.
+    std::size_t done = m_ramp_done;
+    for (float& value : data.first(count)) {
+        Coef const k = static_cast<Coef>(++done);
+        Coef const a1 = from.a1 + step.a1 * k;
+        Coef const a2 = from.a2 + step.a2 * k;
+        Coef const b0 = from.b0 + step.b0 * k;
+        Coef const b1 = from.b1 + step.b1 * k;
+        Coef const b2 = from.b2 + step.b2 * k;
 
-    // Copy the result back.
-    std::copy_n(output.data() + 2, k_block_size, data.data());
+        float const input = value;
+        Coef sample = 0;
+        sample += b0 * input;
+        sample += b1 * x1;
+        sample += b2 * x2;
+        sample += a1 * y1;
+        sample += a2 * y2;
+        value = sample;
+
+        x2 = x1;
+        x1 = input;
+        y2 = y1;
+        y1 = sample;
+    }
+
+    m_x[1] = x1;
+    m_x[0] = x2;
+    m_y[1] = y1;
+    m_y[0] = y2;
+    m_ramp_done = done;
+    m_ramp_remaining -= count;
+    if (m_ramp_remaining == 0) {
+        // Land exactly on the target, and pick the look-ahead kernel back up.
+        ramp_to(m_ramp_target, 0);
+    }
+    return data.subspan(count);
 }
 
 }  // namespace pwv
@@ -1,13 +1,39 @@
 #pragma once
 
+#include "Kernels.h"
+
+#include <array>
+#include <memory>
 #include <span>
 
 namespace pwv {
 
+// Coefficients of a second order filter in any arithmetic, see
+// NumericPolicy.h.
+template <typename Coef>
+struct BiquadCoefs {
+    Coef a1, a2, b0, b1, b2;
+};
+
 class SecondOrderFilter {
   public:
     using Coef = float;
     static constexpr std::size_t k_block_size = 16;
+    // Columns of the look-ahead matrix built per call after the coefficients
+    // change, see process_lookahead().
+    static constexpr std::size_t k_lookahead_build_columns = 4;
+
+    using Coefs = BiquadCoefs<Coef>;
+    // As designed, before rounding to Coef.
+    using PreciseCoefs = BiquadCoefs<double>;
+    static Coefs round(PreciseCoefs const& coefs);
+    // As above, to a NumericPolicy's coefficients.
+    template <typename Policy>
+    static typename Policy::Coefs round(PreciseCoefs const& coefs) {
+        return {Policy::coef(coefs.a1), Policy::coef(coefs.a2),
+                Policy::coef(coefs.b0), Policy::coef(coefs.b1),
+                Policy::coef(coefs.b2)};
+    }
 
   public:
     SecondOrderFilter();
@@ -16,18 +42,79 @@ class SecondOrderFilter {
     SecondOrderFilter& operator=(SecondOrderFilter&&) = default;
 
     void reset(Coef a1, Coef a2, Coef b0, Coef b1, Coef b2);
+    void reset(Coefs const& coefs) {
+        reset(coefs.a1, coefs.a2, coefs.b0, coefs.b1, coefs.b2);
+    }
+
+    // Moves the coefficients linearly to |coefs| over the next |num_samples|
+    // processed, keeping the state, so that the filter can be swept without
+    // clicking. Stable filters stay stable along the way. At 0 it jumps
+    // straight there. Replaces any ramp under way.
+    void ramp_to(Coefs const& coefs, std::size_t num_samples);
+    bool ramping() const { return m_ramp_remaining != 0; }
+
+    // Any length is accepted, including empty spans.
+    void process(std::span<float> data) { process_lookahead(data); }
+    void process_block(std::span<float> data);
 
-    void process(std::span<float> input);
-    void process_block(std::span<float> input);
+    // Runs one sample at a time.
+    void process_serial(std::span<float> data);
+    // Runs k_lookahead samples at a time, finishing any tail serially. After
+    // the coefficients change, the next few calls run serially while each
+    // builds k_lookahead_build_columns of the matrix, so that no one call
+    // pays for all of it. Never allocates, as the matrix comes with the
+    // filter.
+    void process_lookahead(std::span<float> data);
+
+    // Number of samples for anything in the state to decay to |level| of
+    // where it started, going by the slowest pole.
+    static std::size_t decay_length(Coefs const& coefs, double level);
+    // Distance of the slowest pole from the origin.
+    static double pole_radius(double a1, double a2);
+    // Bound on how far rounding to Coef throws the filter's gain at |omega|
+    // off, relative to that gain.
+    static double rounding_error(PreciseCoefs const& coefs, double omega);
 
   private:
     SecondOrderFilter(SecondOrderFilter const&) = delete;
     SecondOrderFilter& operator=(SecondOrderFilter const&) = delete;
 
+    struct Lookahead {
+        std::array<float, k_lookahead * k_lookahead_columns> matrix;
+        // Impulse responses of the poles and of the whole filter, which the
+        // columns are built from.
+        std::array<double, k_lookahead + 1> h;
+        std::array<double, k_lookahead> g;
+    };
+
+    // Builds the next few columns of the look-ahead matrix from the current
+    // coefficients, and returns whether it's done.
+    bool build_lookahead();
+    template <std::size_t Extent>
+    void run(std::span<float, Extent> data);
+    // Runs what's left of the ramp over the start of |data|, and returns the
+    // rest of it.
+    std::span<float> run_ramp(std::span<float> data);
+
   private:
     Coef m_a1, m_a2, m_b0, m_b1, m_b2;
     float m_x[2];
     float m_y[2];
+
+    // Where the coefficients started and are headed, and their change per
+    // sample. Each sample's are worked out afresh from the start, so that
+    // rounding doesn't build up along the ramp.
+    Coefs m_ramp_from{};
+    Coefs m_ramp_target{};
+    Coefs m_ramp_step{};
+    std::size_t m_ramp_done = 0;
+    std::size_t m_ramp_remaining = 0;
+
+    // Block state-space form of the filter. Only built when it's next needed
+    // after the coefficients change, and only usable once all its columns
+    // are.
+    std::unique_ptr<Lookahead> m_lookahead;
+    std::size_t m_lookahead_built = 0;
 };
 
 }  // namespace pwv
@@ -0,0 +1,124 @@
+#include "SegmentedVocoder.h"
+
+#include "Denormals.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace pwv {
+
+SegmentedVocoder::SegmentedVocoder(double distance, int num_bands,
+                                   double sampling_rate,
+                                   std::size_t num_threads,
+                                   std::size_t segment_size)
+    : m_segment_size(segment_size),
+      m_pre_roll(Vocoder(distance, num_bands, sampling_rate)
+                     .pre_roll(k_settle_level)),
+      m_pool(num_threads) {
+    assert(segment_size != 0 && segment_size % Vocoder::k_chunk_size == 0);
+    for (std::size_t thread = 0; thread < num_threads; thread++) {
+        m_vocoders.push_back(
+            std::make_unique<Vocoder>(distance, num_bands, sampling_rate));
+        m_scratch.emplace_back(Vocoder::k_chunk_size);
+    }
+    if (continuous()) {
+        // Its threads go to the bands instead.
+        m_vocoders[0]->set_num_threads(num_threads);
+    } else {
+        m_signal.resize(m_pre_roll + max_count());
+        m_carrier.resize(m_pre_roll + max_count());
+    }
+}
+
+SegmentedVocoder::~SegmentedVocoder() {}
+
+std::size_t SegmentedVocoder::max_count() const {
+    return m_segment_size * m_pool.num_threads();
+}
+
+bool SegmentedVocoder::continuous() const {
+    // Segments that would be mostly pre-roll aren't worth it, and aren't
+    // possible if the filters never settle.
+    return m_pool.num_threads() == 1 || m_pre_roll >= m_segment_size;
+}
+
+void SegmentedVocoder::start() {
+    m_position = 0;
+
+    if (continuous()) {
+        m_vocoders[0]->start();
+    }
+}
+
+void SegmentedVocoder::process(std::span<float const> signal,
+                               std::span<float const> carrier,
+                               std::span<float> output) {
+    FlushDenormals const flush_denormals;
+    assert(signal.size() == carrier.size() && signal.size() == output.size());
+    assert(signal.size() <= max_count());
+    std::size_t const count = signal.size();
+
+    if (continuous()) {
+        Vocoder& vocoder = *m_vocoders[0];
+        for (std::size_t start = 0; start < count;
+             start += Vocoder::k_chunk_size) {
+            std::size_t const chunk =
+                std::min(count - start, Vocoder::k_chunk_size);
+            vocoder.process_chunk(signal.subspan(start, chunk),
+                                  carrier.subspan(start, chunk),
+                                  output.subspan(start, chunk));
+        }
+        m_position += count;
+        return;
+    }
+
+    std::copy(signal.begin(), signal.end(), m_signal.begin() + m_pre_roll);
+    std::copy(carrier.begin(), carrier.end(), m_carrier.begin() + m_pre_roll);
+
+    std::size_t const num_segments =
+        (count + m_segment_size - 1) / m_segment_size;
+    m_pool.run(num_segments, [&](std::size_t segment, std::size_t worker) {
+        std::size_t const start = segment * m_segment_size;
+        std::size_t const segment_count =
+            std::min(count - start, m_segment_size);
+        // The very start of the input has nothing before it, just like a
+        // single Vocoder.
+        std::size_t const pre_roll = std::min(m_pre_roll, m_position + start);
+        process_segment(*m_vocoders[worker], m_scratch[worker],
+                        m_pre_roll + start, segment_count, pre_roll,
+                        output.subspan(start, segment_count));
+    });
+
+    // Keep the end of the input for the next stretch's first pre-roll.
+    std::copy(m_signal.begin() + count, m_signal.begin() + count + m_pre_roll,
+              m_signal.begin());
+    std::copy(m_carrier.begin() + count,
+              m_carrier.begin() + count + m_pre_roll, m_carrier.begin());
+    m_position += count;
+}
+
+void SegmentedVocoder::process_segment(Vocoder& vocoder,
+                                       std::span<float> scratch,
+                                       std::size_t start, std::size_t count,
+                                       std::size_t pre_roll,
+                                       std::span<float> output) {
+    // Run from the start of the pre-roll, keeping only what comes after it.
+    vocoder.start();
+    std::size_t const first = start - pre_roll;
+    std::size_t const end = start + count;
+    for (std::size_t position = first; position < end;
+         position += Vocoder::k_chunk_size) {
+        std::size_t const chunk =
+            std::min(end - position, Vocoder::k_chunk_size);
+        std::span const chunk_output = scratch.first(chunk);
+        vocoder.process_chunk(std::span{m_signal}.subspan(position, chunk),
+                              std::span{m_carrier}.subspan(position, chunk),
+                              chunk_output);
+
+        std::size_t const keep_from = std::max(position, start);
+        std::copy(chunk_output.begin() + (keep_from - position),
+                  chunk_output.end(), output.begin() + (keep_from - start));
+    }
+}
+
+}  // namespace pwv
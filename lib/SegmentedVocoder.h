@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "Vocoder.h"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace pwv {
+
+// Offline renderer that splits the input into time segments and runs them at
+// once, a Vocoder per thread. Each segment starts pre_roll() samples early so
+// that the filters have forgotten their empty start by the time its output
+// is kept. With one thread, or segments too short for the pre-roll, it runs a
+// single Vocoder straight through instead.
+class SegmentedVocoder {
+  public:
+    // How far the filters must have decayed by the end of the pre-roll.
+    static constexpr double k_settle_level = 1e-4;
+
+  public:
+    // |segment_size| must be a multiple of Vocoder::k_chunk_size.
+    SegmentedVocoder(double distance, int num_bands, double sampling_rate,
+                     std::size_t num_threads, std::size_t segment_size);
+    ~SegmentedVocoder();
+
+    std::size_t pre_roll() const { return m_pre_roll; }
+    std::size_t segment_size() const { return m_segment_size; }
+    // A segment per thread.
+    std::size_t max_count() const;
+
+    // Call start(), and then process() on each stretch of input in turn.
+    // Every stretch but the last must be max_count() samples.
+    void start();
+    void process(std::span<float const> signal, std::span<float const> carrier,
+                 std::span<float> output);
+
+  private:
+    SegmentedVocoder(SegmentedVocoder const&) = delete;
+    SegmentedVocoder& operator=(SegmentedVocoder const&) = delete;
+
+  private:
+    bool continuous() const;
+    void process_segment(Vocoder& vocoder, std::span<float> scratch,
+                         std::size_t start, std::size_t count,
+                         std::size_t pre_roll, std::span<float> output);
+
+  private:
+    std::size_t const m_segment_size;
+    std::size_t const m_pre_roll;
+    ThreadPool m_pool;
+
+    // Per thread.
+    std::vector<std::unique_ptr<Vocoder>> m_vocoders;
+    std::vector<std::vector<float>> m_scratch;
+
+    // The last pre_roll() samples of input before the current stretch, and
+    // then the stretch itself.
+    std::vector<float> m_signal;
+    std::vector<float> m_carrier;
+    // Samples taken so far.
+    std::size_t m_position = 0;
+};
+
+}  // namespace pwv
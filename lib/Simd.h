@@ -0,0 +1,153 @@
+#pragma once
+
+// Only the per-target kernels may include this, since the vector width depends
+// on the flags the including file was built with.
+#ifndef PWV_KERNEL_TARGET
+#error "Simd.h is only for KernelsTarget.cc"
+#endif
+
+#include "Kernels.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pwv::PWV_KERNEL_TARGET::simd {
+
+// Widest float vector the current target supports.
+#if defined(__AVX512F__)
+static constexpr std::size_t k_lanes = 16;
+#elif defined(__AVX__)
+static constexpr std::size_t k_lanes = 8;
+#else
+static constexpr std::size_t k_lanes = 4;
+#endif
+static_assert(k_max_lanes % k_lanes == 0);
+
+using Vec = float __attribute__((vector_size(k_lanes * sizeof(float))));
+using IVec = int32_t __attribute__((vector_size(k_lanes * sizeof(int32_t))));
+using I16Vec = int16_t __attribute__((vector_size(k_lanes * sizeof(int16_t))));
+// Twice as wide as the target's vectors, so that the compiler splits it. That
+// only changes how it would be passed between functions built for other
+// targets, which it never is.
+#pragma GCC diagnostic ignored "-Wpsabi"
+using I64Vec = int64_t __attribute__((vector_size(k_lanes * sizeof(int64_t))));
+// As wide as a Vec, so half as many lanes.
+static constexpr std::size_t k_double_lanes = k_lanes / 2;
+using DVec = double __attribute__((vector_size(k_lanes * sizeof(float))));
+
+inline Vec load(float const* ptr) {
+    Vec vec;
+    std::memcpy(&vec, ptr, sizeof(vec));
+    return vec;
+}
+
+inline void store(float* ptr, Vec vec) { std::memcpy(ptr, &vec, sizeof(vec)); }
+
+inline Vec broadcast(float value) { return Vec{} + value; }
+
+inline Vec abs(Vec vec) { return vec < 0 ? -vec : vec; }
+
+inline Vec max(Vec a, Vec b) { return a > b ? a : b; }
+
+inline Vec clamp(Vec vec, float low, float high) {
+    vec = vec < low ? broadcast(low) : vec;
+    return vec > high ? broadcast(high) : vec;
+}
+
+inline bool any_at_least(Vec vec, float level) {
+    for (std::size_t lane = 0; lane < k_lanes; lane++) {
+        if (vec[lane] >= level) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline float sum(Vec vec) {
+    float total = 0;
+    for (std::size_t lane = 0; lane < k_lanes; lane++) {
+        total += vec[lane];
+    }
+    return total;
+}
+
+inline DVec load(double const* ptr) {
+    DVec vec;
+    std::memcpy(&vec, ptr, sizeof(vec));
+    return vec;
+}
+
+inline void store(double* ptr, DVec vec) {
+    std::memcpy(ptr, &vec, sizeof(vec));
+}
+
+inline DVec abs(DVec vec) { return vec < 0 ? -vec : vec; }
+
+// k_double_lanes floats, widened.
+inline DVec load_widened(float const* ptr) {
+    DVec vec{};
+    for (std::size_t lane = 0; lane < k_double_lanes; lane++) {
+        vec[lane] = ptr[lane];
+    }
+    return vec;
+}
+
+inline double sum(DVec vec) {
+    double total = 0;
+    for (std::size_t lane = 0; lane < k_double_lanes; lane++) {
+        total += vec[lane];
+    }
+    return total;
+}
+
+inline IVec load(int32_t const* ptr) {
+    IVec vec;
+    std::memcpy(&vec, ptr, sizeof(vec));
+    return vec;
+}
+
+inline void store(int32_t* ptr, IVec vec) {
+    std::memcpy(ptr, &vec, sizeof(vec));
+}
+
+inline I64Vec widen(IVec vec) { return __builtin_convertvector(vec, I64Vec); }
+
+// Rounds off the low |Shift| bits, and saturates to 32 bits, as
+// fixed_point::narrow() does.
+template <int Shift>
+inline IVec narrow(I64Vec vec) {
+    constexpr int64_t k_min = INT32_MIN;
+    constexpr int64_t k_max = INT32_MAX;
+    vec = (vec + (int64_t{1} << (Shift - 1))) >> Shift;
+    vec = vec < k_min ? I64Vec{} + k_min : vec;
+    vec = vec > k_max ? I64Vec{} + k_max : vec;
+    return __builtin_convertvector(vec, IVec);
+}
+
+// What narrow() left off |vec| to get |narrowed|, or nothing where it
+// saturated, as fixed_point::residual() does.
+template <int Shift>
+inline IVec residual(I64Vec vec, IVec narrowed) {
+    constexpr int64_t k_half = int64_t{1} << (Shift - 1);
+    vec -= widen(narrowed) << Shift;
+    vec = vec < -k_half ? I64Vec{} - k_half : vec;
+    vec = vec > k_half ? I64Vec{} + k_half : vec;
+    return __builtin_convertvector(vec, IVec);
+}
+
+// Saturates rather than wrapping at the most negative value.
+inline IVec abs(IVec vec) {
+    vec = vec < -INT32_MAX ? IVec{} - INT32_MAX : vec;
+    return vec < 0 ? -vec : vec;
+}
+
+inline int64_t sum(I64Vec vec) {
+    int64_t total = 0;
+    for (std::size_t lane = 0; lane < k_lanes; lane++) {
+        total += vec[lane];
+    }
+    return total;
+}
+
+}  // namespace pwv::PWV_KERNEL_TARGET::simd
@@ -0,0 +1,145 @@
+#include "SpinWorkers.h"
+
+#include "Denormals.h"
+
+#include <cassert>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace pwv {
+
+namespace {
+
+// Roughly a few hundred microseconds of waiting before giving up the core.
+constexpr std::size_t k_spin_count = 1 << 14;
+
+void pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+SpinWorkers::SpinWorkers(std::size_t num_threads) : m_next(num_threads) {
+    assert(num_threads != 0);
+    for (std::size_t worker = 1; worker < num_threads; worker++) {
+        m_threads.emplace_back([this] { work(); });
+    }
+}
+
+SpinWorkers::~SpinWorkers() {
+    m_stop = true;
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_generation.notify_all();
+    m_threads.clear();
+}
+
+void SpinWorkers::run(Task task, void* context) {
+    m_task = task;
+    m_context = context;
+    m_remaining.store(num_threads(), std::memory_order_relaxed);
+    m_next.store(0, std::memory_order_release);
+    m_generation.fetch_add(1, std::memory_order_release);
+    // Only costs a system call if some helper has gone to sleep.
+    m_generation.notify_all();
+
+    claim();
+
+    // Meet the helpers that claimed a piece. Give up the core now and then
+    // in case one of them shares it.
+    for (std::size_t spin = 1;
+         m_remaining.load(std::memory_order_acquire) != 0; spin++) {
+        if (spin % k_spin_count == 0) {
+            std::this_thread::yield();
+        } else {
+            pause();
+        }
+    }
+}
+
+void SpinWorkers::claim() {
+    std::size_t const num_pieces = num_threads();
+    while (true) {
+        // A helper that's late for the last run can get here after the next
+        // has started, and then works on that one, which is as good.
+        std::size_t const piece =
+            m_next.fetch_add(1, std::memory_order_acq_rel);
+        if (piece >= num_pieces) {
+            return;
+        }
+        m_task(m_context, piece);
+        m_remaining.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void SpinWorkers::bind_to_current_thread() {
+#ifdef __linux__
+    // Failure is fine: the helpers stay as they are and the caller picks up
+    // what they miss.
+    int policy = 0;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0) {
+        for (std::jthread& thread : m_threads) {
+            pthread_setschedparam(thread.native_handle(), policy, &param);
+        }
+    }
+
+    // The cores the caller may use, less its own, handed out in turn. Only
+    // worth it if there's one for every helper.
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed) !=
+        0) {
+        return;
+    }
+    int const own = sched_getcpu();
+    if (own >= 0) {
+        CPU_CLR(own, &allowed);
+    }
+    if (static_cast<std::size_t>(CPU_COUNT(&allowed)) < m_threads.size()) {
+        return;
+    }
+    int cpu = 0;
+    for (std::jthread& thread : m_threads) {
+        while (!CPU_ISSET(cpu, &allowed)) {
+            cpu++;
+        }
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(pinned),
+                               &pinned);
+        cpu++;
+    }
+#endif
+}
+
+void SpinWorkers::work() {
+    FlushDenormals const flush_denormals;
+    std::uint32_t generation = 0;
+    while (true) {
+        // Spin for the next run, then sleep until it comes.
+        std::size_t spin = 0;
+        while (m_generation.load(std::memory_order_acquire) == generation) {
+            if (spin++ < k_spin_count) {
+                pause();
+            } else {
+                m_generation.wait(generation, std::memory_order_acquire);
+            }
+        }
+        generation = m_generation.load(std::memory_order_acquire);
+        if (m_stop) {
+            return;
+        }
+
+        claim();
+    }
+}
+
+}  // namespace pwv
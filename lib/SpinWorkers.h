@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace pwv {
+
+// Helper threads for splitting work up inside a realtime callback. Handing
+// work out and waiting for it only touches atomics, so run() takes no locks
+// and allocates nothing. Helpers spin for a while after each run in case the
+// next one comes soon, and then sleep.
+//
+// The caller never waits on a helper that hasn't started: each run is split
+// into pieces that whoever is free claims, so a helper that's asleep or
+// preempted just leaves its piece to the caller. bind_to_current_thread()
+// gives the helpers the scheduling policy and priority of the thread that
+// will call run(), so that a realtime caller isn't left waiting on a piece a
+// normal thread has claimed.
+class SpinWorkers {
+  public:
+    using Task = void (*)(void* context, std::size_t worker);
+
+  public:
+    // |num_threads| includes the caller, so 1 runs everything inline.
+    explicit SpinWorkers(std::size_t num_threads);
+    ~SpinWorkers();
+
+    std::size_t num_threads() const { return m_threads.size() + 1; }
+
+    // Gives the helpers the calling thread's scheduling, and pins each to a
+    // core of its own out of those the caller may run on, other than the one
+    // it's on. Makes system calls, so call it from the thread that will call
+    // run() but before the realtime work starts, e.g. when a stream starts.
+    // Only a hint: without the rights, or the cores, the helpers stay as they
+    // are.
+    void bind_to_current_thread();
+
+    // Calls |task| once for each worker from 0 to num_threads() - 1, each on
+    // whichever thread claims it first, and spins until they've all
+    // returned.
+    void run(Task task, void* context);
+    template <typename F>
+    void run(F& task) {
+        run([](void* context,
+               std::size_t worker) { (*static_cast<F*>(context))(worker); },
+            &task);
+    }
+
+  private:
+    SpinWorkers(SpinWorkers const&) = delete;
+    SpinWorkers& operator=(SpinWorkers const&) = delete;
+
+  private:
+    void work();
+    // Runs pieces of the current run until there are none left to claim.
+    void claim();
+
+  private:
+    // Bumped for every run() so that the helpers know to start.
+    std::atomic<std::uint32_t> m_generation = 0;
+    // Next piece of the current run to hand out, and how many are yet to
+    // finish.
+    std::atomic<std::size_t> m_next;
+    std::atomic<std::size_t> m_remaining = 0;
+    std::atomic<bool> m_stop = false;
+    Task m_task = nullptr;
+    void* m_context = nullptr;
+
+    std::vector<std::jthread> m_threads;
+};
+
+}  // namespace pwv
@@ -0,0 +1,64 @@
+#include "StateVariableBank.h"
+
+#include <cassert>
+
+namespace pwv {
+
+StateVariableBank::StateVariableBank(std::size_t num_filters) {
+    resize(num_filters);
+}
+
+StateVariableBank::~StateVariableBank() {}
+
+void StateVariableBank::resize(std::size_t num_filters) {
+    m_num_filters = num_filters;
+    m_stride = pad_lanes(num_filters);
+
+    // Unused lanes have zero output gains so they always output silence.
+    for (auto* array : {&m_a1, &m_a2, &m_a3, &m_m0, &m_m1, &m_m2}) {
+        array->assign(m_stride, 0);
+    }
+    for (auto* array : {&m_ic1, &m_ic2}) {
+        array->assign(m_stride, 0);
+    }
+}
+
+void StateVariableBank::reset(std::size_t index, Params const& params) {
+    set_params(index, params);
+
+    // Clear prior state.
+    m_ic1[index] = m_ic2[index] = 0;
+}
+
+void StateVariableBank::set_params(std::size_t index, Params const& params) {
+    assert(index < m_num_filters);
+    auto const gains = StateVariableFilter::gains(params);
+    m_a1[index] = gains.a1;
+    m_a2[index] = gains.a2;
+    m_a3[index] = gains.a3;
+    m_m0[index] = gains.m0;
+    m_m1[index] = gains.m1;
+    m_m2[index] = gains.m2;
+}
+
+void StateVariableBank::process_block(std::span<float> data) {
+    assert(data.size() % m_stride == 0);
+    assert(data.size() <= k_block_size * m_stride);
+    kernels().state_variable_bank(refs(), data.data(), data.size() / m_stride);
+}
+
+void StateVariableBank::process_block(std::span<float const> input,
+                                      std::span<float> output) {
+    assert(input.size() <= k_block_size);
+    assert(output.size() == input.size() * m_stride);
+    kernels().state_variable_bank_split(refs(), input.data(), output.data(),
+                                        input.size());
+}
+
+StateVariableBankRefs StateVariableBank::refs() {
+    return {m_a1.data(),  m_a2.data(), m_a3.data(),
+            m_m0.data(),  m_m1.data(), m_m2.data(),
+            m_ic1.data(), m_ic2.data(), m_stride};
+}
+
+}  // namespace pwv
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Kernels.h"
+#include "StateVariableFilter.h"
+
+#include <span>
+#include <vector>
+
+namespace pwv {
+
+// As BiquadBank, with state-variable filters. Their tuning can be changed
+// with set_params() between blocks without clearing them.
+class StateVariableBank {
+  public:
+    using Params = StateVariableFilter::Params;
+    static constexpr std::size_t k_block_size =
+        StateVariableFilter::k_block_size;
+
+  public:
+    explicit StateVariableBank(std::size_t num_filters = 0);
+    ~StateVariableBank();
+    StateVariableBank(StateVariableBank&&) = default;
+    StateVariableBank& operator=(StateVariableBank&&) = default;
+
+    void resize(std::size_t num_filters);
+    void reset(std::size_t index, Params const& params);
+    // As reset(), but keeps the filter's state.
+    void set_params(std::size_t index, Params const& params);
+
+    std::size_t size() const { return m_num_filters; }
+    std::size_t stride() const { return m_stride; }
+
+    // Filter a block of up to k_block_size samples in place.
+    void process_block(std::span<float> data);
+    // Feed the same block of samples into every filter.
+    void process_block(std::span<float const> input, std::span<float> output);
+
+    StateVariableBankRefs refs();
+
+  private:
+    StateVariableBank(StateVariableBank const&) = delete;
+    StateVariableBank& operator=(StateVariableBank const&) = delete;
+
+  private:
+    std::size_t m_num_filters = 0;
+    std::size_t m_stride = 0;
+    std::vector<float> m_a1, m_a2, m_a3, m_m0, m_m1, m_m2;
+    std::vector<float> m_ic1, m_ic2;
+};
+
+}  // namespace pwv
@@ -0,0 +1,137 @@
+#include "StateVariableFilter.h"
+
+#include "Denormals.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace pwv {
+
+namespace {
+
+using Gains = StateVariableFilter::Gains;
+
+// One sample through the filter, updating the integrators in |ic1| and |ic2|.
+float tick(Gains const& gains, float& ic1, float& ic2, float input) {
+    float const v3 = input - ic2;
+    float const v1 = gains.a1 * ic1 + gains.a2 * v3;
+    float const v2 = ic2 + gains.a2 * ic1 + gains.a3 * v3;
+    ic1 = 2 * v1 - ic1;
+    ic2 = 2 * v2 - ic2;
+    return gains.m0 * input + gains.m1 * v1 + gains.m2 * v2;
+}
+
+}  // namespace
+
+StateVariableFilter::StateVariableFilter() { reset({}); }
+
+StateVariableFilter::~StateVariableFilter() {}
+
+void StateVariableFilter::reset(Params const& params) {
+    m_params = params;
+    m_gains = gains(params);
+    m_ic1 = m_ic2 = 0;
+    m_ramp_remaining = 0;
+}
+
+void StateVariableFilter::ramp_to(Params const& params,
+                                  std::size_t num_samples) {
+    if (m_ramp_remaining != 0) {
+        // Carry on from wherever the last ramp has got to.
+        float const t = static_cast<float>(m_ramp_done);
+        m_params = {m_ramp_from.g + m_ramp_step.g * t,
+                    m_ramp_from.k + m_ramp_step.k * t,
+                    m_ramp_from.m0 + m_ramp_step.m0 * t,
+                    m_ramp_from.m1 + m_ramp_step.m1 * t,
+                    m_ramp_from.m2 + m_ramp_step.m2 * t};
+    }
+    m_ramp_target = params;
+    m_ramp_remaining = num_samples;
+    if (num_samples == 0) {
+        m_params = params;
+        m_gains = gains(params);
+        return;
+    }
+
+    float const scale = 1.0f / num_samples;
+    m_ramp_from = m_params;
+    m_ramp_step = {(params.g - m_params.g) * scale,
+                   (params.k - m_params.k) * scale,
+                   (params.m0 - m_params.m0) * scale,
+                   (params.m1 - m_params.m1) * scale,
+                   (params.m2 - m_params.m2) * scale};
+    m_ramp_done = 0;
+}
+
+void StateVariableFilter::process(std::span<float> data) {
+    FlushDenormals const flush_denormals;
+    if (m_ramp_remaining != 0) {
+        data = run_ramp(data);
+    }
+
+    Gains const gains = m_gains;
+    float ic1 = m_ic1, ic2 = m_ic2;
+    for (float& value : data) {
+        value = tick(gains, ic1, ic2, value);
+    }
+    m_ic1 = ic1;
+    m_ic2 = ic2;
+}
+
+void StateVariableFilter::process_block(std::span<float> data) {
+    assert(data.size() == k_block_size);
+    process(data);
+}
+
+std::span<float> StateVariableFilter::run_ramp(std::span<float> data) {
+    std::size_t const count = std::min(data.size(), m_ramp_remaining);
+    Params const from = m_ramp_from, step = m_ramp_step;
+    float ic1 = m_ic1, ic2 = m_ic2;
+
+    std::size_t done = m_ramp_done;
+    for (float& value : data.first(count)) {
+        float const t = static_cast<float>(++done);
+        Gains const gains = StateVariableFilter::gains(
+            {from.g + step.g * t, from.k + step.k * t, from.m0 + step.m0 * t,
+             from.m1 + step.m1 * t, from.m2 + step.m2 * t});
+        value = tick(gains, ic1, ic2, value);
+    }
+
+    m_ic1 = ic1;
+    m_ic2 = ic2;
+    m_ramp_done = done;
+    m_ramp_remaining -= count;
+    if (m_ramp_remaining == 0) {
+        ramp_to(m_ramp_target, 0);
+    }
+    return data.subspan(count);
+}
+
+StateVariableFilter::Params StateVariableFilter::lowpass(double sampling_rate,
+                                                         double cutoff_hz) {
+    // Butterworth, as LowPass.
+    double const g = std::tan(M_PI * cutoff_hz / sampling_rate);
+    double const k = std::sqrt(2.0);
+    return {static_cast<float>(g), static_cast<float>(k), 0, 0, 1};
+}
+
+StateVariableFilter::Params StateVariableFilter::bandpass(double sampling_rate,
+                                                          double hz,
+                                                          double q) {
+    // BandPass's alpha is sin(omega) / (2 Q') with 1 / Q' = 2 sinh(1 / 2q),
+    // and its peak is at unity.
+    double const g = std::tan(M_PI * hz / sampling_rate);
+    double const k = 2 * std::sinh(1 / (2 * q));
+    return {static_cast<float>(g), static_cast<float>(k), 0,
+            static_cast<float>(k), 0};
+}
+
+StateVariableFilter::Gains StateVariableFilter::gains(Params const& params) {
+    float const a1 = 1 / (1 + params.g * (params.g + params.k));
+    float const a2 = params.g * a1;
+    float const a3 = params.g * a2;
+    return {a1, a2, a3, params.m0, params.m1, params.m2};
+}
+
+}  // namespace pwv
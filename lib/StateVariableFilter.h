@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SecondOrderFilter.h"
+
+#include <span>
+
+namespace pwv {
+
+// Which structure LowPass and BandPass run on.
+enum class FilterTopology { Biquad, StateVariable };
+
+// Trapezoidal (TPT) state-variable filter, after Zavalishin. It has the same
+// response as the bilinear biquads, but its state holds the integrators
+// rather than past outputs. That keeps it accurate at low frequencies in
+// floats, and lets its tuning change every sample without blowing up.
+class StateVariableFilter {
+  public:
+    static constexpr std::size_t k_block_size = SecondOrderFilter::k_block_size;
+
+    // g = tan(pi * hz / sampling_rate) and k = 1 / Q. The output is
+    // m0 * input + m1 * band + m2 * low.
+    struct Params {
+        float g, k, m0, m1, m2;
+    };
+    // Gains for each sample, worked out from Params.
+    struct Gains {
+        float a1, a2, a3, m0, m1, m2;
+    };
+
+  public:
+    StateVariableFilter();
+    ~StateVariableFilter();
+    StateVariableFilter(StateVariableFilter&&) = default;
+    StateVariableFilter& operator=(StateVariableFilter&&) = default;
+
+    void reset(Params const& params);
+    // As SecondOrderFilter::ramp_to(). Each sample of the ramp costs a
+    // division more than the rest, to work the gains out from g and k.
+    void ramp_to(Params const& params, std::size_t num_samples);
+    bool ramping() const { return m_ramp_remaining != 0; }
+
+    // Any length is accepted, including empty spans.
+    void process(std::span<float> data);
+    void process_block(std::span<float> data);
+
+    // Same responses as LowPass::coefs() and BandPass::coefs().
+    static Params lowpass(double sampling_rate, double cutoff_hz);
+    static Params bandpass(double sampling_rate, double hz, double q);
+    static Gains gains(Params const& params);
+
+  private:
+    StateVariableFilter(StateVariableFilter const&) = delete;
+    StateVariableFilter& operator=(StateVariableFilter const&) = delete;
+
+    // Runs what's left of the ramp over the start of |data|, and returns the
+    // rest of it.
+    std::span<float> run_ramp(std::span<float> data);
+
+  private:
+    Params m_params{};
+    Gains m_gains{};
+    float m_ic1 = 0;
+    float m_ic2 = 0;
+
+    // As in SecondOrderFilter.
+    Params m_ramp_from{};
+    Params m_ramp_target{};
+    Params m_ramp_step{};
+    std::size_t m_ramp_done = 0;
+    std::size_t m_ramp_remaining = 0;
+};
+
+}  // namespace pwv
@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+
+#include "Denormals.h"
+
+#include <cassert>
+
+namespace pwv {
+
+ThreadPool::ThreadPool(std::size_t num_threads) {
+    assert(num_threads != 0);
+    for (std::size_t worker = 1; worker < num_threads; worker++) {
+        m_threads.emplace_back([this, worker] { work(worker); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+    m_threads.clear();
+}
+
+void ThreadPool::run(std::size_t count, Job const& job) {
+    {
+        std::lock_guard lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_next = 0;
+        m_busy = m_threads.size();
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    take_jobs(0);
+
+    // Wait for the other threads to finish their last jobs.
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_job = nullptr;
+}
+
+void ThreadPool::work(std::size_t worker) {
+    FlushDenormals const flush_denormals;
+    std::size_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_start.wait(lock, [&] {
+                return m_stop || m_generation != generation;
+            });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        take_jobs(worker);
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_busy--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void ThreadPool::take_jobs(std::size_t worker) {
+    while (true) {
+        std::size_t index;
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_next == m_count) {
+                return;
+            }
+            index = m_next++;
+        }
+        (*m_job)(index, worker);
+    }
+}
+
+}  // namespace pwv
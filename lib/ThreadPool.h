@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace pwv {
+
+// A fixed set of threads for splitting offline work up. Not for the realtime
+// path, since it blocks.
+class ThreadPool {
+  public:
+    using Job = std::function<void(std::size_t index, std::size_t worker)>;
+
+  public:
+    // |num_threads| includes the caller, so 1 runs everything inline.
+    explicit ThreadPool(std::size_t num_threads);
+    ~ThreadPool();
+
+    std::size_t num_threads() const { return m_threads.size() + 1; }
+
+    // Calls |job| for every index below |count|, across the threads, and
+    // waits for them all. |worker| is below num_threads() and no two calls
+    // at once share one.
+    void run(std::size_t count, Job const& job);
+
+  private:
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+  private:
+    void work(std::size_t worker);
+    void take_jobs(std::size_t worker);
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+
+    // Bumped for every run() so that the threads know to start.
+    std::size_t m_generation = 0;
+    bool m_stop = false;
+    Job const* m_job = nullptr;
+    std::size_t m_count = 0;
+    std::size_t m_next = 0;
+    std::size_t m_busy = 0;
+
+    std::vector<std::jthread> m_threads;
+};
+
+}  // namespace pwv
@@ -1,11 +1,18 @@
 #include "Vocoder.h"
 
 #include "BandPass.h"
+#include "CarrierAnalysis.h"
+#include "Denormals.h"
+#include "Kernels.h"
 #include "LowPass.h"
+#include "SpinWorkers.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
+#include <thread>
 
 // Reference: see vocoder.ny in audacity
 
@@ -15,31 +22,16 @@ namespace pwv {
 
 namespace {
 
-std::vector<float> bandpass(double sampling_rate, std::span<float const> input,
-                            double hz, double q) {
-    std::vector<float> result(input.begin(), input.end());
-    BandPass(sampling_rate, hz, q).process(result);
-    return result;
-}
-
-std::vector<float> lowpass(double sampling_rate, std::span<float const> input,
-                           double cutoff) {
-    std::vector<float> result(input.begin(), input.end());
-    LowPass(sampling_rate, cutoff).process(result);
-    return result;
-}
+// Samples of a chunk summed at a time.
+constexpr std::size_t k_slice_size = 1024;
 
 void abs(std::span<float> input) {
-    for (float& sample : input) {
-        sample = std::abs(sample);
-    }
+    kernels().abs(input.data(), input.size());
 }
 
 void mul(std::span<float> a, std::span<float const> b) {
     assert(a.size() == b.size());
-    for (std::size_t i = 0; i < a.size(); i++) {
-        a[i] *= b[i];
-    }
+    kernels().mul(a.data(), b.data(), a.size());
 }
 
 void mul(std::span<float> input, float scale) {
@@ -48,11 +40,26 @@ void mul(std::span<float> input, float scale) {
     }
 }
 
+// Keeps the cutoff clear of Nyquist at the envelope step's rate.
+template <typename Policy>
+typename Policy::Coefs envelope_coefs(double hz, double sampling_rate,
+                                      std::size_t step) {
+    double const rate = sampling_rate / step;
+    return LowPass::coefs<Policy>(rate, std::min(hz, 0.4 * rate));
+}
+
 void add(std::span<float> a, std::span<float const> b) {
     assert(a.size() == b.size());
-    for (std::size_t i = 0; i < a.size(); i++) {
-        a[i] += b[i];
-    }
+    kernels().add(a.data(), b.data(), a.size());
+}
+
+// Lanes [first, first + count) of a bank.
+BiquadBankRefs slice(BiquadBankRefs const& bank, std::size_t first,
+                     std::size_t count) {
+    return {bank.a1 + first, bank.a2 + first, bank.b0 + first,
+            bank.b1 + first, bank.b2 + first, bank.x1 + first,
+            bank.x2 + first, bank.y1 + first, bank.y2 + first,
+            count};
 }
 
 double next_hz(double hz, double interval) {
@@ -77,112 +84,854 @@ Vocoder::Vocoder(double distance, int num_bands, double sampling_rate)
 
 Vocoder::~Vocoder() {}
 
+// Filters of a single band, and its output for the current chunk.
+struct Vocoder::Band {
+    BandPass signal_bandpass;
+    BandPass carrier_bandpass;
+    LowPass envelope_lowpass;
+    BandPass output_bandpass;
+    std::vector<float> output;
+};
+
+std::size_t Vocoder::pre_roll(double level) const {
+    // The signal's path runs through three filters one after the other, and
+    // the carrier's through two of the same.
+    constexpr std::size_t k_never = std::numeric_limits<std::size_t>::max();
+    std::size_t result = 0;
+    double const interval = 12 * std::sqrt(2) / m_q;
+    double band_hz = next_hz(20, interval / 2.0);
+    for (int band = 0; band < m_num_bands; band++) {
+        std::size_t const bandpass = SecondOrderFilter::decay_length(
+            BandPass::coefs(m_sampling_rate, band_hz, m_q), level);
+        std::size_t const lowpass = SecondOrderFilter::decay_length(
+            LowPass::coefs(m_sampling_rate, band_hz / m_distance), level);
+        // A filter that never settles makes the whole path never settle.
+        if (bandpass >= k_never / 3 || lowpass >= k_never / 3) {
+            return k_never;
+        }
+        result = std::max(result, 2 * bandpass + lowpass);
+
+        // Next band
+        band_hz = next_hz(band_hz, interval);
+    }
+    return result;
+}
+
+void Vocoder::set_num_threads(std::size_t num_threads) {
+    if (!m_pool || m_pool->num_threads() != num_threads) {
+        m_pool = std::make_unique<ThreadPool>(num_threads);
+        m_carrier_scratch.assign(num_threads, std::vector<float>(k_chunk_size));
+    }
+}
+
 std::vector<float> Vocoder::process(std::span<float const> signal,
                                     std::span<float const> carrier) {
     assert(signal.size() == carrier.size());
     std::vector<float> result(signal.size());
+    start();
+    for (std::size_t start = 0; start < signal.size(); start += k_chunk_size) {
+        std::size_t const count = std::min(signal.size() - start, k_chunk_size);
+        process_chunk(signal.subspan(start, count),
+                      carrier.subspan(start, count),
+                      std::span{result}.subspan(start, count));
+    }
+    return result;
+}
 
+void Vocoder::start() {
+    if (!m_pool) {
+        set_num_threads(1);
+    }
+
+    m_bands.clear();
     double const interval = 12 * std::sqrt(2) / m_q;
     double band_hz = next_hz(20, interval / 2.0);
     for (int band = 0; band < m_num_bands; band++) {
-        // Bandpass both
-        auto signal_filtered = bandpass(m_sampling_rate, signal, band_hz, m_q);
-        auto carrier_filtered =
-            bandpass(m_sampling_rate, carrier, band_hz, m_q);
-
-        // Calculate envelope
-        abs(signal_filtered);
-        auto mod_envelope =
-            lowpass(m_sampling_rate, signal_filtered, band_hz / m_distance);
-
-        // Combine
-        mul(mod_envelope, carrier_filtered);
-        add(result, bandpass(m_sampling_rate, mod_envelope, band_hz, m_q));
+        m_bands.push_back({
+            BandPass(m_sampling_rate, band_hz, m_q),
+            BandPass(m_sampling_rate, band_hz, m_q),
+            LowPass(m_sampling_rate, band_hz / m_distance),
+            BandPass(m_sampling_rate, band_hz, m_q),
+            std::vector<float>(k_chunk_size),
+        });
 
         // Next band
         band_hz = next_hz(band_hz, interval);
     }
+}
 
-    return result;
+void Vocoder::process_chunk(std::span<float const> signal,
+                            std::span<float const> carrier,
+                            std::span<float> output) {
+    FlushDenormals const flush_denormals;
+    assert(signal.size() == carrier.size() && signal.size() == output.size());
+    assert(signal.size() <= k_chunk_size);
+    std::size_t const count = signal.size();
+
+    // Every band runs the chunk into its own buffer. The buffers are then
+    // summed in band order, so the result doesn't depend on how the bands
+    // were shared out.
+    m_pool->run(m_bands.size(), [&](std::size_t index, std::size_t worker) {
+        Band& band = m_bands[index];
+        std::span const band_output{band.output.data(), count};
+        std::span const carrier_filtered{m_carrier_scratch[worker].data(),
+                                         count};
+
+        // Bandpass both
+        std::copy(signal.begin(), signal.end(), band_output.begin());
+        band.signal_bandpass.process(band_output);
+        std::copy(carrier.begin(), carrier.end(), carrier_filtered.begin());
+        band.carrier_bandpass.process(carrier_filtered);
+
+        // Calculate envelope
+        abs(band_output);
+        band.envelope_lowpass.process(band_output);
+
+        // Combine
+        mul(band_output, carrier_filtered);
+        band.output_bandpass.process(band_output);
+    });
+
+    // Sum a slice of the chunk at a time.
+    std::size_t const num_slices = (count + k_slice_size - 1) / k_slice_size;
+    m_pool->run(num_slices, [&](std::size_t slice, std::size_t) {
+        std::size_t const offset = slice * k_slice_size;
+        std::size_t const slice_count = std::min(count - offset, k_slice_size);
+        std::span const slice_output = output.subspan(offset, slice_count);
+        std::fill(slice_output.begin(), slice_output.end(), 0.0f);
+        for (Band const& band : m_bands) {
+            add(slice_output,
+                std::span{band.output.data() + offset, slice_count});
+        }
+
+        // Need to scale it up a bit.
+        mul(slice_output, 50);
+    });
 }
 
-VocoderRT::VocoderRT(double distance, int num_bands, double sampling_rate) {
-    // Build the filters.
+std::vector<VocoderBand> vocoder_bands(double distance, int num_bands,
+                                       double sampling_rate) {
+    std::vector<VocoderBand> bands;
     double const q = BandPass::approximate_q(sampling_rate, num_bands);
     double const interval = 12 * std::sqrt(2) / q;
     double band_hz = next_hz(20, interval / 2.0);
     for (int band = 0; band < num_bands; band++) {
-        // TODO: deduplicate the bandpass filters.
-        m_bandpass.emplace_back(sampling_rate, band_hz, q);
-        m_bandpass.emplace_back(sampling_rate, band_hz, q);
-        m_bandpass.emplace_back(sampling_rate, band_hz, q);
-        m_lowpass.emplace_back(sampling_rate, band_hz / distance);
+        bands.push_back({
+            band_hz,
+            BandPass::coefs(sampling_rate, band_hz, q),
+            LowPass::coefs(sampling_rate, band_hz / distance),
+            BandPass::precise_coefs(sampling_rate, band_hz, q),
+            LowPass::precise_coefs(sampling_rate, band_hz / distance),
+        });
 
         // Next band
         band_hz = next_hz(band_hz, interval);
     }
+    return bands;
+}
+
+template <typename Policy>
+BasicVocoderRT<Policy>::BasicVocoderRT(double distance, int num_bands,
+                                       double sampling_rate)
+    : BasicVocoderRT(distance, num_bands, sampling_rate, num_bands) {}
+
+template <typename Policy>
+BasicVocoderRT<Policy>::BasicVocoderRT(double distance, int num_bands,
+                                       double sampling_rate, int max_bands)
+    : m_signal_bandpass(max_bands),
+      m_carrier_bandpass(max_bands),
+      m_envelope_lowpass(max_bands),
+      m_output_bandpass(max_bands),
+      m_sampling_rate(sampling_rate),
+      m_max_bands(max_bands),
+      m_tuning(std::make_unique<Tuning>()),
+      m_precise_signal_bandpass(k_float ? max_bands : 0),
+      m_precise_carrier_bandpass(k_float ? max_bands : 0),
+      m_precise_envelope_lowpass(k_float ? max_bands : 0),
+      m_precise_output_bandpass(k_float ? max_bands : 0) {
+    assert(num_bands <= max_bands);
+
+    // Make room for the most bands up front, so that retuning doesn't
+    // allocate.
+    if constexpr (k_float) {
+        std::size_t const block_size =
+            k_block_size * m_signal_bandpass.stride();
+        m_signal_block.resize(block_size);
+        m_carrier_block.resize(block_size);
+    } else {
+        m_signal_block.resize(k_fixed_chunk_size);
+        m_carrier_block.resize(k_fixed_chunk_size);
+        m_sums.resize(k_fixed_chunk_size);
+    }
+    m_envelope_hz.reserve(max_bands);
+    m_precise_lanes.reserve(max_bands);
+    m_precise_target.reserve(max_bands);
+
+    // Build the filters, from rest.
+    for (auto* bank : {&m_signal_bandpass, &m_carrier_bandpass,
+                       &m_envelope_lowpass, &m_output_bandpass}) {
+        bank->set_size(0);
+    }
+    resize_precise();
+    design(*m_tuning, distance, num_bands, sampling_rate);
+    apply(*m_tuning);
+    m_spare = m_tuning.get();
+}
+
+template <typename Policy>
+BasicVocoderRT<Policy>::~BasicVocoderRT() {}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::retune(double distance, int num_bands,
+                                    double sampling_rate) {
+    assert(num_bands <= static_cast<int>(m_max_bands));
+    Tuning* const tuning = take_tuning();
+    design(*tuning, distance, num_bands, sampling_rate);
+    m_pending.store(tuning);
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::set_precise_tolerance(double tolerance)
+    requires k_float
+{
+    m_precise_tolerance = tolerance;
+
+    // Same settings otherwise, with the bands picked again.
+    Tuning* const tuning = take_tuning();
+    design(*tuning, tuning->distance, static_cast<int>(tuning->bands.size()),
+           tuning->sampling_rate);
+    m_pending.store(tuning);
 }
 
-VocoderRT::~VocoderRT() {}
+template <typename Policy>
+typename BasicVocoderRT<Policy>::Tuning* BasicVocoderRT<Policy>::take_tuning() {
+    // Take back settings that haven't been picked up yet, or else the ones
+    // that have once process() is done with them.
+    while (true) {
+        Tuning* tuning = m_pending.exchange(nullptr);
+        if (!tuning) {
+            tuning = m_spare.exchange(nullptr);
+        }
+        if (tuning) {
+            return tuning;
+        }
+        std::this_thread::yield();
+    }
+}
 
-void VocoderRT::process(float const* signal, float const* carrier,
-                        std::size_t count, float* output) {
-    assert((count % k_block_size) == 0);
-    for (std::size_t i = 0; i < count; i += k_block_size) {
-        process_block(signal + i, carrier + i, output + i);
+template <typename Policy>
+void BasicVocoderRT<Policy>::design(Tuning& tuning, double distance,
+                                    int num_bands,
+                                    double sampling_rate) const {
+    tuning.distance = distance;
+    tuning.sampling_rate = sampling_rate;
+    tuning.bands = vocoder_bands(distance, num_bands, sampling_rate);
+    tuning.bandpass.clear();
+    tuning.envelope_lowpass.clear();
+    for (VocoderBand const& band : tuning.bands) {
+        tuning.bandpass.push_back(
+            SecondOrderFilter::round<Policy>(band.precise_bandpass));
+        tuning.envelope_lowpass.push_back(
+            m_envelope_step == 1
+                ? LowPass::coefs<Policy>(sampling_rate, band.hz / distance)
+                : envelope_coefs<Policy>(band.hz / distance, sampling_rate,
+                                         m_envelope_step));
+    }
+    tuning.precise.clear();
+    for (std::size_t band = 0; band < tuning.bands.size(); band++) {
+        double const omega = 2 * M_PI * tuning.bands[band].hz / sampling_rate;
+        if (SecondOrderFilter::rounding_error(
+                tuning.bands[band].precise_bandpass, omega) >
+            m_precise_tolerance) {
+            tuning.precise.push_back(band);
+        }
     }
 }
 
-void VocoderRT::process_block(float const* signal, float const* carrier,
-                              float* output) {
-    static_assert(k_block_size == BandPass::k_block_size);
-    static_assert(k_block_size == LowPass::k_block_size);
+template <typename Policy>
+void BasicVocoderRT<Policy>::apply(Tuning const& tuning) {
+    std::size_t const num_bands = tuning.bands.size();
+    std::size_t const old_num_bands = m_signal_bandpass.size();
+    bool ramped = false;
+    auto const ramp = [&](Bank& bank, std::size_t band, Coefs const& coefs) {
+        // Bands that are new start from rest, with nothing to ramp from.
+        if (band < old_num_bands) {
+            bank.ramp_to(band, coefs);
+            ramped = true;
+        } else {
+            bank.set_coefs(band, coefs);
+        }
+    };
 
-    using Block = std::array<float, k_block_size>;
-    auto load_block = [](float const* ptr) {
-        Block block;
-        std::copy_n(ptr, k_block_size, block.data());
-        return block;
+    // Bands being dropped fade out with the rest of the ramp, and only go
+    // once it's done.
+    for (auto* bank : {&m_signal_bandpass, &m_carrier_bandpass,
+                       &m_envelope_lowpass, &m_output_bandpass}) {
+        bank->set_size(std::max(num_bands, old_num_bands));
+    }
+    m_num_bands = num_bands;
+    m_envelope_hz.resize(num_bands);
+    for (std::size_t band = 0; band < num_bands; band++) {
+        // TODO: deduplicate the bandpass filters.
+        ramp(m_signal_bandpass, band, tuning.bandpass[band]);
+        ramp(m_carrier_bandpass, band, tuning.bandpass[band]);
+        ramp(m_output_bandpass, band, tuning.bandpass[band]);
+        ramp(m_envelope_lowpass, band, tuning.envelope_lowpass[band]);
+        m_envelope_hz[band] = tuning.bands[band].hz / tuning.distance;
+    }
+    Coefs const silent{};
+    for (std::size_t band = num_bands; band < old_num_bands; band++) {
+        ramp(m_signal_bandpass, band, silent);
+        ramp(m_output_bandpass, band, silent);
+    }
+    m_sampling_rate = tuning.sampling_rate;
+
+    // Fade out the float lanes of the bands run in doubles. Zeroing the
+    // signal's bandpass leaves nothing for the rest of the lane to pass on,
+    // and the output's cuts off what it still has. Bands that weren't
+    // already in doubles start there from rest, and those leaving fade out
+    // of them as their float lanes fade back in.
+    std::size_t const num_were_precise = m_precise_lanes.size();
+    auto const was_precise = [&](std::size_t band) {
+        auto const end = m_precise_lanes.begin() + num_were_precise;
+        return std::find(m_precise_lanes.begin(), end, band) != end;
+    };
+    auto const is_precise = [&](std::size_t band) {
+        return std::find(tuning.precise.begin(), tuning.precise.end(),
+                         band) != tuning.precise.end();
     };
+    for (std::size_t const band : tuning.precise) {
+        if (!was_precise(band)) {
+            m_precise_lanes.push_back(band);
+        }
+    }
+    resize_precise();
+    for (std::size_t const band : m_precise_lanes) {
+        if (!is_precise(band)) {
+            m_precise_signal_bandpass.ramp_to(band, {});
+            m_precise_output_bandpass.ramp_to(band, {});
+            ramped = true;
+        }
+    }
+    for (std::size_t const band : tuning.precise) {
+        VocoderBand const& coefs = tuning.bands[band];
+        if (was_precise(band)) {
+            m_precise_signal_bandpass.ramp_to(band, coefs.precise_bandpass);
+            m_precise_carrier_bandpass.ramp_to(band, coefs.precise_bandpass);
+            m_precise_envelope_lowpass.ramp_to(band, coefs.precise_lowpass);
+            m_precise_output_bandpass.ramp_to(band, coefs.precise_bandpass);
+            ramped = true;
+        } else {
+            m_precise_signal_bandpass.reset(band, coefs.precise_bandpass);
+            m_precise_carrier_bandpass.reset(band, coefs.precise_bandpass);
+            m_precise_envelope_lowpass.reset(band, coefs.precise_lowpass);
+            m_precise_output_bandpass.reset(band, coefs.precise_bandpass);
+        }
+        ramp(m_signal_bandpass, band, silent);
+        ramp(m_output_bandpass, band, silent);
+    }
+    m_precise_target.assign(tuning.precise.begin(), tuning.precise.end());
 
-    // Setup the blocks.
-    Block const signal_input = load_block(signal);
-    Block const carrier_input = load_block(carrier);
+    // The bands have moved, so let the gate look at them afresh.
+    std::fill(m_band_active.begin(), m_band_active.end(), 1);
 
-    // Run the filters on it.
-    // TODO: might be more efficient to optimize over the filters...
-    Block result_block{};
-    std::size_t const num_bands = m_lowpass.size();
-    for (std::size_t band = 0; band < num_bands; band++) {
-        // Grab the filters for this band.
-        BandPass& bandpass0 = m_bandpass[3 * band + 0];
-        BandPass& bandpass1 = m_bandpass[3 * band + 1];
-        BandPass& bandpass2 = m_bandpass[3 * band + 2];
-        LowPass& lowpass = m_lowpass[band];
+    // Run the ramp from the next sample on, if there is one.
+    if (ramped) {
+        m_retune_step = 0;
+        m_until_step = 0;
+    } else {
+        finish_retune();
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::set_envelope_step(std::size_t step)
+    requires k_float
+{
+    assert(step != 0 && (step & (step - 1)) == 0);
+    assert(step <= k_block_size && step <= k_max_envelope_step);
+    static_assert(k_tile_size % k_block_size == 0);
+    m_envelope_step = step;
+
+    for (std::size_t band = 0; band < m_envelope_hz.size(); band++) {
+        m_envelope_lowpass.reset(
+            band, envelope_coefs<Policy>(m_envelope_hz[band], m_sampling_rate,
+                                         step));
+    }
+}
 
-        // Initialise this block.
-        Block signal_block = signal_input;
-        Block carrier_block = carrier_input;
+template <typename Policy>
+void BasicVocoderRT<Policy>::set_band_gate(float level)
+    requires k_float
+{
+    assert(level >= 0);
+    m_gate_level = level;
+    m_band_active.assign(pad_lanes(m_max_bands), 1);
+}
 
-        // Bandpass both inputs.
-        bandpass0.process_block(signal_block);
-        bandpass1.process_block(carrier_block);
+template <typename Policy>
+double BasicVocoderRT<Policy>::skipped_fraction() const {
+    return m_gated != 0 ? static_cast<double>(m_skipped) / m_gated : 0;
+}
 
-        // Calculate envelope.
-        abs(signal_block);
-        lowpass.process_block(signal_block);
+template <typename Policy>
+void BasicVocoderRT<Policy>::set_num_threads(std::size_t num_threads)
+    requires k_float
+{
+    assert(num_threads != 0);
+    // No point in more threads than groups of bands.
+    std::size_t const num_groups = pad_lanes(m_max_bands) / k_max_lanes;
+    num_threads = std::min(num_threads, std::max<std::size_t>(num_groups, 1));
+
+    m_workers.reset();
+    m_thread_output.clear();
+    m_thread_skipped.clear();
+    if (num_threads > 1) {
+        m_workers = std::make_unique<SpinWorkers>(num_threads);
+        m_thread_output.resize((num_threads - 1) * k_thread_chunk_size);
+        m_thread_skipped.resize(num_threads);
+    }
+}
 
-        // Combine.
-        mul(signal_block, carrier_block);
-        bandpass2.process_block(signal_block);
-        add(result_block, signal_block);
+template <typename Policy>
+void BasicVocoderRT<Policy>::bind_threads()
+    requires k_float
+{
+    if (m_workers) {
+        m_workers->bind_to_current_thread();
     }
+}
 
-    // Need to scale it up a bit.
-    mul(result_block, 50);
+template <typename Policy>
+void BasicVocoderRT<Policy>::process(float const* signal, float const* carrier,
+                                     std::size_t count, float* output) {
+    if constexpr (k_float) {
+        process(signal, carrier, nullptr, count, output);
+    } else {
+        Sample signal_samples[k_fixed_chunk_size];
+        Sample carrier_samples[k_fixed_chunk_size];
+        Sample output_samples[k_fixed_chunk_size];
+        for (std::size_t start = 0; start < count;
+             start += k_fixed_chunk_size) {
+            std::size_t const chunk =
+                std::min(count - start, k_fixed_chunk_size);
+            for (std::size_t i = 0; i < chunk; i++) {
+                signal_samples[i] = Policy::from_float(signal[start + i]);
+                carrier_samples[i] = Policy::from_float(carrier[start + i]);
+            }
+            process_samples(signal_samples, carrier_samples, chunk,
+                            output_samples);
+            for (std::size_t i = 0; i < chunk; i++) {
+                output[start + i] = Policy::to_float(output_samples[i]);
+            }
+        }
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::process_samples(Sample const* signal,
+                                             Sample const* carrier,
+                                             std::size_t count, Sample* output)
+    requires(!k_float)
+{
+    process(signal, carrier, nullptr, count, output);
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::process(float const* signal,
+                                     CarrierAnalysis const& carrier,
+                                     float* output)
+    requires k_float
+{
+    assert(carrier.num_bands() == m_num_bands);
+    assert(carrier.sampling_rate() == m_sampling_rate);
+    process(signal, nullptr, carrier.bands(), carrier.count(), output);
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::process(Sample const* signal,
+                                     Sample const* carrier,
+                                     float const* carrier_bands,
+                                     std::size_t count, Sample* output) {
+    FlushDenormals const flush_denormals;
+    if (Tuning* const tuning = m_pending.exchange(nullptr)) {
+        apply(*tuning);
+        m_spare.store(tuning);
+    }
+    if (carrier_bands) {
+        // The carrier's analysis only has the bands retuned to.
+        drop_bands();
+    }
+
+    // Split the call where the ramp of a retune takes its steps.
+    std::size_t const stride = m_signal_bandpass.stride();
+    while (m_retune_step < k_retune_steps && count != 0) {
+        if (m_until_step == 0) {
+            step_retune();
+            continue;
+        }
+        std::size_t const part = std::min(count, m_until_step);
+        run(signal, carrier, carrier_bands, part, output);
+        m_until_step -= part;
+        signal += part;
+        if (carrier) {
+            carrier += part;
+        } else {
+            carrier_bands += part * stride;
+        }
+        count -= part;
+        output += part;
+    }
+    if (count != 0) {
+        run(signal, carrier, carrier_bands, count, output);
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::step_retune() {
+    m_retune_step++;
+    for (auto* bank : {&m_signal_bandpass, &m_carrier_bandpass,
+                       &m_envelope_lowpass, &m_output_bandpass}) {
+        bank->step_ramp(m_retune_step, k_retune_steps);
+    }
+    for (auto* bank : {&m_precise_signal_bandpass,
+                       &m_precise_carrier_bandpass,
+                       &m_precise_envelope_lowpass,
+                       &m_precise_output_bandpass}) {
+        bank->step_ramp(m_retune_step, k_retune_steps);
+    }
+    m_until_step = k_retune_step_size;
+    if (m_retune_step == k_retune_steps) {
+        finish_retune();
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::finish_retune() {
+    m_retune_step = k_retune_steps;
+    drop_bands();
+    m_precise_lanes.assign(m_precise_target.begin(), m_precise_target.end());
+    resize_precise();
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::drop_bands() {
+    if (m_signal_bandpass.size() == m_num_bands) {
+        return;
+    }
+    for (auto* bank : {&m_signal_bandpass, &m_carrier_bandpass,
+                       &m_envelope_lowpass, &m_output_bandpass}) {
+        bank->set_size(m_num_bands);
+    }
+    std::erase_if(m_precise_lanes,
+                  [&](std::size_t lane) { return lane >= m_num_bands; });
+    resize_precise();
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::resize_precise() {
+    // Up to the highest band listed, as they're the lowest ones. Any
+    // between that aren't listed have silent filters.
+    std::size_t size = 0;
+    for (std::size_t const lane : m_precise_lanes) {
+        size = std::max(size, lane + 1);
+    }
+    for (auto* bank : {&m_precise_signal_bandpass,
+                       &m_precise_carrier_bandpass,
+                       &m_precise_envelope_lowpass,
+                       &m_precise_output_bandpass}) {
+        bank->set_size(size);
+    }
+}
 
-    // Store it back.
-    std::copy_n(result_block.data(), k_block_size, output);
+template <typename Policy>
+void BasicVocoderRT<Policy>::run(Sample const* signal, Sample const* carrier,
+                                 float const* carrier_bands, std::size_t count,
+                                 Sample* output) {
+    if constexpr (k_float) {
+        run_float(signal, carrier, carrier_bands, count, output);
+    } else {
+        run_fixed(signal, carrier, count, output);
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::run_float(float const* signal, float const* carrier,
+                                       float const* carrier_bands,
+                                       std::size_t count, float* output)
+    requires k_float
+{
+    if (m_silence_level > 0) {
+        std::size_t const silent =
+            skip_silence(signal, carrier, count, output);
+        if (silent == count) {
+            return;
+        }
+        signal += silent;
+        if (carrier) {
+            carrier += silent;
+        } else {
+            carrier_bands += silent * m_signal_bandpass.stride();
+        }
+        count -= silent;
+        output += silent;
+    }
+
+    if (m_fused) {
+        VocoderBankRefs banks{
+            m_signal_bandpass.refs(), m_carrier_bandpass.refs(),
+            m_envelope_lowpass.refs(), m_output_bandpass.refs()};
+        if (m_gate_level > 0) {
+            banks.gate = {m_gate_level, m_band_active.data()};
+            m_gated += count * m_signal_bandpass.stride();
+        }
+        if (m_workers) {
+            process_threaded(banks, signal, carrier, carrier_bands, count,
+                             output);
+        } else {
+            m_skipped += run_fused(banks, signal, carrier, carrier_bands, 0,
+                                   count, output);
+        }
+
+        // Need to scale it up a bit.
+        mul(std::span{output, count}, 50);
+    } else {
+        assert(m_envelope_step == 1);
+        std::size_t const stride = m_signal_bandpass.stride();
+        for (std::size_t i = 0; i < count; i += k_block_size) {
+            process_block(signal + i, carrier ? carrier + i : nullptr,
+                          carrier_bands ? carrier_bands + i * stride : nullptr,
+                          std::min(count - i, k_block_size), output + i);
+        }
+    }
+
+    if (!m_precise_lanes.empty()) {
+        process_precise(signal, carrier, carrier_bands, count, output);
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::run_fixed(Sample const* signal, Sample const* carrier,
+                                       std::size_t count, Sample* output)
+    requires(!k_float)
+{
+    FixedPointVocoderBankRefs const banks{
+        m_signal_bandpass.refs(), m_carrier_bandpass.refs(),
+        m_envelope_lowpass.refs(), m_output_bandpass.refs()};
+    for (std::size_t start = 0; start < count; start += k_fixed_chunk_size) {
+        std::size_t const chunk = std::min(count - start, k_fixed_chunk_size);
+        for (std::size_t i = 0; i < chunk; i++) {
+            m_signal_block[i] = Policy::from_sample(signal[start + i]);
+            m_carrier_block[i] = Policy::from_sample(carrier[start + i]);
+        }
+        std::fill(m_sums.begin(), m_sums.begin() + chunk, 0);
+        kernels().vocoder_fixed_point(banks, m_signal_block.data(),
+                                      m_carrier_block.data(), m_sums.data(),
+                                      chunk);
+
+        // Need to scale it up a bit.
+        for (std::size_t i = 0; i < chunk; i++) {
+            output[start + i] = Policy::output(m_sums[i], 50);
+        }
+    }
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::process_precise(float const* signal,
+                                             float const* carrier,
+                                             float const* carrier_bands,
+                                             std::size_t count, float* output)
+    requires k_float
+{
+    // The envelope runs every sample whatever the step, as these bands are
+    // few. Scaled up a bit, as the rest were.
+    PreciseVocoderBankRefs const banks{
+        m_precise_signal_bandpass.refs(), m_precise_carrier_bandpass.refs(),
+        m_precise_envelope_lowpass.refs(), m_precise_output_bandpass.refs()};
+    if (carrier_bands) {
+        kernels().vocoder_precise_analyzed(banks, signal, carrier_bands,
+                                           m_signal_bandpass.stride(), output,
+                                           count, 50);
+    } else {
+        kernels().vocoder_precise(banks, signal, carrier, output, count, 50);
+    }
+}
+
+template <typename Policy>
+double BasicVocoderRT<Policy>::precise_peak_state() const
+    requires k_float
+{
+    return std::max({m_precise_signal_bandpass.peak_state(),
+                     m_precise_envelope_lowpass.peak_state(),
+                     m_precise_output_bandpass.peak_state()});
+}
+
+template <typename Policy>
+std::size_t BasicVocoderRT<Policy>::skip_silence(float const* signal,
+                                                  float const* carrier,
+                                                  std::size_t count,
+                                                  float* output)
+    requires k_float
+{
+    float const level = m_silence_level;
+    auto const quiet = [level](float sample) {
+        return std::abs(sample) < level;
+    };
+    if (!m_silent) {
+        // Only goes quiet at the start of a call, once what came before has
+        // rung down.
+        if (!std::all_of(signal, signal + count, quiet) ||
+            m_signal_bandpass.peak_state() >= level ||
+            m_envelope_lowpass.peak_state() >= level ||
+            m_output_bandpass.peak_state() >= level ||
+            precise_peak_state() >= level) {
+            return 0;
+        }
+        m_signal_bandpass.clear();
+        m_envelope_lowpass.clear();
+        m_output_bandpass.clear();
+        m_precise_signal_bandpass.clear();
+        m_precise_envelope_lowpass.clear();
+        m_precise_output_bandpass.clear();
+        m_silent = true;
+    }
+    std::size_t const silent =
+        std::find_if_not(signal, signal + count, quiet) - signal;
+    m_silent = silent == count;
+
+    // Keep the carrier's filters going, unless it's been filtered already.
+    if (carrier) {
+        std::size_t const stride = m_carrier_bandpass.stride();
+        for (std::size_t i = 0; i < silent; i += k_block_size) {
+            std::size_t const block = std::min(silent - i, k_block_size);
+            m_carrier_bandpass.process_block(
+                std::span{carrier + i, block},
+                std::span{m_carrier_block}.first(block * stride));
+        }
+        m_precise_carrier_bandpass.skip(std::span{carrier, silent});
+    }
+    std::fill(output, output + silent, 0.0f);
+    return silent;
+}
+
+template <typename Policy>
+std::size_t BasicVocoderRT<Policy>::run_fused(VocoderBankRefs const& banks,
+                                               float const* signal,
+                                               float const* carrier,
+                                               float const* carrier_bands,
+                                               std::size_t first,
+                                               std::size_t count, float* output)
+    requires k_float
+{
+    if (carrier_bands) {
+        return kernels().vocoder_analyzed(
+            banks, signal, carrier_bands + first, m_signal_bandpass.stride(),
+            output, count, k_tile_size, m_envelope_step);
+    }
+    return kernels().vocoder(banks, signal, carrier, output, count,
+                             k_tile_size, m_envelope_step);
+}
+
+template <typename Policy>
+void BasicVocoderRT<Policy>::process_threaded(VocoderBankRefs const& banks,
+                                              float const* signal,
+                                              float const* carrier,
+                                              float const* carrier_bands,
+                                              std::size_t count, float* output)
+    requires k_float
+{
+    static_assert(k_thread_chunk_size % k_max_envelope_step == 0);
+    std::size_t const num_threads = m_workers->num_threads();
+    std::size_t const stride = banks.signal_bandpass.stride;
+    std::size_t const num_groups = stride / k_max_lanes;
+    for (std::size_t start = 0; start < count; start += k_thread_chunk_size) {
+        std::size_t const chunk = std::min(count - start, k_thread_chunk_size);
+        auto task = [&](std::size_t worker) {
+            // Whole groups, so that every range stays aligned.
+            std::size_t const first =
+                worker * num_groups / num_threads * k_max_lanes;
+            std::size_t const last =
+                (worker + 1) * num_groups / num_threads * k_max_lanes;
+            VocoderBankRefs range{
+                slice(banks.signal_bandpass, first, last - first),
+                slice(banks.carrier_bandpass, first, last - first),
+                slice(banks.envelope_lowpass, first, last - first),
+                slice(banks.output_bandpass, first, last - first)};
+            if (banks.gate.active) {
+                range.gate = {banks.gate.level, banks.gate.active + first};
+            }
+            float* const range_output =
+                worker == 0 ? output + start
+                            : &m_thread_output[(worker - 1) *
+                                               k_thread_chunk_size];
+            // Retuned to fewer bands than there are threads.
+            if (first == last) {
+                std::fill(range_output, range_output + chunk, 0.0f);
+                m_thread_skipped[worker] = 0;
+                return;
+            }
+            m_thread_skipped[worker] = run_fused(
+                range, signal + start, carrier ? carrier + start : nullptr,
+                carrier_bands ? carrier_bands + start * stride : nullptr,
+                first, chunk, range_output);
+        };
+        m_workers->run(task);
+        for (std::size_t const skipped : m_thread_skipped) {
+            m_skipped += skipped;
+        }
+
+        // Sum in a fixed order so that the result doesn't depend on timing.
+        for (std::size_t worker = 1; worker < num_threads; worker++) {
+            add(std::span{output + start, chunk},
+                std::span{m_thread_output}.subspan(
+                    (worker - 1) * k_thread_chunk_size, chunk));
+        }
+    }
 }
 
+template <typename Policy>
+void BasicVocoderRT<Policy>::process_block(float const* signal,
+                                           float const* carrier,
+                                           float const* carrier_bands,
+                                           std::size_t count, float* output)
+    requires k_float
+{
+    static_assert(k_block_size == BiquadBank::k_block_size);
+    assert(count <= k_block_size);
+    std::size_t const stride = m_signal_bandpass.stride();
+    std::span<float> const signal_block =
+        std::span{m_signal_block}.first(count * stride);
+
+    // Bandpass both inputs into every band at once, unless the carrier has
+    // been already.
+    m_signal_bandpass.process_block(std::span{signal, count}, signal_block);
+    std::span<float const> carrier_block;
+    if (carrier_bands) {
+        carrier_block = std::span{carrier_bands, count * stride};
+    } else {
+        std::span<float> const block =
+            std::span{m_carrier_block}.first(count * stride);
+        m_carrier_bandpass.process_block(std::span{carrier, count}, block);
+        carrier_block = block;
+    }
+
+    // Calculate envelope.
+    abs(signal_block);
+    m_envelope_lowpass.process_block(signal_block);
+
+    // Combine.
+    mul(signal_block, carrier_block);
+    m_output_bandpass.process_block(signal_block);
+
+    // Sum the bands for each sample.
+    kernels().sum_lanes(signal_block.data(), stride, count, output);
+
+    // Need to scale it up a bit.
+    mul(std::span{output, count}, 50);
+}
+
+template class BasicVocoderRT<FloatPolicy>;
+template class BasicVocoderRT<Q31Policy>;
+template class BasicVocoderRT<Q31Int16Policy>;
+
 }  // namespace pwv
@@ -1,12 +1,21 @@
 #pragma once
 
+#include "BiquadBank.h"
+#include "NumericPolicy.h"
+#include "SecondOrderFilter.h"
+
+#include <atomic>
+#include <limits>
+#include <memory>
 #include <span>
+#include <type_traits>
 #include <vector>
 
 namespace pwv {
 
-class BandPass;
-class LowPass;
+class CarrierAnalysis;
+class SpinWorkers;
+class ThreadPool;
 
 // Reference implementation.
 class Vocoder {
@@ -17,40 +26,340 @@ class Vocoder {
     std::vector<float> process(std::span<float const> signal,
                                std::span<float const> carrier);
 
+    // Streams inputs too long to hold at once. Call start(), and then
+    // process_chunk() on each chunk in turn. Every chunk but the last must
+    // be k_chunk_size samples, and the output matches process() on the lot.
+    static constexpr std::size_t k_chunk_size = 8192;
+    void start();
+    void process_chunk(std::span<float const> signal,
+                       std::span<float const> carrier,
+                       std::span<float> output);
+
+    // Samples of input it takes for the filters to forget where they
+    // started, to |level| of it. Saturates if some filter never does.
+    std::size_t pre_roll(double level) const;
+
+    // Shares the bands out across this many threads, including the caller.
+    // The result is the same for any number.
+    void set_num_threads(std::size_t num_threads);
+
   private:
     Vocoder(Vocoder const&) = delete;
     Vocoder& operator=(Vocoder const&) = delete;
 
+  private:
+    struct Band;
+
   private:
     double const m_distance;
     int const m_num_bands;
     double const m_sampling_rate;
     double const m_q;
+    std::unique_ptr<ThreadPool> m_pool;
+
+    std::vector<Band> m_bands;
+    // Per thread.
+    std::vector<std::vector<float>> m_carrier_scratch;
+};
+
+// Filters for a single band of a vocoder.
+struct VocoderBand {
+    double hz;
+    SecondOrderFilter::Coefs bandpass;
+    SecondOrderFilter::Coefs lowpass;
+    // The same, before rounding.
+    SecondOrderFilter::PreciseCoefs precise_bandpass;
+    SecondOrderFilter::PreciseCoefs precise_lowpass;
+};
+
+std::vector<VocoderBand> vocoder_bands(double distance, int num_bands,
+                                       double sampling_rate);
+
+// Common interface to the realtime versions.
+class IVocoderRT {
+  public:
+    virtual ~IVocoderRT() = default;
+
+    // |count| must be a multiple of this.
+    virtual std::size_t block_size() const = 0;
+    // Number of samples the output lags the input by.
+    virtual std::size_t latency() const { return 0; }
+
+    virtual void process(float const* signal, float const* carrier,
+                         std::size_t count, float* output) = 0;
 };
 
-// Realtime version.
-class VocoderRT {
+// Realtime version, in the arithmetic of a NumericPolicy. VocoderRT runs in
+// floats, and has every option below. The fixed point versions run the same
+// bands, and retune the same way, through the integer kernel, with the
+// envelope followers every sample and none of the options marked for floats
+// only. Doubles are what VocoderRT runs its lowest bands in, or every band,
+// see set_precise_tolerance().
+template <typename Policy>
+class BasicVocoderRT : public IVocoderRT {
+    static constexpr bool k_float = std::is_same_v<Policy, FloatPolicy>;
+
   public:
+    using Sample = typename Policy::Sample;
+    // Samples each stage runs for at a time when not fused. Any count can be
+    // processed, with a shorter block at the end.
     static constexpr std::size_t k_block_size = 16;
+    // Number of samples each group of bands runs for at a time when fused.
+    static constexpr std::size_t k_tile_size = 64;
+    // About 0.01 dB of a band's gain, see set_precise_tolerance().
+    static constexpr double k_precise_tolerance = 1e-3;
+    // Steps a retune takes to ramp the filters over, and samples per step.
+    static constexpr std::size_t k_retune_steps = 16;
+    static constexpr std::size_t k_retune_step_size = k_tile_size;
 
   public:
-    VocoderRT(double distance, int num_bands, double sampling_rate);
-    ~VocoderRT();
+    BasicVocoderRT(double distance, int num_bands, double sampling_rate);
+    // As above, with room to retune() to up to |max_bands|.
+    BasicVocoderRT(double distance, int num_bands, double sampling_rate,
+                   int max_bands);
+    ~BasicVocoderRT() override;
+
+    // Designs the filters for new settings, which the next process() picks
+    // up. Call it from one thread other than the realtime one. It allocates
+    // and waits for a process() in progress to finish picking up the last
+    // settings, but process() only copies coefficients over. The filters
+    // keep their state through the change rather than restarting from rest,
+    // and move over to the new coefficients in k_retune_steps steps, one
+    // every k_retune_step_size samples, so that the change doesn't click.
+    // Bands dropped fade out over the same time, or go at once when the
+    // carrier comes from a CarrierAnalysis, and any new bands start from
+    // rest.
+    void retune(double distance, int num_bands, double sampling_rate);
+
+    std::size_t block_size() const override { return 1; }
 
+    // In fixed point, rounds the inputs to Sample, and back.
     void process(float const* signal, float const* carrier, std::size_t count,
-                 float* output);
+                 float* output) override;
+    // As above, in Sample throughout. For 16 bit samples, that takes those of
+    // a WAV file as they are (see load_wav_int16()).
+    void process_samples(Sample const* signal, Sample const* carrier,
+                         std::size_t count, Sample* output)
+        requires(!k_float);
+    // As above, over the samples |carrier| last analyzed, and without
+    // filtering the carrier again. It must have the same bands and rate.
+    // Floats only.
+    void process(float const* signal, CarrierAnalysis const& carrier,
+                 float* output)
+        requires k_float;
+
+    // By default every stage runs per group of bands over a tile of samples.
+    // Turning this off runs each stage over every band a block at a time.
+    // Floats only, as are the options down to set_num_threads().
+    void set_fused(bool fused)
+        requires k_float
+    {
+        m_fused = fused;
+    }
+
+    // Runs the envelope followers once every |step| samples, on the mean of
+    // the rectified band, and interpolates in between. Only used when fused.
+    // Must be a power of two up to k_block_size. A call that isn't a whole
+    // number of steps ends on a short one.
+    void set_envelope_step(std::size_t step)
+        requires k_float;
+
+    // Skips the output stage of a group of bands while nothing going into or
+    // out of it reaches |level|, once it has been quiet for a whole tile. It
+    // opens again from the start of the tile where something does. Only used
+    // when fused, and off at 0, the default.
+    void set_band_gate(float level)
+        requires k_float;
+    // Fraction of the output stage the gate has skipped so far, in samples
+    // of each band.
+    double skipped_fraction() const;
+
+    // Once the signal, and what it left ringing in the filters, have all
+    // fallen under |level|, writes silence without running them. They start
+    // again from rest at the first sample of signal that reaches it, so only
+    // what was under it is lost. The carrier's filters keep running so that
+    // the carrier carries on where it would have. Off at 0, the default.
+    void set_silence_level(float level)
+        requires k_float
+    {
+        m_silence_level = level;
+    }
+
+    // Runs the bands whose gain rounding to floats could throw off by more
+    // than |tolerance| in doubles, and the rest in floats as usual. That goes
+    // by SecondOrderFilter::rounding_error() for the bandpass at the band's
+    // centre. Those are the lowest bands, more of them at higher rates and
+    // with more bands, and they run in banks of their own. The float lanes
+    // of a band that moves over fade out, and its carrier still comes from a
+    // CarrierAnalysis in floats. Picked up by the next process(), as with
+    // retune(), and from the same thread. Off at infinity, the default, and
+    // every band at 0.
+    void set_precise_tolerance(double tolerance)
+        requires k_float;
+
+    // Splits the bands across this many threads, including the caller, when
+    // fused. Only pays off for many bands and long quanta (see the
+    // benchmark). Not realtime safe itself, but process() stays so.
+    void set_num_threads(std::size_t num_threads)
+        requires k_float;
+    // Gives the helper threads the calling thread's scheduling and a core
+    // each, see SpinWorkers::bind_to_current_thread(). Not realtime safe
+    // either, so call it once from the thread that calls process(), when the
+    // stream starts.
+    void bind_threads()
+        requires k_float;
+
+  private:
+    BasicVocoderRT(BasicVocoderRT const&) = delete;
+    BasicVocoderRT& operator=(BasicVocoderRT const&) = delete;
 
   private:
-    VocoderRT(VocoderRT const&) = delete;
-    VocoderRT& operator=(VocoderRT const&) = delete;
+    using Bank = BasicBiquadBank<Policy>;
+    using Coefs = typename Policy::Coefs;
+    using State = typename Policy::State;
+
+    // Samples each thread runs between meeting the others.
+    static constexpr std::size_t k_thread_chunk_size = 1024;
+    // Samples the fixed point kernel runs at a time.
+    static constexpr std::size_t k_fixed_chunk_size = 256;
+
+    // Filters for a set of settings, designed off the realtime thread.
+    struct Tuning {
+        double distance;
+        double sampling_rate;
+        std::vector<VocoderBand> bands;
+        // Rounded for the policy, the envelope followers at the envelope
+        // step's rate.
+        std::vector<Coefs> bandpass;
+        std::vector<Coefs> envelope_lowpass;
+        // Bands to run in doubles.
+        std::vector<std::size_t> precise;
+    };
 
   private:
+    void design(Tuning& tuning, double distance, int num_bands,
+                double sampling_rate) const;
+    // Starts the filters ramping over to |tuning|.
+    void apply(Tuning const& tuning);
+    // Takes the next step of the ramp, and finishes it on the last.
+    void step_retune();
+    void finish_retune();
+    // Lets go of the bands the last retune dropped.
+    void drop_bands();
+    // Sizes the banks in doubles to cover the bands listed for them.
+    void resize_precise();
+    // Takes the settings back from process() to design afresh.
+    Tuning* take_tuning();
+
+    // Takes either the |carrier| or its |carrier_bands|, as analyzed by a
+    // CarrierAnalysis, and leaves the other null.
+    void process(Sample const* signal, Sample const* carrier,
+                 float const* carrier_bands, std::size_t count,
+                 Sample* output);
+    // As above, with the filters' coefficients held for the whole call.
+    void run(Sample const* signal, Sample const* carrier,
+             float const* carrier_bands, std::size_t count, Sample* output);
+    void run_float(float const* signal, float const* carrier,
+                   float const* carrier_bands, std::size_t count,
+                   float* output)
+        requires k_float;
+    // Runs every band through the fixed point kernel.
+    void run_fixed(Sample const* signal, Sample const* carrier,
+                   std::size_t count, Sample* output)
+        requires(!k_float);
+    // Writes silence over as much of the start of a call as is under the
+    // silence level, if it's gone quiet or can, and returns how much.
+    std::size_t skip_silence(float const* signal, float const* carrier,
+                             std::size_t count, float* output)
+        requires k_float;
     void process_block(float const* signal, float const* carrier,
-                       float* output);
+                       float const* carrier_bands, std::size_t count,
+                       float* output)
+        requires k_float;
+    // Adds the bands run in doubles to |output|.
+    void process_precise(float const* signal, float const* carrier,
+                         float const* carrier_bands, std::size_t count,
+                         float* output)
+        requires k_float;
+    double precise_peak_state() const
+        requires k_float;
+    void process_threaded(VocoderBankRefs const& banks, float const* signal,
+                          float const* carrier, float const* carrier_bands,
+                          std::size_t count, float* output)
+        requires k_float;
+    // Runs the fused kernel over the lanes of |banks|, which start at lane
+    // |first| of the carrier's bands.
+    // Returns the samples skipped, as kernels().vocoder() does.
+    std::size_t run_fused(VocoderBankRefs const& banks, float const* signal,
+                          float const* carrier, float const* carrier_bands,
+                          std::size_t first, std::size_t count, float* output)
+        requires k_float;
 
   private:
-    std::vector<BandPass> m_bandpass;
-    std::vector<LowPass> m_lowpass;
+    // One lane per band.
+    Bank m_signal_bandpass;
+    Bank m_carrier_bandpass;
+    Bank m_envelope_lowpass;
+    Bank m_output_bandpass;
+
+    // Scratch blocks, sized for every band, or in fixed point for a chunk of
+    // the inputs and the sums of its bands.
+    std::vector<State> m_signal_block;
+    std::vector<State> m_carrier_block;
+    std::vector<int64_t> m_sums;
+
+    bool m_fused = true;
+
+    // For rebuilding the envelope followers at another rate.
+    double m_sampling_rate;
+    std::vector<double> m_envelope_hz;
+    std::size_t m_envelope_step = 1;
+
+    // A flag per lane for the gate, and what it has skipped of how much.
+    float m_gate_level = 0;
+    std::vector<uint8_t> m_band_active;
+    std::size_t m_skipped = 0;
+    std::size_t m_gated = 0;
+
+    // Settings from retune() move through a single Tuning, which is pending
+    // until process() applies it, and spare after. While process() is
+    // applying it, it's in neither.
+    std::size_t const m_max_bands;
+    std::unique_ptr<Tuning> m_tuning;
+    std::atomic<Tuning*> m_pending = nullptr;
+    std::atomic<Tuning*> m_spare = nullptr;
+    // Bands tuned to, which the banks keep room for those fading out on top
+    // of until the ramp is done, and where it's got to.
+    std::size_t m_num_bands = 0;
+    std::size_t m_retune_step = k_retune_steps;
+    std::size_t m_until_step = 0;
+
+    // Indexed by lane, up to the highest of those listed, which run in
+    // doubles.
+    double m_precise_tolerance = std::numeric_limits<double>::infinity();
+    PreciseBiquadBank m_precise_signal_bandpass;
+    PreciseBiquadBank m_precise_carrier_bandpass;
+    PreciseBiquadBank m_precise_envelope_lowpass;
+    PreciseBiquadBank m_precise_output_bandpass;
+    std::vector<std::size_t> m_precise_lanes;
+    // Those of the last retune, while others are still fading out.
+    std::vector<std::size_t> m_precise_target;
+
+    // Whether the signal's filters are at rest while it's under the level.
+    float m_silence_level = 0;
+    bool m_silent = false;
+
+    // Each helper thread takes the next range of band groups, and its share
+    // of the output for a chunk goes in here to be summed after.
+    std::unique_ptr<SpinWorkers> m_workers;
+    std::vector<float> m_thread_output;
+    std::vector<std::size_t> m_thread_skipped;
 };
 
+extern template class BasicVocoderRT<FloatPolicy>;
+extern template class BasicVocoderRT<Q31Policy>;
+extern template class BasicVocoderRT<Q31Int16Policy>;
+
+using VocoderRT = BasicVocoderRT<FloatPolicy>;
+
 }  // namespace pwv
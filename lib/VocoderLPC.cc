@@ -0,0 +1,146 @@
+#include "VocoderLPC.h"
+
+#include "Denormals.h"
+#include "Kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace pwv {
+
+namespace {
+
+// Added to the power at lag 0 so that silence or a pure tone still gives a
+// stable fit.
+constexpr double k_noise_floor = 1e-9;
+constexpr double k_white_noise = 1e-4;
+
+}  // namespace
+
+VocoderLPC::VocoderLPC(std::size_t order)
+    : m_order(order),
+      m_signal(k_window_size),
+      m_carrier(k_window_size),
+      m_window(k_window_size),
+      m_windowed(k_window_size),
+      m_whiten_state(order),
+      m_forward(k_hop_size),
+      m_backward(k_hop_size) {
+    assert(order != 0 && order <= k_max_order);
+
+    for (std::size_t i = 0; i < k_window_size; i++) {
+        m_window[i] = static_cast<float>(
+            0.5 - 0.5 * std::cos(2 * M_PI * (i + 0.5) / k_window_size));
+    }
+    m_signal_model.reflection.resize(order);
+    m_carrier_model.reflection.resize(order);
+    for (std::size_t parity = 0; parity < 2; parity++) {
+        m_synthesis_reflection[parity].resize(order / 2 + 1);
+        m_synthesis_state[parity].resize(order / 2 + 1);
+    }
+}
+
+VocoderLPC::~VocoderLPC() {}
+
+std::size_t VocoderLPC::speech_order(double sampling_rate) {
+    // A pair of poles per kHz of bandwidth, plus a few for the overall tilt.
+    auto const order = static_cast<std::size_t>(sampling_rate / 1000) + 4;
+    return std::min(order, k_max_order);
+}
+
+void VocoderLPC::process(float const* signal, float const* carrier,
+                         std::size_t count, float* output) {
+    FlushDenormals const flush_denormals;
+    std::size_t const history = k_window_size - k_hop_size;
+    while (count != 0) {
+        std::size_t const n = std::min(count, k_hop_size - m_fill);
+        std::copy_n(signal, n, m_signal.begin() + history + m_fill);
+        std::copy_n(carrier, n, m_carrier.begin() + history + m_fill);
+        filter(carrier, n, output);
+        m_fill += n;
+        signal += n;
+        carrier += n;
+        output += n;
+        count -= n;
+
+        // Refit once a hop has come in, and slide the windows along.
+        if (m_fill == k_hop_size) {
+            analyse(m_signal, m_signal_model);
+            analyse(m_carrier, m_carrier_model);
+            for (std::size_t i = 0; i < m_order; i++) {
+                m_synthesis_reflection[i % 2][i / 2] =
+                    m_signal_model.reflection[i];
+            }
+            std::copy(m_signal.begin() + k_hop_size, m_signal.end(),
+                      m_signal.begin());
+            std::copy(m_carrier.begin() + k_hop_size, m_carrier.end(),
+                      m_carrier.begin());
+            m_fill = 0;
+
+            double const floor = k_noise_floor * k_window_size;
+            float const gain = static_cast<float>(std::sqrt(
+                m_signal_model.error / (m_carrier_model.error + floor)));
+            m_gain_step = (gain - m_gain) / k_hop_size;
+        }
+    }
+}
+
+void VocoderLPC::analyse(std::vector<float> const& history, Model& model) {
+    Kernels const& kernels = pwv::kernels();
+    std::copy(history.begin(), history.end(), m_windowed.begin());
+    kernels.mul(m_windowed.data(), m_window.data(), k_window_size);
+
+    std::array<double, k_max_order + 1> correlation;
+    for (std::size_t lag = 0; lag <= m_order; lag++) {
+        correlation[lag] = kernels.dot(m_windowed.data(),
+                                       m_windowed.data() + lag,
+                                       k_window_size - lag);
+    }
+
+    // Levinson-Durbin, for the predictor x[n] ~ -sum a[j] x[n - j].
+    std::array<double, k_max_order + 1> a{1};
+    double error = correlation[0] * (1 + k_white_noise) +
+                   k_noise_floor * k_window_size;
+    for (std::size_t i = 1; i <= m_order; i++) {
+        double total = correlation[i];
+        for (std::size_t j = 1; j < i; j++) {
+            total += a[j] * correlation[i - j];
+        }
+        double const k = -total / error;
+        for (std::size_t j = 1, mirror = i - 1; j <= mirror; j++, mirror--) {
+            double const low = a[j];
+            double const high = a[mirror];
+            a[j] = low + k * high;
+            a[mirror] = high + k * low;
+        }
+        a[i] = k;
+        error *= 1 - k * k;
+        model.reflection[i - 1] = static_cast<float>(k);
+    }
+    model.error = error;
+}
+
+void VocoderLPC::filter(float const* carrier, std::size_t count,
+                        float* output) {
+    Kernels const& kernels = pwv::kernels();
+    float* const forward = m_forward.data();
+    float* const backward = m_backward.data();
+    std::copy_n(carrier, count, forward);
+    std::copy_n(carrier, count, backward);
+    kernels.lattice_inverse(m_carrier_model.reflection.data(),
+                            m_whiten_state.data(), m_order, forward, backward,
+                            count);
+    kernels.lattice_all_pole(
+        m_synthesis_reflection[0].data(), m_synthesis_reflection[1].data(),
+        m_synthesis_state[0].data(), m_synthesis_state[1].data(), m_order,
+        forward, count);
+
+    for (std::size_t n = 0; n < count; n++) {
+        m_gain += m_gain_step;
+        output[n] = forward[n] * m_gain;
+    }
+}
+
+}  // namespace pwv
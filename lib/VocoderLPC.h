@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Vocoder.h"
+
+#include <array>
+#include <vector>
+
+namespace pwv {
+
+// Realtime version based on linear prediction. Every hop both inputs are
+// fitted with an all-pole model over the last window of samples. The carrier
+// runs through the inverse of its own model to flatten its spectrum, and then
+// through the signal's model to take on the signal's envelope. The cost per
+// sample grows with the order rather than the number of bands, but the
+// envelope is coarser.
+class VocoderLPC final : public IVocoderRT {
+  public:
+    static constexpr std::size_t k_max_order = 64;
+    static constexpr std::size_t k_hop_size = 256;
+    static constexpr std::size_t k_window_size = 4 * k_hop_size;
+
+  public:
+    explicit VocoderLPC(std::size_t order);
+    ~VocoderLPC() override;
+
+    std::size_t block_size() const override { return 1; }
+
+    void process(float const* signal, float const* carrier, std::size_t count,
+                 float* output) override;
+
+    // About enough poles for the formants of speech at |sampling_rate|.
+    static std::size_t speech_order(double sampling_rate);
+
+  private:
+    VocoderLPC(VocoderLPC const&) = delete;
+    VocoderLPC& operator=(VocoderLPC const&) = delete;
+
+  private:
+    // All-pole fit of a window of samples.
+    struct Model {
+        std::vector<float> reflection;
+        // Power left over after prediction.
+        double error = 0;
+    };
+
+    void analyse(std::vector<float> const& history, Model& model);
+    void filter(float const* carrier, std::size_t count, float* output);
+
+  private:
+    std::size_t const m_order;
+
+    // The last window of input. The first m_fill samples of the hop have
+    // been filled so far.
+    std::vector<float> m_signal;
+    std::vector<float> m_carrier;
+    std::size_t m_fill = 0;
+
+    std::vector<float> m_window;
+    std::vector<float> m_windowed;
+
+    Model m_signal_model;
+    Model m_carrier_model;
+
+    // Backward errors of each lattice from the previous sample. The
+    // synthesis one is split into even and odd stages as Kernels wants, as
+    // are its coefficients.
+    std::vector<float> m_whiten_state;
+    std::array<std::vector<float>, 2> m_synthesis_reflection;
+    std::array<std::vector<float>, 2> m_synthesis_state;
+
+    // Errors of the samples going through the lattices, up to a hop.
+    std::vector<float> m_forward;
+    std::vector<float> m_backward;
+
+    // Matches the output level to the signal's, ramped across each hop.
+    float m_gain = 0;
+    float m_gain_step = 0;
+};
+
+}  // namespace pwv
@@ -0,0 +1,167 @@
+#include "VocoderSTFT.h"
+
+#include "BandPass.h"
+#include "Denormals.h"
+#include "Kernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace pwv {
+
+VocoderSTFT::VocoderSTFT(double distance, int num_bands, double sampling_rate,
+                         std::size_t frame_size, std::size_t hop_size)
+    : m_frame_size(frame_size),
+      m_hop_size(hop_size),
+      m_fft(frame_size),
+      m_analysis_window(frame_size),
+      m_synthesis_window(frame_size),
+      m_signal(frame_size),
+      m_carrier(frame_size),
+      m_output(frame_size),
+      m_re(frame_size),
+      m_im(frame_size) {
+    assert(hop_size != 0 && frame_size % hop_size == 0);
+    assert(hop_size <= frame_size / 2);
+
+    // The squared windows overlap to frame_size / (2 * hop_size).
+    double const n = static_cast<double>(frame_size);
+    double const scale = 2.0 * hop_size / n / n;
+    for (std::size_t i = 0; i < frame_size; i++) {
+        double const window = std::sqrt(0.5 - 0.5 * std::cos(2 * M_PI * i / n));
+        m_analysis_window[i] = static_cast<float>(window);
+        m_synthesis_window[i] = static_cast<float>(window * scale);
+    }
+
+    // Band centres, with a silent one a band's distance beyond each end.
+    std::vector<double> centres{0};
+    for (auto const& band : vocoder_bands(distance, num_bands, sampling_rate)) {
+        centres.push_back(band.hz);
+    }
+    assert(centres.size() > 1);
+    double const ratio =
+        centres.size() > 2 ? centres[2] / centres[1] : std::sqrt(2);
+    centres.push_back(centres.back() * ratio);
+    centres[0] = centres[1] / ratio;
+
+    std::size_t band = 0;
+    for (std::size_t bin = 0; bin <= frame_size / 2; bin++) {
+        double const hz = bin * sampling_rate / n;
+        while (band + 2 < centres.size() && centres[band + 1] <= hz) {
+            band++;
+        }
+        double weight = 0;
+        if (hz >= centres.back()) {
+            weight = 1;
+        } else if (hz > centres[band]) {
+            weight = std::log(hz / centres[band]) /
+                     std::log(centres[band + 1] / centres[band]);
+        }
+        m_bin_band.push_back(band);
+        m_bin_weight.push_back(static_cast<float>(weight));
+    }
+
+    // One pole smoothing at the frame rate, kept clear of its Nyquist.
+    double const frame_rate = sampling_rate / hop_size;
+    for (double const hz : centres) {
+        double const cutoff = std::min(hz / distance, 0.4 * frame_rate);
+        m_envelope_decay.push_back(
+            static_cast<float>(std::exp(-2 * M_PI * cutoff / frame_rate)));
+    }
+    m_energy.resize(centres.size());
+    m_envelope.resize(centres.size());
+}
+
+VocoderSTFT::~VocoderSTFT() {}
+
+void VocoderSTFT::process(float const* signal, float const* carrier,
+                          std::size_t count, float* output) {
+    FlushDenormals const flush_denormals;
+    std::size_t const history = m_frame_size - m_hop_size;
+    while (count != 0) {
+        std::size_t const n = std::min(count, m_hop_size - m_fill);
+        std::copy_n(signal, n, m_signal.begin() + history + m_fill);
+        std::copy_n(carrier, n, m_carrier.begin() + history + m_fill);
+        std::copy_n(m_output.begin() + m_fill, n, output);
+        m_fill += n;
+        signal += n;
+        carrier += n;
+        output += n;
+        count -= n;
+
+        if (m_fill == m_hop_size) {
+            process_frame();
+            m_fill = 0;
+        }
+    }
+}
+
+void VocoderSTFT::process_frame() {
+    Kernels const& kernels = pwv::kernels();
+    std::size_t const n = m_frame_size;
+    std::size_t const nyquist = n / 2;
+
+    // Both inputs go through one transform, the carrier as the imaginary part.
+    std::copy(m_signal.begin(), m_signal.end(), m_re.begin());
+    std::copy(m_carrier.begin(), m_carrier.end(), m_im.begin());
+    kernels.mul(m_re.data(), m_analysis_window.data(), n);
+    kernels.mul(m_im.data(), m_analysis_window.data(), n);
+    m_fft.forward(m_re, m_im);
+
+    // Bin k of the signal is (Z[k] + conj(Z[n - k])) / 2.
+    std::fill(m_energy.begin(), m_energy.end(), 0.0f);
+    for (std::size_t k = 0; k <= nyquist; k++) {
+        std::size_t const mirror = (n - k) % n;
+        float const re = m_re[k] + m_re[mirror];
+        float const im = m_im[k] - m_im[mirror];
+        float const energy = 0.25f * (re * re + im * im);
+        float const weight = m_bin_weight[k];
+        m_energy[m_bin_band[k]] += energy * (1 - weight);
+        m_energy[m_bin_band[k] + 1] += energy * weight;
+    }
+
+    // A sine of amplitude A leaves A^2 n^2 / 8 in its band after the window,
+    // and rectifies to a mean of 2A / pi like the envelope followers see. The
+    // extra 50 matches VocoderRT's output level.
+    float const amplitude_scale = static_cast<float>(std::sqrt(8.0) / n);
+    float const gain_scale = static_cast<float>(50 * 2 / M_PI);
+    for (std::size_t band = 0; band < m_envelope.size(); band++) {
+        float const target = std::sqrt(m_energy[band]) * amplitude_scale;
+        float const decay = m_envelope_decay[band];
+        m_envelope[band] = target + decay * (m_envelope[band] - target);
+    }
+    m_envelope.front() = 0;
+    m_envelope.back() = 0;
+
+    // Bin k of the carrier is (Z[k] - conj(Z[n - k])) / 2i. Scaling both
+    // halves by the same gain keeps the result real.
+    for (std::size_t k = 0; k <= nyquist; k++) {
+        std::size_t const mirror = (n - k) % n;
+        float const re = 0.5f * (m_im[k] + m_im[mirror]);
+        float const im = 0.5f * (m_re[mirror] - m_re[k]);
+        std::size_t const band = m_bin_band[k];
+        float const weight = m_bin_weight[k];
+        float const gain =
+            gain_scale * (m_envelope[band] +
+                          weight * (m_envelope[band + 1] - m_envelope[band]));
+        m_re[k] = re * gain;
+        m_im[k] = im * gain;
+        m_re[mirror] = m_re[k];
+        m_im[mirror] = -m_im[k];
+    }
+    m_fft.inverse(m_re, m_im);
+
+    // The first hop of the output has been taken, so move up and add the new
+    // frame on.
+    std::copy(m_output.begin() + m_hop_size, m_output.end(), m_output.begin());
+    std::fill(m_output.end() - m_hop_size, m_output.end(), 0.0f);
+    kernels.mul(m_re.data(), m_synthesis_window.data(), n);
+    kernels.add(m_output.data(), m_re.data(), n);
+
+    std::copy(m_signal.begin() + m_hop_size, m_signal.end(), m_signal.begin());
+    std::copy(m_carrier.begin() + m_hop_size, m_carrier.end(),
+              m_carrier.begin());
+}
+
+}  // namespace pwv
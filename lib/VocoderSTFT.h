@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FFT.h"
+#include "Vocoder.h"
+
+#include <vector>
+
+namespace pwv {
+
+// Realtime version that works on overlapping FFT frames instead of running a
+// filter per band. Each frame measures the modulator's energy around every
+// band centre, smooths it over time like the envelope followers, and scales
+// the carrier's bins by it. Most of the work is the transforms, so the cost
+// hardly depends on the number of bands.
+//
+// The output lags by a whole frame. A shorter hop follows the envelopes more
+// closely and costs more per sample.
+class VocoderSTFT final : public IVocoderRT {
+  public:
+    // |frame_size| must be a power of two, and |hop_size| must divide it and
+    // be at most half of it.
+    VocoderSTFT(double distance, int num_bands, double sampling_rate,
+                std::size_t frame_size = 1024, std::size_t hop_size = 256);
+    ~VocoderSTFT() override;
+
+    std::size_t block_size() const override { return 1; }
+    std::size_t latency() const override { return m_frame_size; }
+
+    std::size_t frame_size() const { return m_frame_size; }
+    std::size_t hop_size() const { return m_hop_size; }
+
+    void process(float const* signal, float const* carrier, std::size_t count,
+                 float* output) override;
+
+  private:
+    VocoderSTFT(VocoderSTFT const&) = delete;
+    VocoderSTFT& operator=(VocoderSTFT const&) = delete;
+
+  private:
+    void process_frame();
+
+  private:
+    std::size_t const m_frame_size;
+    std::size_t const m_hop_size;
+    FFT m_fft;
+
+    // Square root of a Hann window, applied both ways. The synthesis one also
+    // undoes the overlap and the unscaled transforms.
+    std::vector<float> m_analysis_window;
+    std::vector<float> m_synthesis_window;
+
+    // The last frame of input, and the output still being added to. The
+    // first m_fill samples of the hop have been taken so far.
+    std::vector<float> m_signal;
+    std::vector<float> m_carrier;
+    std::vector<float> m_output;
+    std::size_t m_fill = 0;
+
+    // Spectrum of the current frame.
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+
+    // Each bin from 0 to Nyquist lies between bands m_bin_band and the one
+    // after, m_bin_weight of the way to the latter in log frequency. The
+    // first and last bands are silent ones either side of the real ones.
+    std::vector<std::size_t> m_bin_band;
+    std::vector<float> m_bin_weight;
+
+    // Per band.
+    std::vector<float> m_energy;
+    std::vector<float> m_envelope;
+    std::vector<float> m_envelope_decay;
+};
+
+}  // namespace pwv
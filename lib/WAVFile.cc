@@ -1,23 +1,16 @@
 #include "WAVFile.h"
 
+#include "Kernels.h"
+
 #include <algorithm>
-#include <cstdio>
 #include <cstring>
-#include <memory>
+#include <limits>
+#include <type_traits>
 
 namespace pwv {
 
 namespace {
 
-struct FileCloser {
-    void operator()(FILE *f) const {
-        if (f != nullptr) {
-            fclose(f);
-        }
-    }
-};
-using File = std::unique_ptr<FILE, FileCloser>;
-
 struct ChunkHeader {
     char chunk_id[4];
     uint32_t chunk_size;
@@ -34,23 +27,37 @@ struct FmtChunk {
 };
 static_assert(sizeof(FmtChunk) == 16);
 
+using File = std::unique_ptr<FILE, int (*)(FILE *)>;
+
 template <typename T>
 bool read(File &file, T *data, std::size_t bytes = sizeof(T)) {
     return fread(data, 1, bytes, file.get()) == bytes;
 }
 
 template <typename T>
-void write(File &file, T *data, std::size_t bytes = sizeof(T)) {
-    fwrite(data, 1, bytes, file.get());
+bool write(File &file, T *data, std::size_t bytes = sizeof(T)) {
+    return fwrite(data, 1, bytes, file.get()) == bytes;
 }
 
 using SampleType = int16_t;
 
+// Most samples the 32 bit sizes in the headers can count, with the RIFF size
+// covering the rest of the headers as well.
+constexpr std::size_t k_max_samples =
+    (std::numeric_limits<uint32_t>::max() - 4 - 8 - sizeof(FmtChunk) - 8) /
+    sizeof(SampleType);
+
 }  // namespace
 
-std::expected<WAVData, std::string> load_wav(std::filesystem::path path) {
+WAVReader::WAVReader() {}
+WAVReader::~WAVReader() {}
+WAVReader::WAVReader(WAVReader &&) = default;
+WAVReader &WAVReader::operator=(WAVReader &&) = default;
+
+std::expected<WAVReader, std::string> WAVReader::open(
+    std::filesystem::path path) {
     // ifstream would be useful, if you could tell how much you've read...
-    File input(fopen(path.string().c_str(), "rb"));
+    File input(fopen(path.string().c_str(), "rb"), fclose);
     if (!input) {
         return std::unexpected("Failed to open file");
     }
@@ -77,8 +84,8 @@ std::expected<WAVData, std::string> load_wav(std::filesystem::path path) {
     }
 
     // Pull out info about the file.
-    WAVData wav_file;
-    wav_file.sampling_rate = fmt_chunk.sampling_rate;
+    WAVReader reader;
+    reader.m_sampling_rate = fmt_chunk.sampling_rate;
     if (fmt_chunk.format != 1 || fmt_chunk.channels != 1 ||
         fmt_chunk.bits_per_sample != 16) {
         return std::unexpected("Unhandled audio format");
@@ -89,42 +96,90 @@ std::expected<WAVData, std::string> load_wav(std::filesystem::path path) {
         header.chunk_size % sizeof(SampleType)) {
         return std::unexpected("Bad DATA header");
     }
+    reader.m_num_samples = header.chunk_size / sizeof(SampleType);
+    reader.m_remaining = reader.m_num_samples;
+    reader.m_file = std::move(input);
+    return reader;
+}
 
-    // Read the data in.
-    std::size_t const num_samples = header.chunk_size / sizeof(SampleType);
-    std::vector<SampleType> raw_data(num_samples);
-    if (!read(input, raw_data.data(), raw_data.size() * sizeof(SampleType))) {
+std::expected<std::size_t, std::string> WAVReader::read_samples(
+    std::span<float> samples) {
+    std::size_t const count = std::min(samples.size(), m_remaining);
+
+    static_assert(std::is_same_v<SampleType, int16_t>);
+    m_raw.resize(count);
+    if (!read(m_file, m_raw.data(), count * sizeof(SampleType))) {
         return std::unexpected("End of file");
     }
+    kernels().int16_to_float(m_raw.data(), samples.data(), count);
+    m_remaining -= count;
+    return count;
+}
 
-    // Convert to float.
-    wav_file.samples.resize(num_samples);
-    std::transform(raw_data.begin(), raw_data.end(), wav_file.samples.begin(),
-                   [](SampleType sample) -> float {
-                       return -static_cast<float>(sample) /
-                              std::numeric_limits<SampleType>::min();
-                   });
+std::expected<std::size_t, std::string> WAVReader::read_samples(
+    std::span<int16_t> samples) {
+    std::size_t const count = std::min(samples.size(), m_remaining);
 
-    return wav_file;
+    static_assert(std::is_same_v<SampleType, int16_t>);
+    if (!read(m_file, samples.data(), count * sizeof(SampleType))) {
+        return std::unexpected("End of file");
+    }
+    m_remaining -= count;
+    return count;
 }
 
-bool save_wav(WAVData const &data, std::filesystem::path path) {
+WAVWriter::WAVWriter() {}
+WAVWriter::~WAVWriter() { finish(); }
+WAVWriter::WAVWriter(WAVWriter &&) = default;
+WAVWriter &WAVWriter::operator=(WAVWriter &&) = default;
+
+std::expected<WAVWriter, std::string> WAVWriter::create(
+    std::filesystem::path path, std::size_t sampling_rate) {
+    // Open the output file.
+    File output(fopen(path.string().c_str(), "wb"), fclose);
+    if (!output) {
+        return std::unexpected("Failed to open file");
+    }
+
+    // The sizes are filled in by finish().
+    WAVWriter writer;
+    writer.m_sampling_rate = sampling_rate;
+    writer.m_file = std::move(output);
+    if (!writer.write_headers()) {
+        return std::unexpected("Failed to write headers");
+    }
+    return writer;
+}
+
+bool WAVWriter::write_samples(std::span<float const> samples) {
+    if (samples.size() > k_max_samples - m_num_samples) {
+        return false;
+    }
+
     // Convert to shorts.
-    std::vector<SampleType> raw_data(data.samples.size());
-    std::transform(
-        data.samples.begin(), data.samples.end(), raw_data.begin(),
-        [](float sample) -> SampleType {
-            return std::clamp(
-                -sample * std::numeric_limits<SampleType>::min(),
-                static_cast<float>(std::numeric_limits<SampleType>::min()),
-                static_cast<float>(std::numeric_limits<SampleType>::max()));
-        });
+    static_assert(std::is_same_v<SampleType, int16_t>);
+    m_raw.resize(samples.size());
+    kernels().float_to_int16(samples.data(), m_raw.data(), samples.size());
+
+    m_num_samples += samples.size();
+    return write(m_file, m_raw.data(), m_raw.size() * sizeof(SampleType));
+}
 
+bool WAVWriter::finish() {
+    if (!m_file) {
+        return false;
+    }
+    bool const ok = fseek(m_file.get(), 0, SEEK_SET) == 0 && write_headers();
+    m_file.reset();
+    return ok;
+}
+
+bool WAVWriter::write_headers() {
     // Build the FMT chunk.
     FmtChunk fmt_chunk;
     fmt_chunk.format = 1;
     fmt_chunk.channels = 1;
-    fmt_chunk.sampling_rate = data.sampling_rate;
+    fmt_chunk.sampling_rate = m_sampling_rate;
     fmt_chunk.bits_per_sample = sizeof(SampleType) * 8;
     fmt_chunk.block_align = fmt_chunk.channels * fmt_chunk.bits_per_sample / 8;
     fmt_chunk.byte_rate = fmt_chunk.sampling_rate * fmt_chunk.block_align;
@@ -135,28 +190,52 @@ bool save_wav(WAVData const &data, std::filesystem::path path) {
     fmt_header.chunk_size = sizeof(fmt_chunk);
     ChunkHeader data_header;
     std::memcpy(data_header.chunk_id, "data", 4);
-    data_header.chunk_size = raw_data.size() * sizeof(SampleType);
+    data_header.chunk_size = m_num_samples * sizeof(SampleType);
     ChunkHeader riff_header;
     std::memcpy(riff_header.chunk_id, "RIFF", 4);
     riff_header.chunk_size = 4 +                          // WAVE
                              8 + fmt_header.chunk_size +  // FMT chunk
                              8 + data_header.chunk_size;  // DATA chunk
 
-    // Open the output file.
-    File output(fopen(path.string().c_str(), "wb"));
-    if (!output) {
-        return false;
+    return write(m_file, &riff_header) && write(m_file, "WAVE", 4) &&
+           write(m_file, &fmt_header) && write(m_file, &fmt_chunk) &&
+           write(m_file, &data_header);
+}
+
+std::expected<WAVData, std::string> load_wav(std::filesystem::path path) {
+    auto reader = WAVReader::open(path);
+    if (!reader) {
+        return std::unexpected(reader.error());
+    }
+
+    WAVData wav_file;
+    wav_file.sampling_rate = reader->sampling_rate();
+    wav_file.samples.resize(reader->num_samples());
+    if (auto read = reader->read_samples(wav_file.samples); !read) {
+        return std::unexpected(read.error());
+    }
+    return wav_file;
+}
+
+std::expected<WAVDataInt16, std::string> load_wav_int16(
+    std::filesystem::path path) {
+    auto reader = WAVReader::open(path);
+    if (!reader) {
+        return std::unexpected(reader.error());
     }
 
-    // Dump it all out.
-    write(output, &riff_header);
-    write(output, "WAVE", 4);
-    write(output, &fmt_header);
-    write(output, &fmt_chunk);
-    write(output, &data_header);
-    write(output, raw_data.data(), raw_data.size() * sizeof(SampleType));
+    WAVDataInt16 wav_file;
+    wav_file.sampling_rate = reader->sampling_rate();
+    wav_file.samples.resize(reader->num_samples());
+    if (auto read = reader->read_samples(wav_file.samples); !read) {
+        return std::unexpected(read.error());
+    }
+    return wav_file;
+}
 
-    return true;
+bool save_wav(WAVData const &data, std::filesystem::path path) {
+    auto writer = WAVWriter::create(path, data.sampling_rate);
+    return writer && writer->write_samples(data.samples) && writer->finish();
 }
 
 }  // namespace pwv
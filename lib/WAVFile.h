@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <expected>
 #include <filesystem>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -12,7 +16,77 @@ struct WAVData {
     std::vector<float> samples;
 };
 
+// As WAVData, with the samples as they are in the file.
+struct WAVDataInt16 {
+    std::size_t sampling_rate;
+    std::vector<int16_t> samples;
+};
+
 std::expected<WAVData, std::string> load_wav(std::filesystem::path path);
+std::expected<WAVDataInt16, std::string> load_wav_int16(
+    std::filesystem::path path);
 bool save_wav(WAVData const& data, std::filesystem::path path);
 
+// Reads a file a piece at a time, for ones too big to load.
+class WAVReader {
+  public:
+    ~WAVReader();
+    WAVReader(WAVReader&&);
+    WAVReader& operator=(WAVReader&&);
+
+    static std::expected<WAVReader, std::string> open(
+        std::filesystem::path path);
+
+    std::size_t sampling_rate() const { return m_sampling_rate; }
+    std::size_t num_samples() const { return m_num_samples; }
+
+    // Fills as much of |samples| as is left and returns how much that was.
+    std::expected<std::size_t, std::string> read_samples(
+        std::span<float> samples);
+    std::expected<std::size_t, std::string> read_samples(
+        std::span<int16_t> samples);
+
+  private:
+    WAVReader();
+    WAVReader(WAVReader const&) = delete;
+    WAVReader& operator=(WAVReader const&) = delete;
+
+  private:
+    std::unique_ptr<FILE, int (*)(FILE*)> m_file{nullptr, fclose};
+    std::size_t m_sampling_rate = 0;
+    std::size_t m_num_samples = 0;
+    std::size_t m_remaining = 0;
+    std::vector<int16_t> m_raw;
+};
+
+// Writes a file a piece at a time. The sizes in the headers are filled in by
+// finish(), or on destruction. They're 32 bits, so writes that would take
+// the file past 4 GB fail and write nothing.
+class WAVWriter {
+  public:
+    ~WAVWriter();
+    WAVWriter(WAVWriter&&);
+    WAVWriter& operator=(WAVWriter&&);
+
+    static std::expected<WAVWriter, std::string> create(
+        std::filesystem::path path, std::size_t sampling_rate);
+
+    bool write_samples(std::span<float const> samples);
+    bool finish();
+
+  private:
+    WAVWriter();
+    WAVWriter(WAVWriter const&) = delete;
+    WAVWriter& operator=(WAVWriter const&) = delete;
+
+  private:
+    bool write_headers();
+
+  private:
+    std::unique_ptr<FILE, int (*)(FILE*)> m_file{nullptr, fclose};
+    std::size_t m_sampling_rate = 0;
+    std::size_t m_num_samples = 0;
+    std::vector<int16_t> m_raw;
+};
+
 }  // namespace pwv
@@ -22,8 +22,8 @@ struct ModuleWrapper::ModuleHolder {
     }
 };
 
-ModuleWrapper::ModuleWrapper(double sampling_rate)
-    : m_sampling_rate(sampling_rate) {}
+ModuleWrapper::ModuleWrapper(double sampling_rate, ModuleEngine engine)
+    : m_sampling_rate(sampling_rate), m_engine(engine) {}
 
 ModuleWrapper::~ModuleWrapper() {
     m_module_queue.reset();
@@ -129,7 +129,7 @@ bool ModuleWrapper::reload_module() {
     }
 
     // Create the module.
-    module->module.reset(maker->create_module(m_sampling_rate));
+    module->module.reset(maker->create_module(m_sampling_rate, m_engine));
     if (!module->module) {
         return false;
     }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "internal/IModule.h"
+
 #include <atomic>
 #include <cstdint>
 #include <memory>
@@ -11,7 +13,7 @@ class ModuleWrapper {
     struct ModuleHolder;
 
   public:
-    explicit ModuleWrapper(double sampling_rate);
+    ModuleWrapper(double sampling_rate, ModuleEngine engine);
     ~ModuleWrapper();
 
     void set_input_buffer(float* input) { m_input = input; }
@@ -35,6 +37,7 @@ class ModuleWrapper {
 
   private:
     double const m_sampling_rate;
+    ModuleEngine const m_engine;
     float* m_input = nullptr;
     float* m_output = nullptr;
     float* m_port_addr = nullptr;
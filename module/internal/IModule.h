@@ -5,7 +5,11 @@
 
 namespace pwv {
 
-static constexpr std::size_t k_module_version = 1;
+static constexpr std::size_t k_module_version = 2;
+
+// Which vocoder the module builds. LPC is much cheaper but only keeps a
+// coarse envelope, which is fine for speech.
+enum class ModuleEngine : uint32_t { Bands, LPC };
 
 struct IModule {
     virtual void process(float const *input, float *output,
@@ -15,7 +19,7 @@ struct IModule {
 
 struct ModuleMaker {
     std::size_t version;
-    IModule *(*create_module)(double sampling_rate);
+    IModule *(*create_module)(double sampling_rate, ModuleEngine engine);
 };
 static_assert(offsetof(ModuleMaker, version) == 0);
 
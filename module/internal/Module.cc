@@ -1,24 +1,48 @@
 #include "Module.h"
 
+#include <VocoderLPC.h>
 #include <memory>
+#include <utility>
 
 namespace pwv {
 
-Module::Module(double sampling_rate) : m_vocoder(20, 40, sampling_rate) {}
+namespace {
+
+// Threads to split the bands across, including the audio thread. Only worth
+// raising for many bands at long quanta, with cores to spare. The module is
+// built off the audio thread, so the helpers keep their own scheduling.
+constexpr std::size_t k_num_threads = 1;
+
+}  // namespace
+
+Module::Module(double sampling_rate, ModuleEngine engine) {
+    switch (engine) {
+        case ModuleEngine::Bands: {
+            auto vocoder = std::make_unique<VocoderRT>(20, 40, sampling_rate);
+            vocoder->set_num_threads(k_num_threads);
+            m_vocoder = std::move(vocoder);
+            break;
+        }
+        case ModuleEngine::LPC:
+            m_vocoder = std::make_unique<VocoderLPC>(
+                VocoderLPC::speech_order(sampling_rate));
+            break;
+    }
+}
 
 Module::~Module() {}
 
 void Module::process(float const *input, float *output,
                      std::size_t sample_count) {
     // Run the filter.
-    m_vocoder.process(input, input, sample_count, output);
+    m_vocoder->process(input, input, sample_count, output);
 }
 
 }  // namespace pwv
 
 extern "C" pwv::ModuleMaker const pwv_module_maker{
     pwv::k_module_version,
-    [](double sampling_rate) -> pwv::IModule * {
-        return std::make_unique<pwv::Module>(sampling_rate).release();
+    [](double sampling_rate, pwv::ModuleEngine engine) -> pwv::IModule * {
+        return std::make_unique<pwv::Module>(sampling_rate, engine).release();
     },
 };
@@ -3,12 +3,13 @@
 #include "IModule.h"
 
 #include <Vocoder.h>
+#include <memory>
 
 namespace pwv {
 
 class Module : public IModule {
   public:
-    explicit Module(double sampling_rate);
+    Module(double sampling_rate, ModuleEngine engine);
     ~Module() override;
 
     void process(float const *input, float *output,
@@ -19,7 +20,7 @@ class Module : public IModule {
     Module &operator=(Module const &) = delete;
 
   private:
-    VocoderRT m_vocoder;
+    std::unique_ptr<IVocoderRT> m_vocoder;
 };
 
 }  // namespace pwv
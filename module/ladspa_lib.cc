@@ -43,7 +43,9 @@ LADSPA_Handle ladspa_instantiate(LADSPA_Descriptor const* descriptor,
         return nullptr;
     }
 
-    auto module = std::make_unique<pwv::ModuleWrapper>(sample_rate);
+    auto const engine =
+        *static_cast<pwv::ModuleEngine const*>(descriptor->ImplementationData);
+    auto module = std::make_unique<pwv::ModuleWrapper>(sample_rate, engine);
     return module.release();
 }
 
@@ -82,53 +84,69 @@ void ladspa_cleanup(LADSPA_Handle instance) {
     std::unique_ptr<pwv::ModuleWrapper> module(to_module(instance));
 }
 
-LADSPA_Descriptor const g_descriptor{
-    .UniqueID = 0x1234 /* TODO */,
+// One plugin per engine, each passing its engine through ImplementationData.
+pwv::ModuleEngine g_engines[] = {pwv::ModuleEngine::Bands,
+                                 pwv::ModuleEngine::LPC};
 
-    .Label = "vocoder_test_filter",
+constexpr LADSPA_Descriptor make_descriptor(unsigned long unique_id,
+                                            char const* label,
+                                            char const* name,
+                                            pwv::ModuleEngine* engine) {
+    return {
+        .UniqueID = unique_id,
 
-    .Properties =
-        LADSPA_PROPERTY_INPLACE_BROKEN /* | LADSPA_PROPERTY_HARD_RT_CAPABLE */,
+        .Label = label,
 
-    .Name = "Vocoder thing",
+        .Properties = LADSPA_PROPERTY_INPLACE_BROKEN
+        /* | LADSPA_PROPERTY_HARD_RT_CAPABLE */,
 
-    .Maker = "me",
+        .Name = name,
 
-    .Copyright = "None",
+        .Maker = "me",
 
-    .PortCount = k_num_ports,
+        .Copyright = "None",
 
-    .PortDescriptors = g_ports,
+        .PortCount = k_num_ports,
 
-    .PortNames = g_port_names,
+        .PortDescriptors = g_ports,
 
-    .PortRangeHints = g_port_hints,
+        .PortNames = g_port_names,
 
-    .ImplementationData = nullptr,
+        .PortRangeHints = g_port_hints,
 
-    .instantiate = ladspa_instantiate,
+        .ImplementationData = engine,
 
-    .connect_port = ladspa_connect_port,
+        .instantiate = ladspa_instantiate,
 
-    .activate = ladspa_activate,
+        .connect_port = ladspa_connect_port,
 
-    .run = ladspa_run,
+        .activate = ladspa_activate,
 
-    .run_adding = nullptr,
+        .run = ladspa_run,
 
-    .set_run_adding_gain = nullptr,
+        .run_adding = nullptr,
 
-    .deactivate = ladspa_deactivate,
+        .set_run_adding_gain = nullptr,
 
-    .cleanup = ladspa_cleanup,
+        .deactivate = ladspa_deactivate,
+
+        .cleanup = ladspa_cleanup,
+    };
+}
+
+LADSPA_Descriptor const g_descriptors[] = {
+    make_descriptor(0x1234 /* TODO */, "vocoder_test_filter", "Vocoder thing",
+                    &g_engines[0]),
+    make_descriptor(0x1235 /* TODO */, "vocoder_lpc_test_filter",
+                    "Vocoder thing (LPC)", &g_engines[1]),
 };
 
 }  // namespace
 
 __attribute__((visibility("default"))) LADSPA_Descriptor const*
 ladspa_descriptor(unsigned long index) {
-    if (index == 0) {
-        return &g_descriptor;
+    if (index < std::size(g_descriptors)) {
+        return &g_descriptors[index];
     }
     return nullptr;
 }
@@ -9,6 +9,11 @@ constexpr uint32_t k_input_port = 0;   /* lv2:AudioPort */
 constexpr uint32_t k_output_port = 1;  /* lv2:AudioPort */
 constexpr uint32_t k_control_port = 2; /* TODO */
 
+// One plugin per engine, in the order of g_descriptors.
+pwv::ModuleEngine const g_engines[] = {pwv::ModuleEngine::Bands,
+                                       pwv::ModuleEngine::LPC};
+extern LV2_Descriptor const g_descriptors[];
+
 auto to_module(LV2_Handle handle) {
     return static_cast<pwv::ModuleWrapper*>(handle);
 }
@@ -24,7 +29,8 @@ LV2_Handle lv2_instantiate(const struct LV2_Descriptor* descriptor,
     (void)bundle_path;
     (void)features;
 
-    auto module = std::make_unique<pwv::ModuleWrapper>(sample_rate);
+    auto const engine = g_engines[descriptor - g_descriptors];
+    auto module = std::make_unique<pwv::ModuleWrapper>(sample_rate, engine);
     return module.release();
 }
 
@@ -68,17 +74,24 @@ void const* lv2_extension_data(char const* uri) {
     return nullptr;
 }
 
-LV2_Descriptor const g_descriptor{
-    "TODO",  lv2_instantiate, lv2_connect_port, lv2_activate,
-    lv2_run, lv2_deactivate,  lv2_cleanup,      lv2_extension_data,
+LV2_Descriptor const g_descriptors[] = {
+    {
+        "TODO",  lv2_instantiate, lv2_connect_port, lv2_activate,
+        lv2_run, lv2_deactivate,  lv2_cleanup,      lv2_extension_data,
+    },
+    {
+        "TODO#lpc", lv2_instantiate, lv2_connect_port, lv2_activate,
+        lv2_run,    lv2_deactivate,  lv2_cleanup,      lv2_extension_data,
+    },
 };
+static_assert(std::size(g_descriptors) == std::size(g_engines));
 
 }  // namespace
 
 __attribute__((visibility("default"))) LV2_Descriptor const* lv2_descriptor(
     uint32_t index) {
-    if (index == 0) {
-        return &g_descriptor;
+    if (index < std::size(g_descriptors)) {
+        return &g_descriptors[index];
     }
     return nullptr;
 }
@@ -5,13 +5,20 @@
 /* SPDX-FileCopyrightText: Copyright C 2019 Wim Taymans */
 /* SPDX-License-Identifier: MIT */
 
-#include <Vocoder.h>
+#include <CarrierCache.h>
+#include <Kernels.h>
+#include <MultichannelVocoderRT.h>
 #include <WAVFile.h>
+#include <algorithm>
+#include <array>
 #include <cstdio>
+#include <filesystem>
 #include <memory>
+#include <optional>
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
 #include <spa/param/latency-utils.h>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -25,30 +32,24 @@ pw_stream_flags operator|(pw_stream_flags lhs, pw_stream_flags rhs) {
     return static_cast<pw_stream_flags>(static_cast<U>(lhs) |
                                         static_cast<U>(rhs));
 }
+#endif
 
-// TODO: write tests for these
-void deinterleave(float const *input, std::size_t num_channels,
-                  std::size_t num_frames, float *output) {
-    // abcabc -> aabbcc
-    for (std::size_t channel = 0; channel < num_channels; channel++) {
-        for (std::size_t frame = 0; frame < num_frames; frame++) {
-            output[channel * num_frames + frame] =
-                input[frame * num_channels + channel];
-        }
-    }
-}
+// TODO: how do we get the hz of the thing(s) we're plugging into?
+constexpr double k_distance = 20;
+constexpr int k_num_bands = 60;
+constexpr double k_sampling_rate = 44100;
 
-void interleave(float const *input, std::size_t num_channels,
-                std::size_t num_frames, float *output) {
-    // aabbcc -> abcabc
-    for (std::size_t frame = 0; frame < num_frames; frame++) {
-        for (std::size_t channel = 0; channel < num_channels; channel++) {
-            output[frame * num_channels + channel] =
-                input[channel * num_frames + frame];
-        }
-    }
-}
-#endif
+constexpr char k_carrier_path[] = "data/input_hbfs_mono.wav";
+// Built by the cmdline's cache mode. The carrier is filtered as it plays
+// without one.
+constexpr char k_carrier_cache_path[] = "data/input_hbfs_mono.bands";
+
+// DSP ports are always mono, so there's a pair of them per channel, and the
+// vocoder gets the channels interleaved through scratch buffers of up to
+// k_max_frames frames at a time.
+constexpr char const *k_channel_names[] = {"FL", "FR"};
+constexpr std::size_t k_num_channels = std::size(k_channel_names);
+constexpr std::size_t k_max_frames = 1024;
 
 struct UserData;
 struct Port {
@@ -57,15 +58,16 @@ struct Port {
 struct UserData {
     pw_main_loop *loop;
     pw_filter *filter;
-    spa_audio_info format;
 
-    Port *in_port;
-    Port *out_port;
+    std::array<Port *, k_num_channels> in_ports;
+    std::array<Port *, k_num_channels> out_ports;
 
-    std::vector<std::unique_ptr<pwv::VocoderRT>> filters;
-    // std::vector<float> interleave_buffer;
+    std::unique_ptr<pwv::MultichannelVocoderRT> vocoder;
+    std::vector<float> interleaved_input;
+    std::vector<float> interleaved_output;
 
     std::vector<float> carrier_wave;
+    std::optional<pwv::CarrierCache> carrier_cache;
     std::size_t offset = 0;
 };
 
@@ -74,51 +76,71 @@ static void on_process(void *userdata, struct spa_io_position *position) {
 
     uint32_t const num_frames = position->clock.duration;
 
-    float *input = static_cast<float *>(
-        pw_filter_get_dsp_buffer(data->in_port, num_frames));
-    float *output = static_cast<float *>(
-        pw_filter_get_dsp_buffer(data->out_port, num_frames));
+    std::array<float const *, k_num_channels> inputs;
+    std::array<float *, k_num_channels> outputs;
+    for (std::size_t channel = 0; channel < k_num_channels; channel++) {
+        inputs[channel] = static_cast<float const *>(
+            pw_filter_get_dsp_buffer(data->in_ports[channel], num_frames));
+        outputs[channel] = static_cast<float *>(
+            pw_filter_get_dsp_buffer(data->out_ports[channel], num_frames));
+    }
 
-    if (input == nullptr || output == nullptr) {
+    // Nothing to run it with, so be quiet rather than leave the outputs as
+    // they were.
+    if (data->vocoder == nullptr || data->carrier_wave.empty()) {
+        for (float *output : outputs) {
+            if (output != nullptr) {
+                std::fill(output, output + num_frames, 0.0f);
+            }
+        }
         return;
     }
 
-    size_t const num_channels = 1;
+    for (std::size_t start = 0; start < num_frames; start += k_max_frames) {
+        std::size_t const count =
+            std::min<std::size_t>(num_frames - start, k_max_frames);
 
-    if (num_channels != data->filters.size()) {
-        printf("Bad number of channels\n");
-        return;
-    }
-    if (num_frames % pwv::VocoderRT::k_block_size) {
-        printf("Can't handle chunk size\n");
-        return;
-    }
+        // Handle eof.
+        if (data->offset + count > data->carrier_wave.size()) {
+            data->offset = 0;
+        }
+        std::size_t const offset = data->offset;
+
+        // Update carrier wave offset
+        data->offset += count;
+
+        // Interleave the inputs, with silence for any unconnected.
+        float *const signal = data->interleaved_input.data();
+        for (std::size_t channel = 0; channel < k_num_channels; channel++) {
+            float const *const input = inputs[channel];
+            for (std::size_t i = 0; i < count; i++) {
+                signal[i * k_num_channels + channel] =
+                    input != nullptr ? input[start + i] : 0.0f;
+            }
+        }
 
-    // Data is interleaved.
-    // data->interleave_buffer.resize(num_channels * num_frames);
-    // deinterleave(input, num_channels, num_frames,
-    //             data->interleave_buffer.data());
+        // Apply the filter to every channel at once.
+        float *const output = data->interleaved_output.data();
+        if (data->carrier_cache) {
+            pwv::CarrierCache const &cache = *data->carrier_cache;
+            data->vocoder->process_analyzed(
+                signal, cache.bands() + offset * cache.stride(), count,
+                output);
+        } else {
+            data->vocoder->process(signal,
+                                   data->carrier_wave.data() + offset, count,
+                                   output);
+        }
 
-    // Handle eof.
-    if (data->offset + num_frames > data->carrier_wave.size()) {
-        data->offset = 0;
-    }
-    float const *const carrier = data->carrier_wave.data() + data->offset;
-
-    // Update carrier wave offset
-    data->offset += num_frames;
-
-    // Apply the filter to each channel
-    // float *const signal = data->interleave_buffer.data();
-    for (std::size_t channel = 0; channel < num_channels; channel++) {
-        float const *const channel_signal = input + channel * num_frames;
-        float *const channel_output = output + channel * num_frames;
-        data->filters[channel]->process(channel_signal, carrier, num_frames,
-                                        channel_output);
+        for (std::size_t channel = 0; channel < k_num_channels; channel++) {
+            if (float *const channel_output = outputs[channel]) {
+                for (std::size_t i = 0; i < count; i++) {
+                    channel_output[start + i] =
+                        output[i * k_num_channels + channel];
+                }
+            }
+        }
     }
-
-    // interleave(data->interleave_buffer.data(), num_channels, num_frames,
-    //            output);
 }
 
 const struct pw_filter_events filter_events = {
@@ -146,7 +168,7 @@ void run_processor(pw_main_loop *loop) {
     data.loop = loop;
 
     // Load the carrier wave.
-    auto carrier = pwv::load_wav("data/input_hbfs_mono.wav");
+    auto carrier = pwv::load_wav(k_carrier_path);
     if (!carrier) {
         printf("Failed to load carrier: %s\n", carrier.error().c_str());
         return;
@@ -155,12 +177,27 @@ void run_processor(pw_main_loop *loop) {
     data.carrier_wave = std::move(carrier->samples);
     data.offset = 0;
 
-    // TODO: how do we get the hz of the thing(s) we're plugging into?
-    data.filters.resize(1);
-    for (auto &filter : data.filters) {
-        filter = std::make_unique<pwv::VocoderRT>(20, 60, 44100);
+    // Read its bands from the cache if there's one for it.
+    if (std::filesystem::exists(k_carrier_cache_path)) {
+        auto cache = pwv::CarrierCache::open(
+            k_carrier_cache_path,
+            pwv::CarrierCache::key(data.carrier_wave, k_num_bands,
+                                   k_sampling_rate));
+        if (cache) {
+            printf("Using carrier cache: %s\n", k_carrier_cache_path);
+            data.carrier_cache = std::move(*cache);
+        } else {
+            printf("Ignoring carrier cache: %s - %s\n", k_carrier_cache_path,
+                   cache.error().c_str());
+        }
     }
 
+    static_assert(k_num_channels <= pwv::k_max_channels);
+    data.vocoder = std::make_unique<pwv::MultichannelVocoderRT>(
+        k_distance, k_num_bands, k_sampling_rate, k_num_channels);
+    data.interleaved_input.resize(k_max_frames * k_num_channels);
+    data.interleaved_output.resize(k_max_frames * k_num_channels);
+
     pw_loop_add_signal(pw_main_loop_get_loop(data.loop), SIGINT, do_quit,
                        &data);
     pw_loop_add_signal(pw_main_loop_get_loop(data.loop), SIGTERM, do_quit,
@@ -172,21 +209,26 @@ void run_processor(pw_main_loop *loop) {
                           "Filter", PW_KEY_MEDIA_ROLE, "DSP", NULL),
         &filter_events, &data);
 
-    /* make an audio DSP input port */
-    data.in_port = static_cast<Port *>(pw_filter_add_port(
-        data.filter, PW_DIRECTION_INPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS,
-        sizeof(Port),
-        pw_properties_new(PW_KEY_FORMAT_DSP, "32 bit float mono audio",
-                          PW_KEY_PORT_NAME, "input", NULL),
-        NULL, 0));
-
-    /* make an audio DSP output port */
-    data.out_port = static_cast<Port *>(pw_filter_add_port(
-        data.filter, PW_DIRECTION_OUTPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS,
-        sizeof(Port),
-        pw_properties_new(PW_KEY_FORMAT_DSP, "32 bit float mono audio",
-                          PW_KEY_PORT_NAME, "output", NULL),
-        NULL, 0));
+    /* make an audio DSP input and output port per channel */
+    for (std::size_t channel = 0; channel < k_num_channels; channel++) {
+        char const *const name = k_channel_names[channel];
+        std::string const input_name = std::string("input_") + name;
+        std::string const output_name = std::string("output_") + name;
+        data.in_ports[channel] = static_cast<Port *>(pw_filter_add_port(
+            data.filter, PW_DIRECTION_INPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS,
+            sizeof(Port),
+            pw_properties_new(PW_KEY_FORMAT_DSP, "32 bit float mono audio",
+                              PW_KEY_PORT_NAME, input_name.c_str(),
+                              PW_KEY_AUDIO_CHANNEL, name, NULL),
+            NULL, 0));
+        data.out_ports[channel] = static_cast<Port *>(pw_filter_add_port(
+            data.filter, PW_DIRECTION_OUTPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS,
+            sizeof(Port),
+            pw_properties_new(PW_KEY_FORMAT_DSP, "32 bit float mono audio",
+                              PW_KEY_PORT_NAME, output_name.c_str(),
+                              PW_KEY_AUDIO_CHANNEL, name, NULL),
+            NULL, 0));
+    }
 
     uint8_t buffer[1024];
     spa_pod_builder builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
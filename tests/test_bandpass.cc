@@ -1,8 +1,11 @@
 #include "tests.h"
 
 #include <BandPass.h>
+#include <PreciseFilter.h>
 #include <Utils.h>
+#include <Vocoder.h>
 #include <cmath>
+#include <complex>
 #include <vector>
 
 MAKE_TEST(BandPass_ctor) {
@@ -89,3 +92,111 @@ MAKE_TEST(BandPass_process_chunk) {
         APPROX_EQ(samples_all[i], samples_blocked[i]);
     }
 }
+
+MAKE_TEST(BandPass_process_lookahead) {
+    std::size_t const sampling_rate = 44100;
+    double const q = pwv::BandPass::approximate_q(sampling_rate, 80);
+
+    // Generate some data, with a length that leaves a tail.
+    std::vector<float> samples(sampling_rate * 2 + 5);
+    pwv::add_sine(samples, sampling_rate, 30, 0.5);
+    pwv::add_sine(samples, sampling_rate, 1000, 0.5);
+
+    for (double hz : {25, 100, 1000, 10000}) {
+        pwv::SecondOrderFilter serial;
+        pwv::SecondOrderFilter lookahead;
+        serial.reset(pwv::BandPass::coefs(sampling_rate, hz, q));
+        lookahead.reset(pwv::BandPass::coefs(sampling_rate, hz, q));
+        auto samples_serial = samples;
+        auto samples_lookahead = samples;
+        serial.process_serial(samples_serial);
+        lookahead.process_lookahead(samples_lookahead);
+
+        // The rounding differs, so compare relative to the peak.
+        float peak = 0;
+        float error = 0;
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            peak = std::max(peak, std::abs(samples_serial[i]));
+            error = std::max(
+                error, std::abs(samples_serial[i] - samples_lookahead[i]));
+        }
+        CHECK_LT(error, peak * 1e-2);
+    }
+}
+
+MAKE_TEST(BandPass_passband_accuracy) {
+    // Gain of a filter at |hz|, fitting a sine and cosine to what comes out
+    // of it once it has settled, which is exact over any length.
+    auto measure = [](auto&& filter, double sampling_rate, double hz,
+                      std::size_t settle) {
+        double const w = 2 * M_PI * hz / sampling_rate;
+        std::size_t const window = 4096;
+        double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+        for (std::size_t n = 0; n < settle + window; n++) {
+            double const y = filter(std::sin(w * n));
+            if (n >= settle) {
+                double const s = std::sin(w * n);
+                double const c = std::cos(w * n);
+                ss += s * s;
+                sc += s * c;
+                cc += c * c;
+                ys += y * s;
+                yc += y * c;
+            }
+        }
+        double const det = ss * cc - sc * sc;
+        double const a = (ys * cc - yc * sc) / det;
+        double const b = (yc * ss - ys * sc) / det;
+        return std::hypot(a, b);
+    };
+
+    for (double sampling_rate : {44100, 48000, 96000}) {
+        std::size_t num_precise = 0;
+        for (auto const& band : pwv::vocoder_bands(20, 160, sampling_rate)) {
+            // What the design should give, worked out exactly.
+            auto const& coefs = band.precise_bandpass;
+            std::complex<double> const z =
+                std::polar(1.0, 2 * M_PI * band.hz / sampling_rate);
+            double const expected =
+                std::abs((coefs.b0 + coefs.b1 / z + coefs.b2 / (z * z)) /
+                         (1.0 - coefs.a1 / z - coefs.a2 / (z * z)));
+
+            std::size_t const settle = pwv::SecondOrderFilter::decay_length(
+                band.bandpass, 1e-7);
+            pwv::PreciseFilter precise;
+            precise.reset(coefs);
+            double const precise_error =
+                std::abs(measure(precise, sampling_rate, band.hz, settle) /
+                             expected -
+                         1);
+            pwv::SecondOrderFilter rounded;
+            rounded.reset(band.bandpass);
+            auto run_rounded = [&](double x) {
+                float sample = static_cast<float>(x);
+                rounded.process_serial(std::span{&sample, 1});
+                return sample;
+            };
+            double const rounded_error = std::abs(
+                measure(run_rounded, sampling_rate, band.hz, settle) /
+                    expected -
+                1);
+
+            // Doubles are accurate everywhere, and floats wherever the bound
+            // on their rounding error says so.
+            CHECK_LT(precise_error, 1e-6);
+            double const bound = pwv::SecondOrderFilter::rounding_error(
+                coefs, 2 * M_PI * band.hz / sampling_rate);
+            CHECK_LT(rounded_error, bound);
+            if (bound <= pwv::VocoderRT::k_precise_tolerance) {
+                CHECK_LT(rounded_error, pwv::VocoderRT::k_precise_tolerance);
+            } else {
+                num_precise++;
+            }
+        }
+        // The lowest bands need it, and more of them at higher rates. The
+        // bound is cautious, so that's over a third of them at 160 bands,
+        // but still well under half.
+        CHECK_GT(num_precise, 0u);
+        CHECK_LT(num_precise, 80u);
+    }
+}
@@ -0,0 +1,65 @@
+#include "tests.h"
+
+#include <BandPass.h>
+#include <BiquadBank.h>
+#include <LowPass.h>
+#include <Utils.h>
+#include <cmath>
+#include <vector>
+
+MAKE_TEST(BiquadBank_ctor) {
+    pwv::BiquadBank bank(5);
+    CHECK_EQ(bank.size(), 5u);
+    CHECK_GE(bank.stride(), 5u);
+}
+
+MAKE_TEST(BiquadBank_matches_filters) {
+    std::size_t const sampling_rate = 1000;
+    std::size_t const num_filters = 19;
+    std::size_t const block_size = pwv::BiquadBank::k_block_size;
+    std::size_t const num_samples = block_size * 50;
+
+    // Generate some data.
+    std::vector<float> samples(num_samples);
+    pwv::add_sine(samples, sampling_rate, 60, 0.5);
+    pwv::add_sine(samples, sampling_rate, 220, 0.3);
+
+    // Mix of lowpass and bandpass filters.
+    auto coefs_for = [&](std::size_t index) {
+        double const hz = 20 + 20 * index;
+        return index % 2 ? pwv::BandPass::coefs(sampling_rate, hz, 2)
+                         : pwv::LowPass::coefs(sampling_rate, hz);
+    };
+
+    // Run each filter on its own.
+    std::vector<std::vector<float>> expected;
+    for (std::size_t index = 0; index < num_filters; index++) {
+        pwv::SecondOrderFilter filter;
+        filter.reset(coefs_for(index));
+        auto& output = expected.emplace_back(samples);
+        filter.process(output);
+    }
+
+    // Run them all through the bank.
+    pwv::BiquadBank bank(num_filters);
+    for (std::size_t index = 0; index < num_filters; index++) {
+        bank.reset(index, coefs_for(index));
+    }
+    std::size_t const stride = bank.stride();
+    std::vector<float> block(block_size * stride);
+    for (std::size_t start = 0; start < num_samples; start += block_size) {
+        bank.process_block(std::span{samples}.subspan(start, block_size),
+                           block);
+
+        // Check that they match.
+        for (std::size_t i = 0; i < block_size; i++) {
+            for (std::size_t index = 0; index < num_filters; index++) {
+                APPROX_EQ(expected[index][start + i],
+                          block[i * stride + index]);
+            }
+            for (std::size_t index = num_filters; index < stride; index++) {
+                CHECK_EQ(block[i * stride + index], 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include "tests.h"
+
+#include <CarrierAnalysis.h>
+#include <Kernels.h>
+#include <Utils.h>
+#include <Vocoder.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+MAKE_TEST(CarrierAnalysis_shared_matches_own) {
+    std::size_t const sampling_rate = 44100;
+    std::size_t const num_samples = 5000;
+    int const num_bands = 40;
+
+    // Two signals against the same carrier.
+    std::vector<float> signals[2] = {std::vector<float>(num_samples),
+                                     std::vector<float>(num_samples)};
+    pwv::add_sine(signals[0], sampling_rate, 200, 0.3);
+    pwv::add_sine(signals[0], sampling_rate, 3000, 0.2);
+    pwv::add_sine(signals[1], sampling_rate, 700, 0.3);
+    pwv::add_sine(signals[1], sampling_rate, 5000, 0.2);
+    std::vector<float> carrier(num_samples);
+    pwv::add_sine(carrier, sampling_rate, 110, 0.3);
+    pwv::add_sine(carrier, sampling_rate, 2500, 0.2);
+
+    // Fused, staged, with an envelope step, and threaded.
+    auto configure = [](pwv::VocoderRT& vocoder, int config) {
+        if (config == 1) {
+            vocoder.set_fused(false);
+        } else if (config == 2) {
+            vocoder.set_envelope_step(4);
+        } else if (config == 3) {
+            vocoder.set_num_threads(2);
+        }
+    };
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<std::size_t> chunk_size(
+        1, pwv::CarrierAnalysis::k_max_count);
+    for (auto const* variant : pwv::available_kernels()) {
+        pwv::select_kernels(variant->name);
+        for (int config = 0; config < 4; config++) {
+            // Each against its own carrier filters, in the same chunks
+            // since a short envelope step ends each one.
+            pwv::CarrierAnalysis analysis(num_bands, sampling_rate);
+            CHECK_EQ(analysis.num_bands(), std::size_t(num_bands));
+            std::vector<std::unique_ptr<pwv::VocoderRT>> shared, own;
+            std::vector<float> outputs[2], expected[2];
+            for (std::size_t i = 0; i < 2; i++) {
+                shared.push_back(std::make_unique<pwv::VocoderRT>(
+                    20, num_bands, sampling_rate));
+                configure(*shared.back(), config);
+                own.push_back(std::make_unique<pwv::VocoderRT>(
+                    20, num_bands, sampling_rate));
+                configure(*own.back(), config);
+                outputs[i].resize(num_samples);
+                expected[i].resize(num_samples);
+            }
+            for (std::size_t start = 0; start < num_samples;) {
+                std::size_t const count =
+                    std::min(num_samples - start, chunk_size(random));
+                analysis.analyze(carrier.data() + start, count);
+                CHECK_EQ(analysis.count(), count);
+                for (std::size_t i = 0; i < 2; i++) {
+                    shared[i]->process(signals[i].data() + start, analysis,
+                                       outputs[i].data() + start);
+                    own[i]->process(signals[i].data() + start,
+                                    carrier.data() + start, count,
+                                    expected[i].data() + start);
+                }
+                start += count;
+            }
+
+            for (std::size_t i = 0; i < 2; i++) {
+                for (std::size_t j = 0; j < num_samples; j++) {
+                    APPROX_EQ(outputs[i][j], expected[i][j]);
+                }
+            }
+        }
+    }
+    pwv::select_kernels(pwv::available_kernels().front()->name);
+}
@@ -0,0 +1,90 @@
+#include "tests.h"
+
+#include <CarrierAnalysis.h>
+#include <CarrierCache.h>
+#include <MultichannelVocoderRT.h>
+#include <Utils.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+MAKE_TEST(CarrierCache_matches_analysis) {
+    std::size_t const sampling_rate = 8000;
+    int const num_bands = 20;
+    std::vector<float> carrier(1500);
+    pwv::add_sine(carrier, sampling_rate, 110, 0.3);
+    pwv::add_sine(carrier, sampling_rate, 1500, 0.2);
+
+    auto const path = std::filesystem::temp_directory_path() /
+                      "pwv_test_carrier_cache.bands";
+    auto const built =
+        pwv::CarrierCache::build(path, carrier, num_bands, sampling_rate);
+    CHECK_EQ(built.has_value(), true);
+    auto const key = pwv::CarrierCache::key(carrier, num_bands, sampling_rate);
+    auto cache = pwv::CarrierCache::open(path, key);
+    CHECK_EQ(cache.has_value(), true);
+    CHECK_EQ(cache->num_samples(), carrier.size());
+
+    // It holds the second of two loops through the filters.
+    pwv::CarrierAnalysis analysis(num_bands, sampling_rate);
+    CHECK_EQ(cache->stride(), analysis.stride());
+    constexpr std::size_t k_chunk_size = pwv::CarrierAnalysis::k_max_count;
+    for (int pass = 0; pass < 2; pass++) {
+        for (std::size_t start = 0; start < carrier.size();
+             start += k_chunk_size) {
+            std::size_t const count =
+                std::min(carrier.size() - start, k_chunk_size);
+            analysis.analyze(carrier.data() + start, count);
+            if (pass == 0) {
+                continue;
+            }
+            float const* const bands =
+                cache->bands() + start * cache->stride();
+            for (std::size_t i = 0; i < count * analysis.stride(); i++) {
+                APPROX_EQ(bands[i], analysis.bands()[i]);
+            }
+        }
+    }
+
+    // On the second loop, a vocoder reading it matches one that keeps
+    // filtering the carrier itself.
+    pwv::MultichannelVocoderRT own(20, num_bands, sampling_rate, 1);
+    pwv::MultichannelVocoderRT cached(20, num_bands, sampling_rate, 1);
+    std::vector<float> signal(carrier.size());
+    pwv::add_sine(signal, sampling_rate, 300, 0.3);
+    std::vector<float> expected(carrier.size());
+    std::vector<float> output(carrier.size());
+    for (int pass = 0; pass < 2; pass++) {
+        own.process(signal.data(), carrier.data(), carrier.size(),
+                    expected.data());
+    }
+    cached.process(signal.data(), carrier.data(), carrier.size(),
+                   output.data());
+    cached.process_analyzed(signal.data(), cache->bands(), carrier.size(),
+                            output.data());
+    for (std::size_t i = 0; i < carrier.size(); i++) {
+        APPROX_EQ(output[i], expected[i]);
+    }
+
+    // Anything else is stale.
+    std::vector<float> other = carrier;
+    other[100] += 0.1f;
+    CHECK_EQ(pwv::CarrierCache::open(
+                 path, pwv::CarrierCache::key(other, num_bands, sampling_rate))
+                 .has_value(),
+             false);
+    CHECK_EQ(pwv::CarrierCache::open(
+                 path, pwv::CarrierCache::key(carrier, 10, sampling_rate))
+                 .has_value(),
+             false);
+    CHECK_EQ(pwv::CarrierCache::open(
+                 path, pwv::CarrierCache::key(carrier, num_bands, 16000))
+                 .has_value(),
+             false);
+
+    // And so is a cut short file.
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    CHECK_EQ(pwv::CarrierCache::open(path, key).has_value(), false);
+    std::filesystem::remove(path);
+}
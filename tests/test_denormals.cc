@@ -0,0 +1,51 @@
+#include "tests.h"
+
+#include <BandPass.h>
+#include <Denormals.h>
+#include <LowPass.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+MAKE_TEST(FlushDenormals_scope) {
+    volatile float const tiny = std::numeric_limits<float>::min();
+    auto const halved = [&] { return tiny / 2; };
+    CHECK_NE(halved(), 0.0f);
+    {
+        pwv::FlushDenormals const flush_denormals;
+#if defined(__SSE__) || defined(__aarch64__)
+        CHECK_EQ(halved(), 0.0f);
+#endif
+        // Nesting leaves it on.
+        { pwv::FlushDenormals const nested; }
+#if defined(__SSE__) || defined(__aarch64__)
+        CHECK_EQ(halved(), 0.0f);
+#endif
+    }
+    CHECK_NE(halved(), 0.0f);
+}
+
+MAKE_TEST(FlushDenormals_filters) {
+    // Used on their own, outside any vocoder, the filters still ring down
+    // to zero rather than through denormals.
+    auto const check = [](auto& filter) {
+        std::vector<float> data(1 << 14);
+        data[0] = 1;
+        filter.process(data);
+        for (float value : data) {
+            if (value != 0) {
+                CHECK_GE(std::abs(value), std::numeric_limits<float>::min());
+            }
+        }
+        CHECK_EQ(data.back(), 0.0f);
+    };
+#if defined(__SSE__) || defined(__aarch64__)
+    pwv::LowPass lowpass(44100, 2000);
+    check(lowpass);
+    pwv::BandPass bandpass(44100, 2000, 10);
+    check(bandpass);
+    pwv::LowPass state_variable(44100, 2000,
+                                pwv::FilterTopology::StateVariable);
+    check(state_variable);
+#endif
+}
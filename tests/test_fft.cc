@@ -0,0 +1,63 @@
+#include "tests.h"
+
+#include <FFT.h>
+#include <Kernels.h>
+#include <cmath>
+#include <vector>
+
+MAKE_TEST(FFT_matches_dft) {
+    for (auto const* variant : pwv::available_kernels()) {
+        pwv::select_kernels(variant->name);
+
+        // Small sizes only take the scalar path, large ones the vector one.
+        for (std::size_t size : {1, 2, 4, 8, 64, 512}) {
+            std::vector<float> re(size);
+            std::vector<float> im(size);
+            for (std::size_t i = 0; i < size; i++) {
+                re[i] = std::sin(0.3 * i * i + 1);
+                im[i] = std::cos(0.7 * i);
+            }
+
+            std::vector<double> expected_re(size);
+            std::vector<double> expected_im(size);
+            for (std::size_t k = 0; k < size; k++) {
+                for (std::size_t i = 0; i < size; i++) {
+                    double const angle = -2 * M_PI * ((i * k) % size) / size;
+                    expected_re[k] +=
+                        re[i] * std::cos(angle) - im[i] * std::sin(angle);
+                    expected_im[k] +=
+                        re[i] * std::sin(angle) + im[i] * std::cos(angle);
+                }
+            }
+
+            pwv::FFT fft(size);
+            fft.forward(re, im);
+            double const tolerance = 1e-5 * size;
+            for (std::size_t k = 0; k < size; k++) {
+                CHECK_LT(std::abs(re[k] - expected_re[k]), tolerance);
+                CHECK_LT(std::abs(im[k] - expected_im[k]), tolerance);
+            }
+        }
+    }
+    pwv::select_kernels(pwv::available_kernels().front()->name);
+}
+
+MAKE_TEST(FFT_round_trip) {
+    std::size_t const size = 1024;
+    std::vector<float> re(size);
+    std::vector<float> im(size);
+    for (std::size_t i = 0; i < size; i++) {
+        re[i] = std::sin(0.01 * i * i);
+        im[i] = 0.5f - (i % 7) / 7.0f;
+    }
+    auto const original_re = re;
+    auto const original_im = im;
+
+    pwv::FFT fft(size);
+    fft.forward(re, im);
+    fft.inverse(re, im);
+    for (std::size_t i = 0; i < size; i++) {
+        CHECK_LT(std::abs(re[i] / size - original_re[i]), 1e-5);
+        CHECK_LT(std::abs(im[i] / size - original_im[i]), 1e-5);
+    }
+}
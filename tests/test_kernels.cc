@@ -0,0 +1,277 @@
+#include "tests.h"
+
+#include <BiquadBank.h>
+#include <Kernels.h>
+#include <LowPass.h>
+#include <PreciseFilter.h>
+#include <Utils.h>
+#include <Vocoder.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Restores the default kernels when it goes out of scope.
+struct KernelsScope {
+    ~KernelsScope() {
+        pwv::select_kernels(pwv::available_kernels().front()->name);
+    }
+};
+
+}  // namespace
+
+MAKE_TEST(Kernels_available) {
+    CHECK_GT(pwv::available_kernels().size(), 0u);
+    CHECK_EQ(pwv::select_kernels("not a real target"), false);
+}
+
+MAKE_TEST(Kernels_match_scalar) {
+    KernelsScope const scope;
+
+    // Odd sizes so that every kernel has a tail.
+    std::size_t const count = 61;
+    std::vector<float> a(count);
+    std::vector<float> b(count);
+    pwv::add_sine(a, 100, 7, 1.5);
+    pwv::add_sine(b, 100, 3, 0.5);
+
+    for (auto const* variant : pwv::available_kernels()) {
+        CHECK_EQ(pwv::select_kernels(variant->name), true);
+        pwv::Kernels const& kernels = pwv::kernels();
+
+        auto result = a;
+        kernels.abs(result.data(), count);
+        for (std::size_t i = 0; i < count; i++) {
+            CHECK_EQ(result[i], std::abs(a[i]));
+        }
+
+        result = a;
+        kernels.mul(result.data(), b.data(), count);
+        for (std::size_t i = 0; i < count; i++) {
+            CHECK_EQ(result[i], a[i] * b[i]);
+        }
+
+        result = a;
+        kernels.add(result.data(), b.data(), count);
+        for (std::size_t i = 0; i < count; i++) {
+            CHECK_EQ(result[i], a[i] + b[i]);
+        }
+
+        double dot = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            dot += a[i] * b[i];
+        }
+        APPROX_EQ(kernels.dot(a.data(), b.data(), count), dot);
+
+        // Clamps out of range samples and round trips the rest.
+        std::vector<int16_t> raw(count);
+        kernels.float_to_int16(a.data(), raw.data(), count);
+        kernels.int16_to_float(raw.data(), result.data(), count);
+        for (std::size_t i = 0; i < count; i++) {
+            float const expected = std::clamp(a[i], -1.0f, 32767 / 32768.0f);
+            CHECK_LT(std::abs(result[i] - expected), 1 / 32768.0f);
+        }
+
+        // Look-ahead kernel against the serial filter.
+        pwv::SecondOrderFilter serial;
+        pwv::SecondOrderFilter lookahead;
+        serial.reset(pwv::LowPass::coefs(100, 10));
+        lookahead.reset(pwv::LowPass::coefs(100, 10));
+        auto samples_serial = a;
+        auto samples_lookahead = a;
+        serial.process_serial(samples_serial);
+        lookahead.process_lookahead(samples_lookahead);
+        for (std::size_t i = 0; i < count; i++) {
+            APPROX_EQ(samples_serial[i], samples_lookahead[i]);
+        }
+
+        // Halfband kernels against the filter written out in full.
+        std::vector<float> const taps{0.3f, -0.08f, 0.03f};
+        std::size_t const centre = 2 * taps.size() - 1;
+        auto tap = [&](std::size_t j) {
+            std::size_t const offset = j > centre ? j - centre : centre - j;
+            if (offset == 0) {
+                return 0.5f;
+            }
+            return offset % 2 ? taps[offset / 2] : 0.0f;
+        };
+        std::size_t const half_count = (count - 2 * centre) / 2;
+        std::vector<float> decimated(half_count);
+        kernels.halfband_decimate(taps.data(), taps.size(),
+                                  a.data() + 2 * centre, decimated.data(),
+                                  half_count);
+        for (std::size_t n = 0; n < half_count; n++) {
+            float expected = 0;
+            for (std::size_t j = 0; j <= 2 * centre; j++) {
+                expected += tap(j) * a[2 * centre + 2 * n - j];
+            }
+            APPROX_EQ(decimated[n], expected);
+        }
+        std::vector<float> interpolated(2 * half_count);
+        kernels.halfband_interpolate_add(taps.data(), taps.size(),
+                                         a.data() + centre,
+                                         interpolated.data(), half_count);
+        for (std::size_t m = 0; m < 2 * half_count; m++) {
+            // Zero stuffed, so only every other tap lands on an input.
+            float expected = 0;
+            for (std::size_t j = m % 2; j <= 2 * centre; j += 2) {
+                expected += 2 * tap(j) * a[(2 * centre + m - j) / 2];
+            }
+            APPROX_EQ(interpolated[m], expected);
+        }
+
+        // Fused vocoder against the staged one, on whole blocks.
+        std::size_t const vocoder_count =
+            count / pwv::VocoderRT::k_block_size * pwv::VocoderRT::k_block_size;
+        pwv::VocoderRT staged(20, 19, 100);
+        pwv::VocoderRT fused(20, 19, 100);
+        staged.set_fused(false);
+        std::vector<float> output_staged(vocoder_count);
+        std::vector<float> output_fused(vocoder_count);
+        staged.process(a.data(), b.data(), vocoder_count, output_staged.data());
+        fused.process(a.data(), b.data(), vocoder_count, output_fused.data());
+        for (std::size_t i = 0; i < vocoder_count; i++) {
+            APPROX_EQ(output_staged[i], output_fused[i]);
+        }
+
+        // Vocoder in doubles against PreciseFilters a band at a time, in two
+        // calls to carry the state across.
+        {
+            auto const bands = pwv::vocoder_bands(20, 19, 100);
+            pwv::PreciseBiquadBank signal_bandpass(bands.size());
+            pwv::PreciseBiquadBank carrier_bandpass(bands.size());
+            pwv::PreciseBiquadBank envelope_lowpass(bands.size());
+            pwv::PreciseBiquadBank output_bandpass(bands.size());
+            std::vector<double> expected(count);
+            for (std::size_t band = 0; band < bands.size(); band++) {
+                auto const& bandpass = bands[band].precise_bandpass;
+                auto const& lowpass = bands[band].precise_lowpass;
+                signal_bandpass.reset(band, bandpass);
+                carrier_bandpass.reset(band, bandpass);
+                envelope_lowpass.reset(band, lowpass);
+                output_bandpass.reset(band, bandpass);
+                pwv::PreciseFilter filters[4];
+                filters[0].reset(bandpass);
+                filters[1].reset(bandpass);
+                filters[2].reset(lowpass);
+                filters[3].reset(bandpass);
+                for (std::size_t i = 0; i < count; i++) {
+                    double const envelope =
+                        filters[2](std::abs(filters[0](a[i])));
+                    expected[i] += 3 * filters[3](envelope * filters[1](b[i]));
+                }
+            }
+            pwv::PreciseVocoderBankRefs const banks{
+                signal_bandpass.refs(), carrier_bandpass.refs(),
+                envelope_lowpass.refs(), output_bandpass.refs()};
+            std::size_t const split = 40;
+            std::vector<float> output(count, 1.0f);
+            kernels.vocoder_precise(banks, a.data(), b.data(), output.data(),
+                                    split, 3);
+            kernels.vocoder_precise(banks, a.data() + split, b.data() + split,
+                                    output.data() + split, count - split, 3);
+            for (std::size_t i = 0; i < count; i++) {
+                APPROX_EQ(output[i], 1 + expected[i]);
+            }
+        }
+
+        // Lattices against running them a sample at a time, in two calls to
+        // carry the state across.
+        std::vector<float> const reflection{0.5f, -0.3f, 0.2f, 0.6f,
+                                            -0.1f, 0.4f, -0.5f};
+        std::size_t const order = reflection.size();
+        std::vector<double> expected(count);
+        std::vector<double> expected_state(order);
+        for (std::size_t n = 0; n < count; n++) {
+            double forward = a[n];
+            double backward = a[n];
+            for (std::size_t i = 0; i < order; i++) {
+                double const delayed = expected_state[i];
+                expected_state[i] = backward;
+                backward = delayed + reflection[i] * forward;
+                forward += reflection[i] * delayed;
+            }
+            expected[n] = forward;
+        }
+        std::size_t const split = 40;
+        std::vector<float> forward = a;
+        std::vector<float> backward = a;
+        std::vector<float> state(order);
+        kernels.lattice_inverse(reflection.data(), state.data(), order,
+                                forward.data(), backward.data(), split);
+        kernels.lattice_inverse(reflection.data(), state.data(), order,
+                                forward.data() + split,
+                                backward.data() + split, count - split);
+        for (std::size_t n = 0; n < count; n++) {
+            APPROX_EQ(forward[n], expected[n]);
+        }
+
+        // The all-pole lattice undoes it.
+        std::vector<float> even_reflection;
+        std::vector<float> odd_reflection;
+        for (std::size_t i = 0; i < order; i++) {
+            (i % 2 ? odd_reflection : even_reflection).push_back(reflection[i]);
+        }
+        std::vector<float> even_state(order / 2 + 1);
+        std::vector<float> odd_state(order / 2 + 1);
+        kernels.lattice_all_pole(even_reflection.data(), odd_reflection.data(),
+                                 even_state.data(), odd_state.data(), order,
+                                 forward.data(), split);
+        kernels.lattice_all_pole(even_reflection.data(), odd_reflection.data(),
+                                 even_state.data(), odd_state.data(), order,
+                                 forward.data() + split, count - split);
+        for (std::size_t n = 0; n < count; n++) {
+            APPROX_EQ(forward[n], a[n]);
+        }
+    }
+}
+
+MAKE_TEST(Kernels_vocoder_step_longer_than_tile) {
+    std::size_t const sampling_rate = 44100;
+    std::size_t const num_bands = 10;
+    std::size_t const count = 1000;
+
+    std::vector<float> signal(count);
+    std::vector<float> carrier(count);
+    pwv::add_sine(signal, sampling_rate, 440, 0.5);
+    pwv::add_sine(carrier, sampling_rate, 300, 0.5);
+
+    auto run = [&](std::size_t tile_size) {
+        auto const bands = pwv::vocoder_bands(20, num_bands, sampling_rate);
+        pwv::BiquadBank banks[4];
+        for (auto& bank : banks) {
+            bank.resize(num_bands);
+        }
+        for (std::size_t band = 0; band < num_bands; band++) {
+            banks[0].reset(band, bands[band].bandpass);
+            banks[1].reset(band, bands[band].bandpass);
+            banks[2].reset(band, bands[band].lowpass);
+            banks[3].reset(band, bands[band].bandpass);
+        }
+        pwv::VocoderBankRefs const refs{banks[0].refs(), banks[1].refs(),
+                                        banks[2].refs(), banks[3].refs()};
+        std::vector<float> output(count);
+        pwv::kernels().vocoder(refs, signal.data(), carrier.data(),
+                               output.data(), count, tile_size, 16);
+        return output;
+    };
+
+    // A tile of 8 can't hold a step of 16, so it runs as tiles of 16.
+    auto const expected = run(16);
+    auto const output = run(8);
+    float peak = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        CHECK_EQ(output[i], expected[i]);
+        peak = std::max(peak, std::abs(output[i]));
+    }
+    CHECK_GT(peak, 0);
+
+    // Nor can a tile of 40, which isn't a preset size, so it runs as tiles
+    // of 48 rather than ending each one on a short step.
+    auto const stretched = run(48);
+    auto const runtime = run(40);
+    for (std::size_t i = 0; i < count; i++) {
+        CHECK_EQ(runtime[i], stretched[i]);
+    }
+}
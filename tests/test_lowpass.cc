@@ -2,6 +2,7 @@
 
 #include <LowPass.h>
 #include <Utils.h>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
@@ -79,3 +80,183 @@ MAKE_TEST(LowPass_process_chunk) {
         APPROX_EQ(samples_all[i], samples_blocked[i]);
     }
 }
+
+MAKE_TEST(LowPass_process_odd_chunk) {
+    std::size_t const sampling_rate = 100;
+    std::size_t const cutoff_hz = 10;
+    std::size_t const num_samples = 1000;
+
+    // Generate some data.
+    std::vector<float> samples_all(num_samples);
+    pwv::add_sine(samples_all, sampling_rate, cutoff_hz, 0.1);
+    auto samples_chunked = samples_all;
+    auto samples_lookahead = samples_all;
+
+    // Apply it in a single chunk.
+    auto const coefs = pwv::LowPass::coefs(sampling_rate, cutoff_hz);
+    pwv::SecondOrderFilter filter_all;
+    filter_all.reset(coefs);
+    filter_all.process_serial(samples_all);
+
+    // Apply it in chunks of varying size, including empty and single samples.
+    pwv::SecondOrderFilter filter_chunk;
+    pwv::SecondOrderFilter filter_lookahead;
+    filter_chunk.reset(coefs);
+    filter_lookahead.reset(coefs);
+    std::size_t chunk_start = 0;
+    for (std::size_t chunk_size = 0; chunk_start < num_samples;
+         chunk_size = (chunk_size + 1) % 37) {
+        chunk_size = std::min(chunk_size, num_samples - chunk_start);
+        filter_chunk.process_serial(
+            std::span{samples_chunked}.subspan(chunk_start, chunk_size));
+        filter_lookahead.process_lookahead(
+            std::span{samples_lookahead}.subspan(chunk_start, chunk_size));
+        chunk_start += chunk_size;
+    }
+
+    // Serially it's the same arithmetic whatever the chunking. The look-ahead
+    // kernel rounds differently depending on where its steps fall.
+    for (std::size_t i = 0; i < samples_all.size(); i++) {
+        CHECK_EQ(samples_all[i], samples_chunked[i]);
+        APPROX_EQ(samples_all[i], samples_lookahead[i]);
+    }
+}
+
+MAKE_TEST(LowPass_process_lookahead) {
+    std::size_t const sampling_rate = 44100;
+
+    // Generate some data, with a length that leaves a tail.
+    std::vector<float> samples(sampling_rate * 2 + 5);
+    pwv::add_sine(samples, sampling_rate, 30, 0.5);
+    pwv::add_sine(samples, sampling_rate, 1000, 0.5);
+
+    for (double cutoff_hz : {5, 50, 500}) {
+        pwv::SecondOrderFilter serial;
+        pwv::SecondOrderFilter lookahead;
+        serial.reset(pwv::LowPass::coefs(sampling_rate, cutoff_hz));
+        lookahead.reset(pwv::LowPass::coefs(sampling_rate, cutoff_hz));
+        auto samples_serial = samples;
+        auto samples_lookahead = samples;
+        serial.process_serial(samples_serial);
+        lookahead.process_lookahead(samples_lookahead);
+
+        // The rounding differs, so compare relative to the peak.
+        float peak = 0;
+        float error = 0;
+        for (std::size_t i = 0; i < samples.size(); i++) {
+            peak = std::max(peak, std::abs(samples_serial[i]));
+            error = std::max(
+                error, std::abs(samples_serial[i] - samples_lookahead[i]));
+        }
+        CHECK_LT(error, peak * 1e-2);
+    }
+}
+
+MAKE_TEST(LowPass_lookahead_rebuild) {
+    std::size_t const sampling_rate = 48000;
+    std::size_t const chunk_size = 64;
+
+    std::vector<float> samples(chunk_size * 16);
+    pwv::add_sine(samples, sampling_rate, 440, 0.5);
+
+    // The look-ahead matrix is built a few columns a call after the
+    // coefficients change, and the calls in the meantime run serially.
+    pwv::SecondOrderFilter serial;
+    pwv::SecondOrderFilter lookahead;
+    serial.reset(pwv::LowPass::coefs(sampling_rate, 2000));
+    lookahead.reset(pwv::LowPass::coefs(sampling_rate, 2000));
+    std::size_t const num_builds =
+        pwv::k_lookahead_columns /
+        pwv::SecondOrderFilter::k_lookahead_build_columns;
+    for (int change = 0; change < 2; change++) {
+        for (std::size_t call = 0; call < num_builds; call++) {
+            auto const chunk = std::span{samples}.subspan(
+                (change * num_builds + call) * chunk_size, chunk_size);
+            std::vector<float> expected(chunk.begin(), chunk.end());
+            serial.process_serial(expected);
+            lookahead.process_lookahead(chunk);
+            if (call != num_builds - 1) {
+                for (std::size_t i = 0; i < chunk_size; i++) {
+                    CHECK_EQ(chunk[i], expected[i]);
+                }
+                continue;
+            }
+
+            // Once it's built, the rounding differs, so compare relative to
+            // the peak.
+            float peak = 0;
+            float error = 0;
+            for (std::size_t i = 0; i < chunk_size; i++) {
+                peak = std::max(peak, std::abs(expected[i]));
+                error = std::max(error, std::abs(chunk[i] - expected[i]));
+            }
+            CHECK_LT(error, peak * 1e-4);
+        }
+        // Again from rest, so that they line up exactly again.
+        serial.reset(pwv::LowPass::coefs(sampling_rate, 500));
+        lookahead.reset(pwv::LowPass::coefs(sampling_rate, 500));
+    }
+}
+
+MAKE_TEST(LowPass_ramp) {
+    std::size_t const sampling_rate = 48000;
+    std::size_t const num_samples = 20000;
+    std::size_t const ramp_start = 3000;
+    std::size_t const ramp_length = 4800;
+
+    std::vector<float> samples(num_samples);
+    pwv::add_sine(samples, sampling_rate, 440, 0.5);
+    auto const from = pwv::LowPass::coefs(sampling_rate, 2000);
+    auto const to = pwv::LowPass::coefs(sampling_rate, 200);
+
+    // The same thing a sample at a time, with the coefficients interpolated.
+    std::vector<float> expected = samples;
+    {
+        double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+        for (std::size_t i = 0; i < num_samples; i++) {
+            double const t =
+                std::clamp((static_cast<double>(i) - ramp_start + 1) /
+                               ramp_length,
+                           0.0, 1.0);
+            auto lerp = [t](float a, float b) { return a + (b - a) * t; };
+            double const x = samples[i];
+            double const y = lerp(from.b0, to.b0) * x +
+                             lerp(from.b1, to.b1) * x1 +
+                             lerp(from.b2, to.b2) * x2 +
+                             lerp(from.a1, to.a1) * y1 +
+                             lerp(from.a2, to.a2) * y2;
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            expected[i] = y;
+        }
+    }
+
+    // In chunks that don't line up with the ramp or the look-ahead steps.
+    pwv::SecondOrderFilter filter;
+    filter.reset(from);
+    std::size_t const chunk_size = 37;
+    for (std::size_t start = 0; start < num_samples;) {
+        if (start == ramp_start) {
+            filter.ramp_to(to, ramp_length);
+            CHECK_EQ(filter.ramping(), true);
+        }
+        std::size_t end = std::min(start + chunk_size, num_samples);
+        if (start < ramp_start && ramp_start < end) {
+            end = ramp_start;
+        }
+        filter.process(std::span{samples}.subspan(start, end - start));
+        start = end;
+    }
+    CHECK_EQ(filter.ramping(), false);
+
+    // It keeps to the interpolated filter, without restarting from rest.
+    float peak = 0;
+    float error = 0;
+    for (std::size_t i = 0; i < num_samples; i++) {
+        peak = std::max(peak, std::abs(expected[i]));
+        error = std::max(error, std::abs(samples[i] - expected[i]));
+    }
+    CHECK_LT(error, peak * 1e-3);
+}
@@ -0,0 +1,87 @@
+#include "tests.h"
+
+#include <CarrierAnalysis.h>
+#include <Kernels.h>
+#include <MultichannelVocoderRT.h>
+#include <Utils.h>
+#include <Vocoder.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+MAKE_TEST(MultichannelVocoderRT_matches_mono) {
+    std::size_t const sampling_rate = 44100;
+    std::size_t const num_frames = 5000;
+
+    // Something different in every channel.
+    std::size_t const max_channels = 6;
+    std::vector<std::vector<float>> signals(max_channels,
+                                            std::vector<float>(num_frames));
+    for (std::size_t channel = 0; channel < max_channels; channel++) {
+        pwv::add_sine(signals[channel], sampling_rate, 200 + 300 * channel,
+                      0.3);
+        pwv::add_sine(signals[channel], sampling_rate, 4000 - 500 * channel,
+                      0.2);
+    }
+    std::vector<float> carrier(num_frames);
+    pwv::add_sine(carrier, sampling_rate, 110, 0.3);
+    pwv::add_sine(carrier, sampling_rate, 2500, 0.2);
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<std::size_t> chunk_size(1, 200);
+    for (auto const* variant : pwv::available_kernels()) {
+        pwv::select_kernels(variant->name);
+
+        // Each channel on its own.
+        std::vector<std::vector<float>> expected(
+            max_channels, std::vector<float>(num_frames));
+        for (std::size_t channel = 0; channel < max_channels; channel++) {
+            pwv::VocoderRT(20, 40, sampling_rate)
+                .process(signals[channel].data(), carrier.data(), num_frames,
+                         expected[channel].data());
+        }
+
+        for (std::size_t num_channels : {1, 2, 6}) {
+            pwv::MultichannelVocoderRT vocoder(20, 40, sampling_rate,
+                                               num_channels);
+            CHECK_EQ(vocoder.num_channels(), num_channels);
+
+            // Interleave, and run it in place in chunks of any size.
+            std::vector<float> frames(num_frames * num_channels);
+            for (std::size_t i = 0; i < num_frames; i++) {
+                for (std::size_t channel = 0; channel < num_channels;
+                     channel++) {
+                    frames[i * num_channels + channel] = signals[channel][i];
+                }
+            }
+            // And the same with the carrier split into bands up front.
+            std::vector<float> analyzed_frames = frames;
+            pwv::MultichannelVocoderRT analyzed(20, 40, sampling_rate,
+                                                num_channels);
+            pwv::CarrierAnalysis analysis(40, sampling_rate);
+            for (std::size_t start = 0; start < num_frames;) {
+                std::size_t const count =
+                    std::min(num_frames - start, chunk_size(random));
+                float* const chunk = frames.data() + start * num_channels;
+                vocoder.process(chunk, carrier.data() + start, count, chunk);
+                float* const analyzed_chunk =
+                    analyzed_frames.data() + start * num_channels;
+                analysis.analyze(carrier.data() + start, count);
+                analyzed.process_analyzed(analyzed_chunk, analysis.bands(),
+                                          count, analyzed_chunk);
+                start += count;
+            }
+
+            for (std::size_t i = 0; i < num_frames; i++) {
+                for (std::size_t channel = 0; channel < num_channels;
+                     channel++) {
+                    APPROX_EQ(frames[i * num_channels + channel],
+                              expected[channel][i]);
+                    APPROX_EQ(analyzed_frames[i * num_channels + channel],
+                              expected[channel][i]);
+                }
+            }
+        }
+    }
+    pwv::select_kernels(pwv::available_kernels().front()->name);
+}
@@ -0,0 +1,97 @@
+#include "tests.h"
+
+#include <MultirateVocoderRT.h>
+#include <Utils.h>
+#include <Vocoder.h>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Something with energy in most bands.
+void make_inputs(std::vector<float>& signal, std::vector<float>& carrier,
+                 double sampling_rate) {
+    for (float hz : {110, 250, 700, 1500, 3200, 7000}) {
+        pwv::add_sine(signal, sampling_rate, hz, 0.1);
+    }
+    for (float hz : {55, 130, 440, 1200, 2500, 5000, 9000}) {
+        pwv::add_sine(carrier, sampling_rate, hz, 0.1);
+    }
+}
+
+}  // namespace
+
+MAKE_TEST(MultirateVocoderRT_ctor) {
+    pwv::MultirateVocoderRT vocoder(20, 40, 44100);
+    std::size_t total = 0;
+    for (std::size_t depth = 0; depth <= vocoder.k_max_depth; depth++) {
+        total += vocoder.num_bands(depth);
+    }
+    CHECK_EQ(total, 40u);
+
+    // The low bands should have been moved down.
+    CHECK_GT(vocoder.num_bands(vocoder.k_max_depth), 0u);
+    CHECK_GT(vocoder.latency(), 0u);
+}
+
+MAKE_TEST(MultirateVocoderRT_process_chunk) {
+    std::size_t const sampling_rate = 44100;
+    std::size_t const num_samples = pwv::MultirateVocoderRT::k_block_size * 100;
+
+    std::vector<float> input_signal(num_samples);
+    std::vector<float> input_carrier(num_samples);
+    make_inputs(input_signal, input_carrier, sampling_rate);
+
+    // Apply it in a single chunk.
+    std::vector<float> output_all(num_samples);
+    pwv::MultirateVocoderRT(20, 40, sampling_rate)
+        .process(input_signal.data(), input_carrier.data(), num_samples,
+                 output_all.data());
+
+    // Apply it in chunks.
+    std::size_t const chunk_size = pwv::MultirateVocoderRT::k_block_size;
+    pwv::MultirateVocoderRT vocoder(20, 40, sampling_rate);
+    std::vector<float> output_chunk(num_samples);
+    for (std::size_t chunk_start = 0; chunk_start < num_samples;
+         chunk_start += chunk_size) {
+        vocoder.process(input_signal.data() + chunk_start,
+                        input_carrier.data() + chunk_start, chunk_size,
+                        output_chunk.data() + chunk_start);
+    }
+
+    for (std::size_t i = 0; i < num_samples; i++) {
+        APPROX_EQ(output_all[i], output_chunk[i]);
+    }
+}
+
+MAKE_TEST(MultirateVocoderRT_matches_rt) {
+    for (double sampling_rate : {44100, 48000}) {
+        std::size_t const num_samples =
+            pwv::MultirateVocoderRT::k_block_size * 4096;
+
+        std::vector<float> input_signal(num_samples);
+        std::vector<float> input_carrier(num_samples);
+        make_inputs(input_signal, input_carrier, sampling_rate);
+
+        std::vector<float> expected(num_samples);
+        pwv::VocoderRT(20, 40, sampling_rate)
+            .process(input_signal.data(), input_carrier.data(), num_samples,
+                     expected.data());
+
+        pwv::MultirateVocoderRT vocoder(20, 40, sampling_rate);
+        std::vector<float> output(num_samples);
+        vocoder.process(input_signal.data(), input_carrier.data(),
+                        num_samples, output.data());
+
+        // Compare once the filters have settled, allowing for the latency.
+        std::size_t const latency = vocoder.latency();
+        double error = 0;
+        double energy = 0;
+        for (std::size_t i = num_samples / 2; i + latency < num_samples; i++) {
+            double const diff = output[i + latency] - expected[i];
+            error += diff * diff;
+            energy += expected[i] * expected[i];
+        }
+        CHECK_LT(std::sqrt(error / energy), 0.15);
+    }
+}
@@ -0,0 +1,235 @@
+#include "tests.h"
+
+#include <BandPass.h>
+#include <Kernels.h>
+#include <LowPass.h>
+#include <NumericPolicy.h>
+#include <Utils.h>
+#include <Vocoder.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Something with energy in most bands.
+void make_inputs(std::vector<float>& signal, std::vector<float>& carrier,
+                 double sampling_rate) {
+    for (float hz : {110, 250, 700, 1500, 3200, 7000}) {
+        pwv::add_sine(signal, sampling_rate, hz, 0.1);
+    }
+    for (float hz : {55, 130, 440, 1200, 2500, 5000, 9000}) {
+        pwv::add_sine(carrier, sampling_rate, hz, 0.1);
+    }
+}
+
+template <typename Vocoder>
+std::vector<float> run(Vocoder& vocoder, std::vector<float> const& signal,
+                       std::vector<float> const& carrier) {
+    std::vector<float> output(signal.size());
+    // Uneven calls, across chunks.
+    std::size_t const call_size = 300;
+    for (std::size_t start = 0; start < signal.size(); start += call_size) {
+        vocoder.process(signal.data() + start, carrier.data() + start,
+                        std::min(call_size, signal.size() - start),
+                        output.data() + start);
+    }
+    return output;
+}
+
+// RMS of the difference from sample |start| on, relative to the RMS of
+// |expected|.
+double relative_error(std::vector<float> const& expected,
+                      std::vector<float> const& actual,
+                      std::size_t start = 0) {
+    double error = 0;
+    double energy = 0;
+    for (std::size_t i = start; i < expected.size(); i++) {
+        double const diff = actual[i] - expected[i];
+        error += diff * diff;
+        energy += expected[i] * expected[i];
+    }
+    return std::sqrt(error / energy);
+}
+
+// Restores the default kernels when it goes out of scope.
+struct KernelsScope {
+    ~KernelsScope() {
+        pwv::select_kernels(pwv::available_kernels().front()->name);
+    }
+};
+
+}  // namespace
+
+MAKE_TEST(NumericPolicy_fixed_point) {
+    using Int16 = pwv::Q31Int16Policy;
+    using Q31 = pwv::Q31Policy;
+
+    // Samples round trip, and saturate past full scale.
+    CHECK_EQ(Int16::from_float(0.5f), 16384);
+    CHECK_EQ(Int16::from_float(2.0f), 32767);
+    CHECK_EQ(Int16::from_float(-2.0f), -32768);
+    CHECK_EQ(Int16::to_sample(Int16::from_sample(-32768)), -32768);
+    CHECK_EQ(Q31::to_sample(Q31::from_sample(1 << 20)), 1 << 20);
+    CHECK_EQ(Int16::to_sample(Int16::from_sample(12345)), 12345);
+    CHECK_EQ(Int16::to_float(Int16::from_float(0.25f)), 0.25f);
+
+    // The state has headroom past a sample, and saturates past that.
+    int32_t const max_state = std::numeric_limits<int32_t>::max();
+    CHECK_EQ(Int16::to_sample(Int16::from_sample(20000) * 4), 32767);
+    CHECK_EQ(Int16::abs(std::numeric_limits<int32_t>::min()), max_state);
+    CHECK_EQ(Int16::mul(max_state, max_state), max_state);
+    CHECK_EQ(Int16::mul(1 << 26, 1 << 26), 1 << 25);
+    CHECK_EQ(Int16::output(int64_t{1} << 40, 50), 32767);
+
+    // The low pass passes DC at exactly unity, however few steps its
+    // numerator rounds to.
+    for (double cutoff : {1.0, 5.0, 100.0}) {
+        auto const coefs = pwv::LowPass::coefs<Q31>(96000, cutoff);
+        CHECK_GT(coefs.b0, 0);
+        CHECK_EQ(int64_t{coefs.b0} + coefs.b1 + coefs.b2,
+                 (int64_t{1} << pwv::k_fixed_coef_bits) - coefs.a1 -
+                     coefs.a2);
+    }
+}
+
+MAKE_TEST(VocoderRT_fixed_point_matches_doubles) {
+    for (std::size_t sampling_rate : {44100, 48000}) {
+        std::size_t const num_samples = sampling_rate;
+        std::vector<float> input_signal(num_samples);
+        std::vector<float> input_carrier(num_samples);
+        make_inputs(input_signal, input_carrier, sampling_rate);
+
+        for (int num_bands : {10, 40, 80}) {
+            // Every band in doubles, with the envelope followers every
+            // sample as the fixed point versions run them. Floats differ
+            // from that by what they lose in the lowest bands, and fixed
+            // point lands near it, as far as its precision goes.
+            // That's picked up as a retune is, so it's only all doubles once
+            // the float lanes have faded out.
+            pwv::VocoderRT precise(20, num_bands, sampling_rate);
+            precise.set_precise_tolerance(0);
+            auto const expected = run(precise, input_signal, input_carrier);
+            std::size_t const start = pwv::VocoderRT::k_retune_steps *
+                                      pwv::VocoderRT::k_retune_step_size;
+            pwv::VocoderRT vocoder(20, num_bands, sampling_rate);
+            CHECK_LT(relative_error(
+                         expected, run(vocoder, input_signal, input_carrier),
+                         start),
+                     5e-2);
+            pwv::BasicVocoderRT<pwv::Q31Policy> q31(20, num_bands,
+                                                    sampling_rate);
+            CHECK_LT(relative_error(expected,
+                                    run(q31, input_signal, input_carrier),
+                                    start),
+                     pwv::Q31Policy::k_vocoder_error);
+            pwv::BasicVocoderRT<pwv::Q31Int16Policy> int16(20, num_bands,
+                                                            sampling_rate);
+            CHECK_LT(relative_error(expected,
+                                    run(int16, input_signal, input_carrier),
+                                    start),
+                     pwv::Q31Int16Policy::k_vocoder_error);
+        }
+    }
+}
+
+MAKE_TEST(VocoderRT_fixed_point_kernels) {
+    KernelsScope const scope;
+    std::size_t const sampling_rate = 16000;
+    std::size_t const num_samples = 3001;
+    std::vector<float> input_signal(num_samples);
+    std::vector<float> input_carrier(num_samples);
+    make_inputs(input_signal, input_carrier, sampling_rate);
+    std::vector<int16_t> signal(num_samples);
+    std::vector<int16_t> carrier(num_samples);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        signal[i] = pwv::Q31Int16Policy::from_float(input_signal[i]);
+        carrier[i] = pwv::Q31Int16Policy::from_float(input_carrier[i]);
+    }
+
+    // Integer sums don't depend on the order, so every variant agrees
+    // exactly.
+    std::vector<int16_t> expected;
+    for (auto const* variant : pwv::available_kernels()) {
+        CHECK_EQ(pwv::select_kernels(variant->name), true);
+        pwv::BasicVocoderRT<pwv::Q31Int16Policy> vocoder(20, 20,
+                                                         sampling_rate);
+        std::vector<int16_t> output(num_samples);
+        vocoder.process_samples(signal.data(), carrier.data(), num_samples,
+                                output.data());
+        if (expected.empty()) {
+            expected = output;
+        }
+        for (std::size_t i = 0; i < num_samples; i++) {
+            CHECK_EQ(output[i], expected[i]);
+        }
+    }
+
+    // And each does what FixedPolicy does, for a single band.
+    using Q31 = pwv::Q31Policy;
+    auto const bandpass = pwv::BandPass::coefs<Q31>(sampling_rate, 440, 5);
+    auto const lowpass = pwv::LowPass::coefs<Q31>(sampling_rate, 20);
+    struct Bank {
+        std::vector<int32_t> a1, a2, b0, b1, b2, x1, x2, y1, y2, error;
+        Bank(Q31::Coefs const& coefs)
+            : a1(pwv::k_max_lanes), a2(pwv::k_max_lanes),
+              b0(pwv::k_max_lanes), b1(pwv::k_max_lanes),
+              b2(pwv::k_max_lanes), x1(pwv::k_max_lanes),
+              x2(pwv::k_max_lanes), y1(pwv::k_max_lanes),
+              y2(pwv::k_max_lanes), error(pwv::k_max_lanes) {
+            a1[0] = coefs.a1;
+            a2[0] = coefs.a2;
+            b0[0] = coefs.b0;
+            b1[0] = coefs.b1;
+            b2[0] = coefs.b2;
+        }
+        pwv::FixedPointBankRefs refs() {
+            return {a1.data(), a2.data(), b0.data(), b1.data(), b2.data(),
+                    x1.data(), x2.data(), y1.data(), y2.data(),
+                    error.data(), pwv::k_max_lanes};
+        }
+    };
+    // One filter, a sample at a time.
+    struct Filter {
+        Q31::Coefs coefs;
+        int32_t x1 = 0, x2 = 0, y1 = 0, y2 = 0, error = 0;
+        int32_t operator()(int32_t x) {
+            int32_t const y = Q31::biquad(coefs, x, x1, x2, y1, y2, error);
+            x2 = x1;
+            x1 = x;
+            y2 = y1;
+            y1 = y;
+            return y;
+        }
+    };
+    std::vector<int32_t> signal_state(num_samples);
+    std::vector<int32_t> carrier_state(num_samples);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        // Loud enough to saturate.
+        signal_state[i] = Q31::from_sample(Q31::from_float(input_signal[i])) * 40;
+        carrier_state[i] = Q31::from_sample(Q31::from_float(input_carrier[i]));
+    }
+    Filter signal_bandpass{bandpass}, carrier_bandpass{bandpass},
+        envelope_lowpass{lowpass}, output_bandpass{bandpass};
+    std::vector<int64_t> scalar(num_samples);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        int32_t const envelope =
+            envelope_lowpass(Q31::abs(signal_bandpass(signal_state[i])));
+        scalar[i] = output_bandpass(
+            Q31::mul(envelope, carrier_bandpass(carrier_state[i])));
+    }
+    for (auto const* variant : pwv::available_kernels()) {
+        Bank signal_bank(bandpass), carrier_bank(bandpass),
+            envelope_bank(lowpass), output_bank(bandpass);
+        pwv::FixedPointVocoderBankRefs const banks{
+            signal_bank.refs(), carrier_bank.refs(), envelope_bank.refs(),
+            output_bank.refs()};
+        std::vector<int64_t> output(num_samples);
+        variant->vocoder_fixed_point(banks, signal_state.data(),
+                                     carrier_state.data(), output.data(),
+                                     num_samples);
+        for (std::size_t i = 0; i < num_samples; i++) {
+            CHECK_EQ(output[i], scalar[i]);
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include "tests.h"
+
+#include <SegmentedVocoder.h>
+#include <Utils.h>
+#include <Vocoder.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace {
+
+// Runs |vocoder| over the whole input as its cmdline does.
+std::vector<float> render(pwv::SegmentedVocoder& vocoder,
+                          std::span<float const> signal,
+                          std::span<float const> carrier) {
+    std::vector<float> output(signal.size());
+    vocoder.start();
+    for (std::size_t start = 0; start < signal.size();
+         start += vocoder.max_count()) {
+        std::size_t const count =
+            std::min(signal.size() - start, vocoder.max_count());
+        vocoder.process(signal.subspan(start, count),
+                        carrier.subspan(start, count),
+                        std::span{output}.subspan(start, count));
+    }
+    return output;
+}
+
+}  // namespace
+
+MAKE_TEST(SegmentedVocoder_matches_serial) {
+    std::size_t const sampling_rate = 8000;
+    int const num_bands = 10;
+    std::size_t const segment_size = 2 * pwv::Vocoder::k_chunk_size;
+    // Several calls' worth, ending part way through a segment.
+    std::size_t const num_samples = 7 * segment_size + 1234;
+
+    // Generate some data.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 220, 0.3);
+    pwv::add_sine(input_signal, sampling_rate, 1130, 0.2);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 110, 0.3);
+    pwv::add_sine(input_carrier, sampling_rate, 2470, 0.2);
+
+    auto const expected = pwv::Vocoder(20, num_bands, sampling_rate)
+                              .process(input_signal, input_carrier);
+
+    for (std::size_t num_threads : {1, 3}) {
+        pwv::SegmentedVocoder vocoder(20, num_bands, sampling_rate,
+                                      num_threads, segment_size);
+        CHECK_GT(vocoder.pre_roll(), 0u);
+        CHECK_LT(vocoder.pre_roll(), segment_size);
+        auto const output = render(vocoder, input_signal, input_carrier);
+
+        // The seams are close enough to be inaudible.
+        double error = 0;
+        double energy = 0;
+        for (std::size_t i = 0; i < num_samples; i++) {
+            double const diff = output[i] - expected[i];
+            error += diff * diff;
+            energy += expected[i] * expected[i];
+        }
+        CHECK_GT(energy, 0.0);
+        CHECK_LT(std::sqrt(error / energy), 1e-3);
+        if (num_threads == 1) {
+            CHECK_EQ(error, 0.0);
+        }
+    }
+}
+
+MAKE_TEST(SegmentedVocoder_default_config) {
+    // The envelope followers are lowest here, where rounding can leave one
+    // that never settles and so no pre-roll that's long enough.
+    for (double sampling_rate : {44100.0, 48000.0}) {
+        for (int num_bands : {40, 80}) {
+            std::size_t const pre_roll =
+                pwv::Vocoder(20, num_bands, sampling_rate)
+                    .pre_roll(pwv::SegmentedVocoder::k_settle_level);
+            CHECK_LT(pre_roll, std::numeric_limits<std::size_t>::max());
+            CHECK_LT(pre_roll, std::size_t{1} << 20);
+        }
+    }
+
+    // Segments longer than the pre-roll match the serial render.
+    std::size_t const sampling_rate = 44100;
+    int const num_bands = 40;
+    std::size_t const segment_size = 20 * pwv::Vocoder::k_chunk_size;
+    std::size_t const num_samples = 2 * segment_size + 1234;
+
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 220, 0.3);
+    pwv::add_sine(input_signal, sampling_rate, 1130, 0.2);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 110, 0.3);
+    pwv::add_sine(input_carrier, sampling_rate, 2470, 0.2);
+
+    auto const expected = pwv::Vocoder(20, num_bands, sampling_rate)
+                              .process(input_signal, input_carrier);
+    pwv::SegmentedVocoder vocoder(20, num_bands, sampling_rate, 2,
+                                  segment_size);
+    CHECK_LT(vocoder.pre_roll(), segment_size);
+    auto const output = render(vocoder, input_signal, input_carrier);
+
+    // Past the pre-roll, what's left of the second segment's empty start is
+    // under the settle level. But the filters round differently from one
+    // chunk alignment to the next, and the lowest envelope followers, with
+    // their poles closest to 1, carry that for good. That floor is about
+    // 1e-3 of the output here whatever the settle level, and moves with the
+    // optimisation level, so measure it: the serial render again, behind
+    // pre_roll() samples of silence.
+    std::size_t const pre_roll = vocoder.pre_roll();
+    std::vector<float> shifted_signal(pre_roll);
+    shifted_signal.insert(shifted_signal.end(), input_signal.begin(),
+                          input_signal.end());
+    std::vector<float> shifted_carrier(pre_roll);
+    shifted_carrier.insert(shifted_carrier.end(), input_carrier.begin(),
+                           input_carrier.end());
+    auto const shifted = pwv::Vocoder(20, num_bands, sampling_rate)
+                             .process(shifted_signal, shifted_carrier);
+
+    double error = 0;
+    double floor = 0;
+    double energy = 0;
+    for (std::size_t i = 0; i < num_samples; i++) {
+        double const diff = output[i] - expected[i];
+        double const shifted_diff = shifted[pre_roll + i] - expected[i];
+        error += diff * diff;
+        floor += shifted_diff * shifted_diff;
+        energy += expected[i] * expected[i];
+    }
+    CHECK_GT(energy, 0.0);
+    // The seam adds no more than the settle level on top of that floor.
+    double const rounding = std::sqrt(floor / energy);
+    CHECK_LT(rounding, 1e-2);
+    CHECK_LT(std::sqrt(error / energy),
+             rounding + pwv::SegmentedVocoder::k_settle_level);
+}
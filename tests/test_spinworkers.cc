@@ -0,0 +1,24 @@
+#include "tests.h"
+
+#include <SpinWorkers.h>
+#include <atomic>
+#include <vector>
+
+MAKE_TEST(SpinWorkers_run) {
+    for (std::size_t num_threads : {1, 4}) {
+        pwv::SpinWorkers workers(num_threads);
+        CHECK_EQ(workers.num_threads(), num_threads);
+        // Whether or not it gets to pin them, the helpers still run.
+        workers.bind_to_current_thread();
+
+        // Run a few times to check that the helpers pick up each one.
+        for (int run = 0; run < 100; run++) {
+            std::vector<std::atomic<int>> calls(num_threads);
+            auto task = [&](std::size_t worker) { calls[worker]++; };
+            workers.run(task);
+            for (auto const& call : calls) {
+                CHECK_EQ(call.load(), 1);
+            }
+        }
+    }
+}
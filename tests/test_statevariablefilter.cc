@@ -0,0 +1,201 @@
+#include "tests.h"
+
+#include <BandPass.h>
+#include <Kernels.h>
+#include <LowPass.h>
+#include <StateVariableBank.h>
+#include <StateVariableFilter.h>
+#include <Utils.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// Largest difference, relative to the largest of |expected|.
+float relative_error(std::vector<float> const& expected,
+                     std::vector<float> const& actual) {
+    float peak = 0;
+    float error = 0;
+    for (std::size_t i = 0; i < expected.size(); i++) {
+        peak = std::max(peak, std::abs(expected[i]));
+        error = std::max(error, std::abs(actual[i] - expected[i]));
+    }
+    return error / peak;
+}
+
+}  // namespace
+
+MAKE_TEST(StateVariableFilter_matches_biquad) {
+    std::size_t const sampling_rate = 48000;
+
+    std::vector<float> samples(sampling_rate / 2);
+    pwv::add_sine(samples, sampling_rate, 300, 0.5);
+    pwv::add_sine(samples, sampling_rate, 2000, 0.3);
+
+    using pwv::FilterTopology;
+    for (double hz : {200, 1000, 5000}) {
+        auto lowpass_biquad = samples;
+        auto lowpass_svf = samples;
+        pwv::LowPass(sampling_rate, hz).process(lowpass_biquad);
+        pwv::LowPass(sampling_rate, hz, FilterTopology::StateVariable)
+            .process(lowpass_svf);
+        CHECK_LT(relative_error(lowpass_biquad, lowpass_svf), 1e-3);
+
+        auto bandpass_biquad = samples;
+        auto bandpass_svf = samples;
+        pwv::BandPass(sampling_rate, hz, 5).process(bandpass_biquad);
+        pwv::BandPass(sampling_rate, hz, 5, FilterTopology::StateVariable)
+            .process(bandpass_svf);
+        CHECK_LT(relative_error(bandpass_biquad, bandpass_svf), 1e-3);
+    }
+}
+
+MAKE_TEST(StateVariableFilter_low_frequency) {
+    std::size_t const sampling_rate = 48000;
+    double const cutoff_hz = 2;
+
+    std::vector<float> samples(sampling_rate * 2);
+    pwv::add_sine(samples, sampling_rate, 1, 0.5);
+    pwv::add_sine(samples, sampling_rate, 50, 0.5);
+
+    // The same filter in doubles.
+    auto const params = pwv::StateVariableFilter::lowpass(sampling_rate,
+                                                          cutoff_hz);
+    double const g = std::tan(M_PI * cutoff_hz / sampling_rate);
+    double const k = params.k;
+    double const a1 = 1 / (1 + g * (g + k));
+    double const a2 = g * a1;
+    double const a3 = g * a2;
+    std::vector<float> expected = samples;
+    double ic1 = 0, ic2 = 0;
+    for (float& value : expected) {
+        double const v3 = value - ic2;
+        double const v1 = a1 * ic1 + a2 * v3;
+        double const v2 = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = 2 * v1 - ic1;
+        ic2 = 2 * v2 - ic2;
+        value = v2;
+    }
+
+    // Floats keep far closer to it than the biquad manages.
+    auto svf = samples;
+    auto biquad = samples;
+    pwv::LowPass(sampling_rate, cutoff_hz,
+                 pwv::FilterTopology::StateVariable)
+        .process(svf);
+    pwv::LowPass(sampling_rate, cutoff_hz).process(biquad);
+    float const svf_error = relative_error(expected, svf);
+    CHECK_LT(svf_error, 1e-3);
+    CHECK_LT(svf_error * 100, relative_error(expected, biquad));
+}
+
+MAKE_TEST(StateVariableFilter_ramp) {
+    std::size_t const sampling_rate = 48000;
+    std::size_t const num_samples = 20000;
+    std::size_t const ramp_start = 3000;
+    std::size_t const ramp_length = 4800;
+
+    std::vector<float> samples(num_samples);
+    pwv::add_sine(samples, sampling_rate, 440, 0.5);
+    auto const from = pwv::StateVariableFilter::bandpass(sampling_rate, 200, 4);
+    auto const to = pwv::StateVariableFilter::bandpass(sampling_rate, 2000, 8);
+
+    // A sample at a time, with the tuning interpolated.
+    pwv::StateVariableFilter expected_filter;
+    expected_filter.reset(from);
+    std::vector<float> expected = samples;
+    for (std::size_t i = 0; i < num_samples; i++) {
+        float const t = std::clamp(
+            (static_cast<float>(i) - ramp_start + 1) / ramp_length, 0.0f,
+            1.0f);
+        auto lerp = [t](float a, float b) { return a + (b - a) * t; };
+        if (i >= ramp_start) {
+            expected_filter.ramp_to({lerp(from.g, to.g), lerp(from.k, to.k),
+                                     lerp(from.m0, to.m0),
+                                     lerp(from.m1, to.m1),
+                                     lerp(from.m2, to.m2)},
+                                    0);
+        }
+        expected_filter.process(std::span{expected}.subspan(i, 1));
+    }
+
+    // In chunks that split the ramp.
+    pwv::StateVariableFilter filter;
+    filter.reset(from);
+    std::size_t const chunk_size = 37;
+    for (std::size_t start = 0; start < num_samples;) {
+        if (start == ramp_start) {
+            filter.ramp_to(to, ramp_length);
+            CHECK_EQ(filter.ramping(), true);
+        }
+        std::size_t end = std::min(start + chunk_size, num_samples);
+        if (start < ramp_start && ramp_start < end) {
+            end = ramp_start;
+        }
+        filter.process(std::span{samples}.subspan(start, end - start));
+        start = end;
+    }
+    CHECK_EQ(filter.ramping(), false);
+    CHECK_LT(relative_error(expected, samples), 1e-4);
+}
+
+MAKE_TEST(StateVariableBank_matches_filters) {
+    std::size_t const sampling_rate = 1000;
+    std::size_t const num_filters = 19;
+    std::size_t const block_size = pwv::StateVariableBank::k_block_size;
+    std::size_t const num_samples = block_size * 50;
+
+    std::vector<float> samples(num_samples);
+    pwv::add_sine(samples, sampling_rate, 60, 0.5);
+    pwv::add_sine(samples, sampling_rate, 220, 0.3);
+
+    // Mix of lowpass and bandpass filters, retuned half way.
+    auto params_for = [&](std::size_t index, double scale) {
+        double const hz = (20 + 20 * index) * scale;
+        return index % 2
+                   ? pwv::StateVariableFilter::bandpass(sampling_rate, hz, 2)
+                   : pwv::StateVariableFilter::lowpass(sampling_rate, hz);
+    };
+    std::size_t const retune_at = num_samples / 2;
+
+    std::vector<std::vector<float>> expected;
+    for (std::size_t index = 0; index < num_filters; index++) {
+        pwv::StateVariableFilter filter;
+        filter.reset(params_for(index, 1));
+        auto& output = expected.emplace_back(samples);
+        filter.process(std::span{output}.first(retune_at));
+        filter.ramp_to(params_for(index, 0.8), 0);
+        filter.process(std::span{output}.subspan(retune_at));
+    }
+
+    for (auto const* variant : pwv::available_kernels()) {
+        pwv::select_kernels(variant->name);
+        pwv::StateVariableBank bank(num_filters);
+        for (std::size_t index = 0; index < num_filters; index++) {
+            bank.reset(index, params_for(index, 1));
+        }
+        std::size_t const stride = bank.stride();
+        std::vector<float> block(block_size * stride);
+        for (std::size_t start = 0; start < num_samples; start += block_size) {
+            if (start == retune_at) {
+                for (std::size_t index = 0; index < num_filters; index++) {
+                    bank.set_params(index, params_for(index, 0.8));
+                }
+            }
+            bank.process_block(std::span{samples}.subspan(start, block_size),
+                               block);
+            for (std::size_t i = 0; i < block_size; i++) {
+                for (std::size_t index = 0; index < num_filters; index++) {
+                    APPROX_EQ(expected[index][start + i],
+                              block[i * stride + index]);
+                }
+                for (std::size_t index = num_filters; index < stride;
+                     index++) {
+                    CHECK_EQ(block[i * stride + index], 0);
+                }
+            }
+        }
+    }
+    pwv::select_kernels(pwv::available_kernels().front()->name);
+}
@@ -0,0 +1,28 @@
+#include "tests.h"
+
+#include <ThreadPool.h>
+#include <atomic>
+#include <vector>
+
+MAKE_TEST(ThreadPool_run) {
+    for (std::size_t num_threads : {1, 4}) {
+        pwv::ThreadPool pool(num_threads);
+        CHECK_EQ(pool.num_threads(), num_threads);
+
+        // Run a few times to check that the threads pick up each one.
+        for (std::size_t count : {0, 1, 100, 7}) {
+            std::vector<std::atomic<int>> calls(count);
+            std::atomic<bool> bad_worker = false;
+            pool.run(count, [&](std::size_t index, std::size_t worker) {
+                calls[index]++;
+                if (worker >= num_threads) {
+                    bad_worker = true;
+                }
+            });
+            for (auto const& call : calls) {
+                CHECK_EQ(call.load(), 1);
+            }
+            CHECK_EQ(bad_worker.load(), false);
+        }
+    }
+}
@@ -1,8 +1,14 @@
 #include "tests.h"
 
+#include <FixedVocoderRT.h>
+#include <Kernels.h>
 #include <Utils.h>
 #include <Vocoder.h>
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <random>
+#include <span>
 #include <vector>
 
 MAKE_TEST(Vocoder_ctor) {
@@ -56,3 +62,493 @@ MAKE_TEST(Vocoder_process_chunk) {
         APPROX_EQ(output_all[i], output_chunk_rt[i]);
     }
 }
+
+MAKE_TEST(VocoderRT_any_count) {
+    std::size_t const sampling_rate = 100;
+    std::size_t const hz = 10;
+    std::size_t const num_samples = pwv::VocoderRT::k_block_size * 200;
+
+    // Generate some data.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, hz * 3.2, 0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, hz * 2.7, 0.5);
+
+    auto const expected = pwv::Vocoder(20, 40, sampling_rate)
+                              .process(input_signal, input_carrier);
+
+    // Chunks of any size, including none, as a host might hand over.
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<std::size_t> chunk_size(0, 100);
+    for (int mode = 0; mode < 3; mode++) {
+        pwv::VocoderRT vocoder(20, 40, sampling_rate);
+        vocoder.set_fused(mode != 1);
+        vocoder.set_num_threads(mode == 2 ? 3 : 1);
+        CHECK_EQ(vocoder.block_size(), 1u);
+
+        std::vector<float> output(num_samples);
+        for (std::size_t start = 0; start < num_samples;) {
+            std::size_t const count =
+                std::min(num_samples - start, chunk_size(random));
+            vocoder.process(input_signal.data() + start,
+                            input_carrier.data() + start, count,
+                            output.data() + start);
+            start += count;
+        }
+        for (std::size_t i = 0; i < num_samples; i++) {
+            APPROX_EQ(output[i], expected[i]);
+        }
+    }
+}
+
+MAKE_TEST(Vocoder_fused_matches_staged) {
+    std::size_t const sampling_rate = 100;
+    std::size_t const hz = 10;
+    std::size_t const num_samples = pwv::VocoderRT::k_block_size * 37;
+
+    // Generate some data.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, hz * 3.2, 0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, hz * 2.7, 0.5);
+
+    for (int num_bands : {5, 40, 80}) {
+        pwv::VocoderRT staged(20, num_bands, sampling_rate);
+        staged.set_fused(false);
+        std::vector<float> output_staged(num_samples);
+        staged.process(input_signal.data(), input_carrier.data(), num_samples,
+                       output_staged.data());
+
+        pwv::VocoderRT fused(20, num_bands, sampling_rate);
+        std::vector<float> output_fused(num_samples);
+        fused.process(input_signal.data(), input_carrier.data(), num_samples,
+                      output_fused.data());
+
+        for (std::size_t i = 0; i < num_samples; i++) {
+            APPROX_EQ(output_staged[i], output_fused[i]);
+        }
+    }
+}
+
+MAKE_TEST(Vocoder_envelope_step) {
+    // Low enough that the envelopes are still accurate in float when they
+    // run every sample.
+    std::size_t const sampling_rate = 8000;
+    std::size_t const num_samples = pwv::VocoderRT::k_block_size * 4096;
+
+    // Generate some data, with the signal fading in and out.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 220, 0.3);
+    pwv::add_sine(input_signal, sampling_rate, 1500, 0.2);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        double const phase = 2 * M_PI * 3 * i / sampling_rate;
+        input_signal[i] *= 0.6 + 0.4 * std::sin(phase);
+    }
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 130, 0.3);
+    pwv::add_sine(input_carrier, sampling_rate, 2500, 0.2);
+
+    std::vector<float> expected(num_samples);
+    pwv::VocoderRT(20, 40, sampling_rate)
+        .process(input_signal.data(), input_carrier.data(), num_samples,
+                 expected.data());
+
+    // Also in chunks that cut steps short.
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<std::size_t> chunk_size(1, 300);
+    for (std::size_t step : {2, 4, 8, 16}) {
+        for (bool chunked : {false, true}) {
+            pwv::VocoderRT vocoder(20, 40, sampling_rate);
+            vocoder.set_envelope_step(step);
+            std::vector<float> output(num_samples);
+            for (std::size_t start = 0; start < num_samples;) {
+                std::size_t const count =
+                    chunked ? std::min(num_samples - start, chunk_size(random))
+                            : num_samples;
+                vocoder.process(input_signal.data() + start,
+                                input_carrier.data() + start, count,
+                                output.data() + start);
+                start += count;
+            }
+
+            // Close to running the envelopes every sample.
+            double error = 0;
+            double energy = 0;
+            for (std::size_t i = num_samples / 2; i < num_samples; i++) {
+                double const diff = output[i] - expected[i];
+                error += diff * diff;
+                energy += expected[i] * expected[i];
+            }
+            CHECK_LT(std::sqrt(error / energy), 0.02);
+        }
+    }
+}
+
+MAKE_TEST(Vocoder_presets) {
+    std::size_t const sampling_rate = 100;
+    std::size_t const hz = 10;
+    std::size_t const num_samples = 256 * 8;
+
+    // Generate some data.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, hz * 3.2, 0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, hz * 2.7, 0.5);
+
+    for (auto const& preset : pwv::vocoder_presets()) {
+        int const num_bands = preset.max_bands - 3;
+
+        // Reference.
+        std::vector<float> output_rt(num_samples);
+        pwv::VocoderRT(20, num_bands, sampling_rate)
+            .process(input_signal.data(), input_carrier.data(), num_samples,
+                     output_rt.data());
+
+        // The factory should pick the preset.
+        auto vocoder = pwv::make_vocoder_rt(preset.block_size, 20, num_bands,
+                                            sampling_rate);
+        CHECK_EQ(vocoder != nullptr, true);
+        CHECK_EQ(vocoder->block_size(), 1u);
+
+        // Check that it matches, fed in calls that aren't whole blocks.
+        std::vector<float> output_preset(num_samples);
+        std::size_t const call_size = preset.block_size * 3 / 2 + 1;
+        for (std::size_t start = 0; start < num_samples; start += call_size) {
+            std::size_t const count = std::min(call_size, num_samples - start);
+            vocoder->process(input_signal.data() + start,
+                             input_carrier.data() + start, count,
+                             output_preset.data() + start);
+        }
+        for (std::size_t i = 0; i < num_samples; i++) {
+            APPROX_EQ(output_rt[i], output_preset[i]);
+        }
+    }
+
+    // Nothing when there isn't a preset, rather than something that doesn't
+    // run the block size asked for.
+    CHECK_EQ(pwv::make_vocoder_rt(16, 20, 200, sampling_rate) == nullptr, true);
+    CHECK_EQ(pwv::make_vocoder_rt(24, 20, 10, sampling_rate) == nullptr, true);
+}
+
+MAKE_TEST(Vocoder_threads_match_serial) {
+    std::size_t const sampling_rate = 44100;
+    // Not a whole number of chunks.
+    std::size_t const num_samples = 20000;
+
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 440, 0.5);
+    pwv::add_sine(input_signal, sampling_rate, 3000, 0.2);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 220, 0.5);
+    pwv::add_sine(input_carrier, sampling_rate, 5000, 0.2);
+
+    pwv::Vocoder vocoder(20, 40, sampling_rate);
+    auto const serial = vocoder.process(input_signal, input_carrier);
+    for (std::size_t num_threads : {2, 3, 8}) {
+        vocoder.set_num_threads(num_threads);
+        auto const parallel = vocoder.process(input_signal, input_carrier);
+        CHECK_EQ(parallel.size(), num_samples);
+        for (std::size_t i = 0; i < num_samples; i++) {
+            CHECK_EQ(parallel[i], serial[i]);
+        }
+    }
+}
+
+MAKE_TEST(VocoderRT_threads_match_serial) {
+    std::size_t const sampling_rate = 48000;
+    int const num_bands = 100;
+    // Quanta shorter and longer than a thread's chunk, and not a whole
+    // number of them.
+    std::size_t const num_samples = pwv::VocoderRT::k_block_size * 1000;
+
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 440, 0.5);
+    pwv::add_sine(input_signal, sampling_rate, 3000, 0.2);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 220, 0.5);
+    pwv::add_sine(input_carrier, sampling_rate, 5000, 0.2);
+
+    std::vector<float> serial(num_samples);
+    pwv::VocoderRT(20, num_bands, sampling_rate)
+        .process(input_signal.data(), input_carrier.data(), num_samples,
+                 serial.data());
+    for (std::size_t num_threads : {2, 3, 16}) {
+        for (std::size_t quantum : {256, 1200}) {
+            pwv::VocoderRT vocoder(20, num_bands, sampling_rate);
+            vocoder.set_num_threads(num_threads);
+            std::vector<float> parallel(num_samples);
+            for (std::size_t start = 0; start < num_samples;
+                 start += quantum) {
+                std::size_t const count =
+                    std::min(num_samples - start, quantum);
+                vocoder.process(input_signal.data() + start,
+                                input_carrier.data() + start, count,
+                                parallel.data() + start);
+            }
+
+            // Only the order the bands are summed in differs.
+            for (std::size_t i = 0; i < num_samples; i++) {
+                APPROX_EQ(parallel[i], serial[i]);
+            }
+        }
+    }
+}
+
+MAKE_TEST(VocoderRT_band_gate) {
+    std::size_t const sampling_rate = 48000;
+    int const num_bands = 100;
+    std::size_t const num_samples = 30000;
+
+    // Silence, and then a tone, against a carrier with little in most bands.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(std::span{input_signal}.subspan(num_samples / 3),
+                  sampling_rate, 440, 0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 220, 0.5);
+
+    for (auto const* variant : pwv::available_kernels()) {
+        pwv::select_kernels(variant->name);
+        std::vector<float> expected(num_samples);
+        pwv::VocoderRT ungated(20, num_bands, sampling_rate);
+        ungated.process(input_signal.data(), input_carrier.data(), num_samples,
+                        expected.data());
+        CHECK_EQ(ungated.skipped_fraction(), 0.0);
+
+        for (std::size_t num_threads : {1, 3}) {
+            pwv::VocoderRT vocoder(20, num_bands, sampling_rate);
+            vocoder.set_band_gate(1e-6);
+            vocoder.set_num_threads(num_threads);
+            std::vector<float> output(num_samples);
+            for (std::size_t start = 0; start < num_samples; start += 500) {
+                vocoder.process(input_signal.data() + start,
+                                input_carrier.data() + start, 500,
+                                output.data() + start);
+            }
+
+            // At least the silence is skipped, and the tone still comes
+            // through when it starts.
+            CHECK_GT(vocoder.skipped_fraction(), 0.3);
+            double error = 0;
+            for (std::size_t i = 0; i < num_samples; i++) {
+                error = std::max<double>(error,
+                                         std::abs(output[i] - expected[i]));
+            }
+            CHECK_LT(error, 5e-5);
+        }
+    }
+    pwv::select_kernels(pwv::available_kernels().front()->name);
+}
+
+MAKE_TEST(VocoderRT_silence) {
+    std::size_t const sampling_rate = 48000;
+    int const num_bands = 40;
+    std::size_t const num_samples = 96000;
+    std::size_t const chunk_size = 500;
+
+    // Silence, a tone, a long gap and the tone again.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(std::span{input_signal}.subspan(10000, 5000), sampling_rate,
+                  440, 0.5);
+    pwv::add_sine(std::span{input_signal}.subspan(80000), sampling_rate, 440,
+                  0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 220, 0.5);
+
+    std::vector<float> expected(num_samples);
+    pwv::VocoderRT ungated(20, num_bands, sampling_rate);
+    ungated.process(input_signal.data(), input_carrier.data(), num_samples,
+                    expected.data());
+
+    pwv::VocoderRT vocoder(20, num_bands, sampling_rate);
+    vocoder.set_silence_level(1e-4);
+    std::vector<float> output(num_samples);
+    for (std::size_t start = 0; start < num_samples; start += chunk_size) {
+        vocoder.process(input_signal.data() + start,
+                        input_carrier.data() + start, chunk_size,
+                        output.data() + start);
+    }
+
+    // Up to the gap, nothing has been skipped that wasn't already zero.
+    for (std::size_t i = 0; i < 15000; i++) {
+        CHECK_EQ(output[i], expected[i]);
+    }
+    // The end of the gap is silent, where the filters were still ringing.
+    for (std::size_t i = 70000; i < 80000; i++) {
+        CHECK_EQ(output[i], 0.0f);
+    }
+    CHECK_NE(expected[79999], 0.0f);
+    // And the tone picks up again where it starts, short of what was
+    // dropped under the level.
+    double error = 0;
+    for (std::size_t i = 15000; i < num_samples; i++) {
+        error = std::max<double>(error, std::abs(output[i] - expected[i]));
+    }
+    CHECK_LT(error, 1e-4);
+}
+
+MAKE_TEST(VocoderRT_retune) {
+    std::size_t const sampling_rate = 48000;
+    std::size_t const num_samples = 96000;
+    std::size_t const chunk_size = 500;
+    std::size_t const switch_at = 24000;
+
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 440, 0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 220, 0.5);
+
+    // Runs |vocoder| over the inputs, calling |retune| part way.
+    auto run = [&](pwv::VocoderRT& vocoder, auto const& retune) {
+        std::vector<float> output(num_samples);
+        for (std::size_t start = 0; start < num_samples; start += chunk_size) {
+            if (start == switch_at) {
+                retune();
+            }
+            vocoder.process(input_signal.data() + start,
+                            input_carrier.data() + start, chunk_size,
+                            output.data() + start);
+        }
+        return output;
+    };
+    auto const no_retune = [] {};
+
+    pwv::VocoderRT fixed(20, 40, sampling_rate);
+    auto const expected = run(fixed, no_retune);
+
+    // Retuning to the same settings changes nothing.
+    {
+        pwv::VocoderRT vocoder(20, 40, sampling_rate, 80);
+        auto const output =
+            run(vocoder, [&] { vocoder.retune(20, 40, sampling_rate); });
+        for (std::size_t i = 0; i < num_samples; i++) {
+            APPROX_EQ(output[i], expected[i]);
+        }
+    }
+
+    // Retuning from other settings ends up where those would have been, to
+    // within what rounding leaves of where the filters started, and without
+    // a step where it changes.
+    {
+        pwv::VocoderRT vocoder(10, 60, sampling_rate, 80);
+        auto const output =
+            run(vocoder, [&] { vocoder.retune(20, 40, sampling_rate); });
+        for (std::size_t i = num_samples - 1000; i < num_samples; i++) {
+            CHECK_LT(std::abs(output[i] - expected[i]), 5e-3);
+        }
+        float largest_step = 0;
+        for (std::size_t i = 1; i < num_samples; i++) {
+            largest_step =
+                std::max(largest_step, std::abs(output[i] - output[i - 1]));
+        }
+        float const switch_step =
+            std::abs(output[switch_at] - output[switch_at - 1]);
+        CHECK_LE(switch_step, largest_step);
+        CHECK_LT(switch_step, 0.1f);
+
+        // Nor a click, which shows up as a kink: setting the coefficients
+        // in one go leaves one of about 0.04, where the steady output's are
+        // under 1e-3.
+        float largest_kink = 0;
+        for (std::size_t i = switch_at; i < switch_at + 2000; i++) {
+            largest_kink =
+                std::max(largest_kink, std::abs(output[i] - 2 * output[i - 1] +
+                                                output[i - 2]));
+        }
+        CHECK_LT(largest_kink, 0.01f);
+    }
+
+    // Down to fewer groups of bands than threads.
+    {
+        pwv::VocoderRT serial(20, 80, sampling_rate, 80);
+        auto const serial_output =
+            run(serial, [&] { serial.retune(20, 8, sampling_rate); });
+        pwv::VocoderRT vocoder(20, 80, sampling_rate, 80);
+        vocoder.set_num_threads(3);
+        auto const output =
+            run(vocoder, [&] { vocoder.retune(20, 8, sampling_rate); });
+        for (std::size_t i = 0; i < num_samples; i++) {
+            CHECK_LT(std::abs(output[i] - serial_output[i]), 5e-5);
+        }
+    }
+}
+
+MAKE_TEST(VocoderRT_precise) {
+    std::size_t const sampling_rate = 96000;
+    int const num_bands = 160;
+    std::size_t const num_samples = 192000;
+    std::size_t const chunk_size = 500;
+
+    // Low tones, where the bands lose the most to rounding.
+    std::vector<float> input_signal(num_samples);
+    for (double hz : {22, 31, 45, 60}) {
+        pwv::add_sine(input_signal, sampling_rate, hz, 0.2);
+    }
+    pwv::add_sine(input_signal, sampling_rate, 1000, 0.2);
+    std::vector<float> input_carrier(num_samples);
+    for (double hz : {25, 33, 50, 1000}) {
+        pwv::add_sine(input_carrier, sampling_rate, hz, 0.2);
+    }
+
+    auto run = [&](double tolerance, bool fused) {
+        pwv::VocoderRT vocoder(20, num_bands, sampling_rate);
+        vocoder.set_fused(fused);
+        vocoder.set_precise_tolerance(tolerance);
+        std::vector<float> output(num_samples);
+        for (std::size_t start = 0; start < num_samples; start += chunk_size) {
+            vocoder.process(input_signal.data() + start,
+                            input_carrier.data() + start, chunk_size,
+                            output.data() + start);
+        }
+        return output;
+    };
+    // Every band in doubles, to measure against.
+    auto const expected = run(0, true);
+    auto error = [&](std::vector<float> const& output) {
+        double peak = 0;
+        double error = 0;
+        for (std::size_t i = num_samples / 2; i < num_samples; i++) {
+            peak = std::max<double>(peak, std::abs(expected[i]));
+            error = std::max<double>(error, std::abs(output[i] - expected[i]));
+        }
+        return error / peak;
+    };
+
+    double const rounded =
+        error(run(std::numeric_limits<double>::infinity(), true));
+    double const mixed = error(run(pwv::VocoderRT::k_precise_tolerance, true));
+    double const staged =
+        error(run(pwv::VocoderRT::k_precise_tolerance, false));
+    CHECK_LT(mixed * 10, rounded);
+    CHECK_LT(mixed, 1e-3);
+    CHECK_LT(staged, 1e-3);
+}
+
+MAKE_TEST(Vocoder_streaming) {
+    std::size_t const sampling_rate = 44100;
+    std::size_t const chunk_size = pwv::Vocoder::k_chunk_size;
+    std::size_t const num_samples = 3 * chunk_size + 100;
+
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 440, 0.5);
+    std::vector<float> input_carrier(num_samples);
+    pwv::add_sine(input_carrier, sampling_rate, 220, 0.5);
+
+    pwv::Vocoder vocoder(20, 20, sampling_rate);
+    auto const expected = vocoder.process(input_signal, input_carrier);
+
+    // Twice over, to check that start() resets everything.
+    for (int pass = 0; pass < 2; pass++) {
+        vocoder.start();
+        std::vector<float> output(chunk_size);
+        for (std::size_t start = 0; start < num_samples; start += chunk_size) {
+            std::size_t const count = std::min(num_samples - start, chunk_size);
+            vocoder.process_chunk(
+                std::span{input_signal}.subspan(start, count),
+                std::span{input_carrier}.subspan(start, count),
+                std::span{output}.first(count));
+            for (std::size_t i = 0; i < count; i++) {
+                CHECK_EQ(output[i], expected[start + i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#include "tests.h"
+
+#include <Utils.h>
+#include <VocoderLPC.h>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<float> noise(std::size_t count, unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> values(-0.5f, 0.5f);
+    std::vector<float> result(count);
+    for (float& value : result) {
+        value = values(random);
+    }
+    return result;
+}
+
+// Power of |data| at |hz|, from |start| on.
+double power_at(std::vector<float> const& data, std::size_t start,
+                double sampling_rate, double hz) {
+    std::complex<double> total;
+    for (std::size_t i = start; i < data.size(); i++) {
+        double const phase = -2 * M_PI * hz * i / sampling_rate;
+        total += std::polar<double>(data[i], phase);
+    }
+    return std::norm(total) / (data.size() - start);
+}
+
+}  // namespace
+
+MAKE_TEST(VocoderLPC_ctor) {
+    pwv::VocoderLPC vocoder(pwv::VocoderLPC::speech_order(44100));
+    CHECK_EQ(pwv::VocoderLPC::speech_order(44100), 48u);
+    CHECK_EQ(vocoder.latency(), 0u);
+}
+
+MAKE_TEST(VocoderLPC_process_chunk) {
+    std::size_t const num_samples = 10000;
+    auto const input_signal = noise(num_samples, 1);
+    auto const input_carrier = noise(num_samples, 2);
+
+    // Apply it in a single chunk.
+    std::vector<float> output_all(num_samples);
+    pwv::VocoderLPC(24).process(input_signal.data(), input_carrier.data(),
+                                num_samples, output_all.data());
+
+    // Apply it in chunks of any size.
+    std::mt19937 random(3);
+    std::uniform_int_distribution<std::size_t> chunk_sizes(1, 300);
+    pwv::VocoderLPC vocoder(24);
+    std::vector<float> output_chunk(num_samples);
+    for (std::size_t chunk_start = 0; chunk_start < num_samples;) {
+        std::size_t const chunk_size =
+            std::min(chunk_sizes(random), num_samples - chunk_start);
+        vocoder.process(input_signal.data() + chunk_start,
+                        input_carrier.data() + chunk_start, chunk_size,
+                        output_chunk.data() + chunk_start);
+        chunk_start += chunk_size;
+    }
+
+    for (std::size_t i = 0; i < num_samples; i++) {
+        APPROX_EQ(output_all[i], output_chunk[i]);
+    }
+}
+
+MAKE_TEST(VocoderLPC_same_inputs) {
+    // Whitening and then colouring with the same model should give the
+    // carrier back once the gain has ramped up.
+    std::size_t const num_samples = 8000;
+    std::vector<float> input(num_samples);
+    pwv::add_sine(input, 8000, 300, 0.3);
+    pwv::add_sine(input, 8000, 1100, 0.2);
+    auto const extra = noise(num_samples, 4);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        input[i] += 0.1f * extra[i];
+    }
+
+    std::vector<float> output(num_samples);
+    pwv::VocoderLPC(16).process(input.data(), input.data(), num_samples,
+                                output.data());
+    for (std::size_t i = 2 * pwv::VocoderLPC::k_hop_size; i < num_samples;
+         i++) {
+        CHECK_LT(std::abs(output[i] - input[i]), 1e-3);
+    }
+}
+
+MAKE_TEST(VocoderLPC_applies_envelope) {
+    double const sampling_rate = 16000;
+    std::size_t const num_samples = 16000;
+
+    // A tone in a little noise, imposed on white noise.
+    std::vector<float> input_signal(num_samples);
+    pwv::add_sine(input_signal, sampling_rate, 1000, 0.5);
+    auto const extra = noise(num_samples, 5);
+    for (std::size_t i = 0; i < num_samples; i++) {
+        input_signal[i] += 0.01f * extra[i];
+    }
+    auto const input_carrier = noise(num_samples, 6);
+
+    std::vector<float> output(num_samples);
+    pwv::VocoderLPC(16).process(input_signal.data(), input_carrier.data(),
+                                num_samples, output.data());
+
+    std::size_t const start = num_samples / 2;
+    double const peak = power_at(output, start, sampling_rate, 1000);
+    for (double hz : {300, 3000, 6000}) {
+        CHECK_GT(peak, 100 * power_at(output, start, sampling_rate, hz));
+    }
+}
@@ -0,0 +1,94 @@
+#include "tests.h"
+
+#include <Utils.h>
+#include <Vocoder.h>
+#include <VocoderSTFT.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+void make_inputs(std::vector<float>& signal, std::vector<float>& carrier,
+                 double sampling_rate) {
+    for (float hz : {110, 250, 700, 1500, 3200, 7000}) {
+        pwv::add_sine(signal, sampling_rate, hz, 0.1);
+    }
+    for (float hz : {55, 130, 440, 1200, 2500, 5000, 9000}) {
+        pwv::add_sine(carrier, sampling_rate, hz, 0.1);
+    }
+}
+
+double rms(std::vector<float> const& data, std::size_t start) {
+    double total = 0;
+    for (std::size_t i = start; i < data.size(); i++) {
+        total += data[i] * data[i];
+    }
+    return std::sqrt(total / (data.size() - start));
+}
+
+}  // namespace
+
+MAKE_TEST(VocoderSTFT_ctor) {
+    pwv::VocoderSTFT vocoder(20, 40, 44100);
+    CHECK_EQ(vocoder.latency(), vocoder.frame_size());
+    pwv::VocoderSTFT short_hop(20, 1, 44100, 256, 32);
+    CHECK_EQ(short_hop.hop_size(), 32u);
+}
+
+MAKE_TEST(VocoderSTFT_process_chunk) {
+    std::size_t const sampling_rate = 44100;
+    std::size_t const num_samples = 10000;
+
+    std::vector<float> input_signal(num_samples);
+    std::vector<float> input_carrier(num_samples);
+    make_inputs(input_signal, input_carrier, sampling_rate);
+
+    // Apply it in a single chunk.
+    std::vector<float> output_all(num_samples);
+    pwv::VocoderSTFT(20, 40, sampling_rate, 512, 128)
+        .process(input_signal.data(), input_carrier.data(), num_samples,
+                 output_all.data());
+
+    // Apply it in chunks of any size.
+    std::mt19937 random(1);
+    std::uniform_int_distribution<std::size_t> chunk_sizes(1, 300);
+    pwv::VocoderSTFT vocoder(20, 40, sampling_rate, 512, 128);
+    std::vector<float> output_chunk(num_samples);
+    for (std::size_t chunk_start = 0; chunk_start < num_samples;) {
+        std::size_t const chunk_size =
+            std::min(chunk_sizes(random), num_samples - chunk_start);
+        vocoder.process(input_signal.data() + chunk_start,
+                        input_carrier.data() + chunk_start, chunk_size,
+                        output_chunk.data() + chunk_start);
+        chunk_start += chunk_size;
+    }
+
+    for (std::size_t i = 0; i < num_samples; i++) {
+        CHECK_EQ(output_all[i], output_chunk[i]);
+    }
+}
+
+MAKE_TEST(VocoderSTFT_level_matches_rt) {
+    double const sampling_rate = 44100;
+    std::size_t const num_samples = 1 << 16;
+
+    std::vector<float> input_signal(num_samples);
+    std::vector<float> input_carrier(num_samples);
+    make_inputs(input_signal, input_carrier, sampling_rate);
+
+    std::vector<float> expected(num_samples);
+    pwv::VocoderRT(20, 40, sampling_rate)
+        .process(input_signal.data(), input_carrier.data(), num_samples,
+                 expected.data());
+    std::vector<float> output(num_samples);
+    pwv::VocoderSTFT(20, 40, sampling_rate)
+        .process(input_signal.data(), input_carrier.data(), num_samples,
+                 output.data());
+
+    // The bands aren't shaped the same, but the level should be close.
+    double const ratio =
+        rms(output, num_samples / 2) / rms(expected, num_samples / 2);
+    CHECK_GT(ratio, 0.5);
+    CHECK_LT(ratio, 2.0);
+}
@@ -0,0 +1,70 @@
+#include "tests.h"
+
+#include <Utils.h>
+#include <WAVFile.h>
+#include <cmath>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+MAKE_TEST(WAVFile_streaming) {
+    auto const path = std::filesystem::temp_directory_path() /
+                      "pwv_test_wavfile_streaming.wav";
+    std::vector<float> samples(1000);
+    pwv::add_sine(samples, 8000, 440, 0.5);
+
+    // Write it in uneven pieces.
+    {
+        auto writer = pwv::WAVWriter::create(path, 8000);
+        CHECK_EQ(writer.has_value(), true);
+        CHECK_EQ(writer->write_samples(std::span{samples}.first(300)), true);
+        CHECK_EQ(writer->write_samples(std::span{samples}.subspan(300)), true);
+        CHECK_EQ(writer->finish(), true);
+    }
+
+    // The whole thing should load with the sizes filled in.
+    auto const loaded = pwv::load_wav(path);
+    CHECK_EQ(loaded.has_value(), true);
+    CHECK_EQ(loaded->sampling_rate, 8000u);
+    CHECK_EQ(loaded->samples.size(), samples.size());
+
+    // And read back in pieces, past the end.
+    auto reader = pwv::WAVReader::open(path);
+    CHECK_EQ(reader.has_value(), true);
+    CHECK_EQ(reader->num_samples(), samples.size());
+    std::vector<float> chunk(700);
+    for (std::size_t start = 0; start < samples.size(); start += chunk.size()) {
+        auto const read = reader->read_samples(chunk);
+        CHECK_EQ(read.has_value(), true);
+        CHECK_EQ(*read, std::min(chunk.size(), samples.size() - start));
+        for (std::size_t i = 0; i < *read; i++) {
+            CHECK_EQ(chunk[i], loaded->samples[start + i]);
+            CHECK_LT(std::abs(chunk[i] - samples[start + i]), 1 / 16384.0f);
+        }
+    }
+    auto const past_end = reader->read_samples(chunk);
+    CHECK_EQ(past_end.has_value(), true);
+    CHECK_EQ(*past_end, 0u);
+
+    std::filesystem::remove(path);
+}
+
+MAKE_TEST(WAVFile_int16) {
+    auto const path =
+        std::filesystem::temp_directory_path() / "pwv_test_wavfile_int16.wav";
+    std::vector<float> samples(1000);
+    pwv::add_sine(samples, 8000, 440, 0.5);
+    CHECK_EQ(pwv::save_wav({8000, samples}, path), true);
+
+    // The same samples as load_wav(), before they're turned into floats.
+    auto const loaded = pwv::load_wav(path);
+    auto const raw = pwv::load_wav_int16(path);
+    CHECK_EQ(raw.has_value(), true);
+    CHECK_EQ(raw->sampling_rate, 8000u);
+    CHECK_EQ(raw->samples.size(), samples.size());
+    for (std::size_t i = 0; i < samples.size(); i++) {
+        CHECK_EQ(raw->samples[i] / 32768.0f, loaded->samples[i]);
+    }
+
+    std::filesystem::remove(path);
+}